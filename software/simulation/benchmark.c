@@ -0,0 +1,497 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * benchmark.c: Throughput and latency benchmark for low-level read/write streaming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Every scenario runs on a fresh simulation and prints one JSON object per
+ * line, so results can be collected and compared between firmware versions:
+ *
+ * write          Host streams write_low_level with one request in flight,
+ *                like the bindings do. The sustained rate is the line rate,
+ *                the payload rate includes filling the TX buffer.
+ * read_callback  Peer saturates the line, data is delivered through the
+ *                read low level callback.
+ * read_polling   Peer saturates the line, host polls read_low_level with one
+ *                request in flight.
+ *
+ * The read scenarios also run a latency phase with the peer sending 32 byte
+ * bursts at 25% of the line rate. Latency is measured from the end of the
+ * stop bit of a byte to the SPITFP message that carries it to the Brick.
+ *
+ * isr            Cost of single RX/TX interrupt handler calls per flow
+ *                control mode: the RX handler drains a burst at the FIFO
+ *                trigger level (17) or a full FIFO (32), the TX handler
+ *                refills an empty TX FIFO. The median of many calls is
+ *                reported, the cost of a call is counted per executed
+ *                basic block (see sim_execute()) and only varies with the
+ *                code path. The same measurement is done for
+ *                write_low_level and read_low_level moving one full 60
+ *                byte chunk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "sim.h"
+#include "xmc_usic.h"
+
+#include "communication.h"
+#include "configs/config.h"
+#include "rs232.h"
+
+#define BENCHMARK_SETTLE_NS (10 * 1000000ULL)
+#define BENCHMARK_BURST_LENGTH 32
+#define BENCHMARK_LATENCY_LOAD_PERCENT 25
+#define BENCHMARK_READ_LENGTH 0xFFFF
+#define BENCHMARK_ISR_REPETITIONS 2001
+#define BENCHMARK_ISR_WARMUP 200
+
+typedef enum {
+	SCENARIO_WRITE = 0,
+	SCENARIO_READ_CALLBACK,
+	SCENARIO_READ_POLLING
+} Scenario;
+
+static const char *scenario_names[] = {"write", "read_callback", "read_polling"};
+
+// Interrupt handlers of rs232.c.
+void IRQ_Hdlr_11(void);
+void IRQ_Hdlr_12(void);
+
+typedef struct {
+	Scenario scenario;
+	uint64_t requests;
+	uint64_t responses;
+	uint64_t callbacks;
+	uint64_t payload_bytes;
+	bool request_in_flight;
+
+	// Arrival time of every byte received by the bricklet, in order.
+	uint64_t *arrival_ns;
+	uint64_t arrival_count;
+	uint64_t arrival_size;
+
+	// Latency of every byte delivered to the Brick.
+	uint64_t *latency_ns;
+	uint64_t latency_count;
+} Benchmark;
+
+static Benchmark bm;
+
+static void line_rx_hook(const uint8_t byte, const uint64_t now_ns, void *context) {
+	if(bm.arrival_count < bm.arrival_size) {
+		bm.arrival_ns[bm.arrival_count] = now_ns;
+	}
+	bm.arrival_count++;
+}
+
+static void delivered(const uint16_t count, const uint64_t now_ns) {
+	for(uint16_t i = 0; i < count; i++) {
+		if(bm.latency_count < bm.arrival_count && bm.latency_count < bm.arrival_size) {
+			bm.latency_ns[bm.latency_count] = now_ns - bm.arrival_ns[bm.latency_count];
+		}
+		bm.latency_count++;
+	}
+	bm.payload_bytes += count;
+}
+
+static uint16_t chunk_length(const uint16_t message_length, const uint16_t message_chunk_offset) {
+	if(message_length <= message_chunk_offset) {
+		return 0;
+	}
+
+	const uint16_t left = message_length - message_chunk_offset;
+	return left < sizeof(((ReadLowLevel_Response*)0)->message_chunk_data) ? left : sizeof(((ReadLowLevel_Response*)0)->message_chunk_data);
+}
+
+static void spitfp_hook(const uint8_t *data, const uint8_t length, const uint64_t now_ns, void *context) {
+	const TFPMessageHeader *header = (const TFPMessageHeader*)data;
+
+	switch(header->fid) {
+		case FID_CALLBACK_READ_LOW_LEVEL: {
+			const ReadLowLevel_Callback *cb = (const ReadLowLevel_Callback*)data;
+			bm.callbacks++;
+			delivered(chunk_length(cb->message_length, cb->message_chunk_offset), now_ns);
+			break;
+		}
+
+		case FID_READ_LOW_LEVEL: {
+			const ReadLowLevel_Response *response = (const ReadLowLevel_Response*)data;
+			bm.responses++;
+			bm.request_in_flight = false;
+			delivered(chunk_length(response->message_length, response->message_chunk_offset), now_ns);
+			break;
+		}
+
+		case FID_WRITE_LOW_LEVEL: {
+			bm.responses++;
+			bm.request_in_flight = false;
+			bm.payload_bytes += ((const WriteLowLevel_Response*)data)->message_chunk_written;
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+static void request_read(void) {
+	ReadLowLevel request;
+	sim_make_header(&request.header, sizeof(request), FID_READ_LOW_LEVEL, true);
+	request.length = BENCHMARK_READ_LENGTH;
+
+	bm.request_in_flight = sim_host_request(&request, sizeof(request));
+	bm.requests++;
+}
+
+static int compare_u64(const void *a, const void *b) {
+	const uint64_t x = *(const uint64_t*)a;
+	const uint64_t y = *(const uint64_t*)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double percentile_us(const uint64_t *sorted, const uint64_t count, const uint32_t percent) {
+	if(count == 0) {
+		return 0.0;
+	}
+
+	uint64_t index = (count * percent + 99) / 100;
+	if(index > 0) {
+		index--;
+	}
+
+	return sorted[index] / 1000.0;
+}
+
+static void setup(const SimConfig *config, const Scenario scenario, const uint32_t baudrate, const uint32_t duration_ms) {
+	free(bm.arrival_ns);
+	free(bm.latency_ns);
+	memset(&bm, 0, sizeof(Benchmark));
+
+	bm.scenario = scenario;
+	bm.arrival_size = (uint64_t)baudrate / 7 * (duration_ms + 100) / 1000 + 1024;
+	bm.arrival_ns = calloc(bm.arrival_size, sizeof(uint64_t));
+	bm.latency_ns = calloc(bm.arrival_size, sizeof(uint64_t));
+
+	sim_init(config);
+	sim_set_spitfp_hook(spitfp_hook, NULL);
+
+	sim_request_configuration(baudrate, RS232_V2_FLOWCONTROL_OFF);
+	if(scenario == SCENARIO_READ_CALLBACK) {
+		sim_request_enable_read_callback();
+	}
+
+	sim_run_for(BENCHMARK_SETTLE_NS);
+
+	sim_reset_stats();
+	sim_set_line_rx_hook(line_rx_hook, NULL);
+	bm.requests = 0;
+	bm.responses = 0;
+	bm.callbacks = 0;
+	bm.payload_bytes = 0;
+}
+
+static void run(const uint32_t duration_ms, const uint32_t load_percent) {
+	static uint8_t burst[BENCHMARK_BURST_LENGTH];
+	static uint8_t chunk[60];
+	memset(burst, 'r', sizeof(burst));
+	memset(chunk, 'x', sizeof(chunk));
+
+	const uint64_t start_ns = sim_now_ns();
+	const uint64_t end_ns = start_ns + duration_ms * 1000000ULL;
+	const uint64_t burst_period_ns = sim_byte_ns() * BENCHMARK_BURST_LENGTH * 100 / load_percent;
+	uint64_t next_burst_ns = start_ns;
+
+	while(sim_now_ns() < end_ns) {
+		if(bm.scenario != SCENARIO_WRITE) {
+			if(load_percent >= 100) {
+				if(sim_peer_send_pending() < BENCHMARK_BURST_LENGTH) {
+					sim_peer_send(burst, sizeof(burst));
+				}
+			} else if(sim_now_ns() >= next_burst_ns) {
+				sim_peer_send(burst, sizeof(burst));
+				next_burst_ns += burst_period_ns;
+			}
+		}
+
+		if(!bm.request_in_flight) {
+			if(bm.scenario == SCENARIO_WRITE) {
+				bm.request_in_flight = sim_request_write(chunk, sizeof(chunk));
+				bm.requests++;
+			} else if(bm.scenario == SCENARIO_READ_POLLING) {
+				request_read();
+			}
+		}
+
+		sim_main_loop_iteration();
+	}
+}
+
+static void report(FILE *out, const char *phase, const uint32_t baudrate, const uint32_t duration_ms, const uint32_t load_percent) {
+	const SimStats *stats = sim_get_stats();
+	const double seconds = duration_ms / 1000.0;
+	const uint64_t line_bytes = bm.scenario == SCENARIO_WRITE ? stats->tx_line_bytes : stats->rx_line_bytes;
+	const uint64_t messages = bm.requests + bm.responses + bm.callbacks;
+	const uint32_t lost = stats->rx_fifo_overflows + rs232._error_count_overrun;
+
+	fprintf(out, "{\"benchmark\": \"%s\", \"phase\": \"%s\", \"firmware_version\": \"%d.%d.%d\", ",
+	        scenario_names[bm.scenario], phase, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR, FIRMWARE_VERSION_REVISION);
+	fprintf(out, "\"baudrate\": %u, \"duration_ms\": %u, \"load_percent\": %u, ", baudrate, duration_ms, load_percent);
+	fprintf(out, "\"line_capacity_bytes_per_s\": %.0f, ", 1000000000.0 / sim_byte_ns());
+	fprintf(out, "\"line_bytes_per_s\": %.0f, ", line_bytes / seconds);
+	fprintf(out, "\"sustained_bytes_per_s\": %.0f, ", (bm.scenario == SCENARIO_WRITE ? line_bytes : bm.payload_bytes) / seconds);
+	fprintf(out, "\"payload_bytes_per_s\": %.0f, ", bm.payload_bytes / seconds);
+	fprintf(out, "\"tfp_messages_per_kb\": %.2f, ", bm.payload_bytes ? messages * 1024.0 / bm.payload_bytes : 0.0);
+	fprintf(out, "\"requests\": %llu, \"responses\": %llu, \"callbacks\": %llu, ",
+	        (unsigned long long)bm.requests, (unsigned long long)bm.responses, (unsigned long long)bm.callbacks);
+	fprintf(out, "\"callback_tick_bound_bytes_per_s\": %u, ", (uint32_t)sizeof(((ReadLowLevel_Callback*)0)->message_chunk_data) * 1000 / COMMUNICATION_CALLBACK_TICK_WAIT_MS);
+	fprintf(out, "\"usic_rx_fifo_overflows\": %u, \"error_count_overrun\": %u, ", stats->rx_fifo_overflows, rs232._error_count_overrun);
+	fprintf(out, "\"rx_irq_cycles_avg\": %.1f, ", stats->rx_irq.calls ? (double)stats->rx_irq.cycles / stats->rx_irq.calls : 0.0);
+	fprintf(out, "\"tx_irq_cycles_avg\": %.1f, ", stats->tx_irq.calls ? (double)stats->tx_irq.cycles / stats->tx_irq.calls : 0.0);
+
+	// Latency is only meaningful if no byte was lost, otherwise the byte order mapping breaks.
+	uint64_t count = bm.latency_count < bm.arrival_size ? bm.latency_count : bm.arrival_size;
+	if(bm.scenario == SCENARIO_WRITE || lost > 0 || count == 0) {
+		fprintf(out, "\"latency_us\": null}\n");
+	} else {
+		qsort(bm.latency_ns, count, sizeof(uint64_t), compare_u64);
+		fprintf(out, "\"latency_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}}\n",
+		        percentile_us(bm.latency_ns, count, 50),
+		        percentile_us(bm.latency_ns, count, 90),
+		        percentile_us(bm.latency_ns, count, 99),
+		        bm.latency_ns[count - 1] / 1000.0);
+	}
+
+	fflush(out);
+}
+
+static uint32_t median(uint32_t *values, const uint32_t count) {
+	// Insertion sort is fast enough for the repetition count.
+	for(uint32_t i = 1; i < count; i++) {
+		const uint32_t value = values[i];
+		uint32_t j = i;
+		for(; j > 0 && values[j - 1] > value; j--) {
+			values[j] = values[j - 1];
+		}
+		values[j] = value;
+	}
+
+	return values[count / 2];
+}
+
+static void report_isr(FILE *out, const char *handler, const uint8_t flowcontrol, const uint8_t burst, uint32_t *cycles, const uint32_t accesses) {
+	const uint32_t cycles_median = median(cycles, BENCHMARK_ISR_REPETITIONS);
+
+	fprintf(out, "{\"benchmark\": \"isr\", \"handler\": \"%s\", \"firmware_version\": \"%d.%d.%d\", ",
+	        handler, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR, FIRMWARE_VERSION_REVISION);
+	fprintf(out, "\"flowcontrol\": %u, \"burst\": %u, \"cycles_median\": %u, \"cycles_per_byte\": %.1f, \"accesses\": %u}\n",
+	        flowcontrol, burst, cycles_median, (double)cycles_median / burst, accesses);
+	fflush(out);
+}
+
+static void benchmark_isr(FILE *out, const SimConfig *config) {
+	static uint32_t cycles[BENCHMARK_ISR_REPETITIONS];
+	uint8_t data[SIM_USIC_FIFO_SIZE];
+	uint32_t accesses = 0;
+
+	// Printable data, so that software flow control sees no XON/XOFF.
+	memset(data, 'r', sizeof(data));
+
+	for(uint8_t flowcontrol = RS232_V2_FLOWCONTROL_OFF; flowcontrol <= RS232_V2_FLOWCONTROL_HARDWARE; flowcontrol++) {
+		const uint8_t bursts[] = {17, SIM_USIC_FIFO_SIZE};
+		for(uint8_t b = 0; b < sizeof(bursts); b++) {
+			sim_init(config);
+			sim_request_configuration(CONFIG_BAUDRATE_MAX, flowcontrol);
+			sim_run_for(BENCHMARK_SETTLE_NS);
+
+			for(int32_t i = -BENCHMARK_ISR_WARMUP; i < BENCHMARK_ISR_REPETITIONS; i++) {
+				// Keep the ringbuffer empty but let the write position wander through the buffer.
+				rs232.rb_rx.start = rs232.rb_rx.end;
+				sim_usic_rx_push(data, bursts[b]);
+				const uint32_t c = sim_measure_cycles(IRQ_Hdlr_11, &accesses);
+				if(i >= 0) {
+					cycles[i] = c;
+				}
+			}
+
+			report_isr(out, "rx", flowcontrol, bursts[b], cycles, accesses);
+		}
+
+		sim_init(config);
+		sim_request_configuration(CONFIG_BAUDRATE_MAX, flowcontrol);
+		sim_run_for(BENCHMARK_SETTLE_NS);
+
+		for(int32_t i = -BENCHMARK_ISR_WARMUP; i < BENCHMARK_ISR_REPETITIONS; i++) {
+			while(ringbuffer_get_used(&rs232.rb_tx) < SIM_USIC_FIFO_SIZE) {
+				ringbuffer_add(&rs232.rb_tx, 't');
+			}
+			sim_usic_tx_clear();
+			const uint32_t c = sim_measure_cycles(IRQ_Hdlr_12, &accesses);
+			if(i >= 0) {
+				cycles[i] = c;
+			}
+		}
+
+		report_isr(out, "tx", flowcontrol, SIM_USIC_FIFO_SIZE, cycles, accesses);
+	}
+}
+
+static WriteLowLevel benchmark_write_request;
+static WriteLowLevel_Response benchmark_write_response;
+static ReadLowLevel benchmark_read_request;
+static ReadLowLevel_Response benchmark_read_response;
+
+static void benchmark_write_low_level(void) {
+	handle_message(&benchmark_write_request, &benchmark_write_response);
+}
+
+static void benchmark_read_low_level(void) {
+	handle_message(&benchmark_read_request, &benchmark_read_response);
+}
+
+// Cost of moving one full 60 byte chunk through the TFP low level handlers.
+static void benchmark_handlers(FILE *out, const SimConfig *config) {
+	static uint32_t cycles[BENCHMARK_ISR_REPETITIONS];
+	const uint8_t chunk = sizeof(benchmark_write_request.message_chunk_data);
+
+	sim_make_header(&benchmark_write_request.header, sizeof(benchmark_write_request), FID_WRITE_LOW_LEVEL, true);
+	benchmark_write_request.message_length = chunk;
+	benchmark_write_request.message_chunk_offset = 0;
+	memset(benchmark_write_request.message_chunk_data, 'w', chunk);
+
+	sim_make_header(&benchmark_read_request.header, sizeof(benchmark_read_request), FID_READ_LOW_LEVEL, true);
+	benchmark_read_request.length = chunk;
+
+	sim_init(config);
+	sim_request_configuration(CONFIG_BAUDRATE_MAX, RS232_V2_FLOWCONTROL_OFF);
+	sim_run_for(BENCHMARK_SETTLE_NS);
+
+	for(int32_t i = -BENCHMARK_ISR_WARMUP; i < BENCHMARK_ISR_REPETITIONS; i++) {
+		// Keep the ringbuffer empty but let the write position wander through the buffer.
+		rs232.rb_tx.start = rs232.rb_tx.end;
+		const uint32_t c = sim_measure_cycles(benchmark_write_low_level, NULL);
+		if(i >= 0) {
+			cycles[i] = c;
+		}
+	}
+
+	report_isr(out, "write_low_level", RS232_V2_FLOWCONTROL_OFF, chunk, cycles, 0);
+
+	for(int32_t i = -BENCHMARK_ISR_WARMUP; i < BENCHMARK_ISR_REPETITIONS; i++) {
+		rs232.rb_rx.start = rs232.rb_rx.end;
+		for(uint8_t j = 0; j < chunk; j++) {
+			ringbuffer_add(&rs232.rb_rx, 'r');
+		}
+		const uint32_t c = sim_measure_cycles(benchmark_read_low_level, NULL);
+		if(i >= 0) {
+			cycles[i] = c;
+		}
+	}
+
+	report_isr(out, "read_low_level", RS232_V2_FLOWCONTROL_OFF, chunk, cycles, 0);
+}
+
+static void usage(const char *name) {
+	printf("Usage: %s [options]\n"
+	       "  --baudrates A,B,...     baudrates to run (default 9600,115200,1000000,2000000)\n"
+	       "  --duration-ms N         virtual run time per phase (default 1000)\n"
+	       "  --isr-only              only run the interrupt handler cost scenario\n"
+	       "  --cpu-mhz N             virtual CPU clock (default 48)\n"
+	       "  --block-cycles N        cycles per executed basic block (default 8)\n"
+	       "  --spitfp-khz N          SPITFP clock (default 1400)\n"
+	       "  --output FILE           write JSON lines to FILE instead of stdout\n", name);
+}
+
+int main(int argc, char **argv) {
+	SimConfig config;
+	sim_config_default(&config);
+
+	uint32_t baudrates[16] = {9600, 115200, 1000000, 2000000};
+	uint32_t baudrate_count = 4;
+	uint32_t duration_ms = 1000;
+	FILE *out = stdout;
+	bool isr_only = false;
+
+	static const struct option options[] = {
+		{"baudrates",   required_argument, NULL, 'b'},
+		{"duration-ms", required_argument, NULL, 'd'},
+		{"isr-only",    no_argument,       NULL, 'i'},
+		{"cpu-mhz",     required_argument, NULL, 'c'},
+		{"block-cycles", required_argument, NULL, 's'},
+		{"spitfp-khz",  required_argument, NULL, 'k'},
+		{"output",      required_argument, NULL, 'o'},
+		{"help",        no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+		switch(opt) {
+			case 'b': {
+				baudrate_count = 0;
+				for(char *token = strtok(optarg, ","); token != NULL && baudrate_count < 16; token = strtok(NULL, ",")) {
+					baudrates[baudrate_count++] = strtoul(token, NULL, 0);
+				}
+				break;
+			}
+
+			case 'd': duration_ms = strtoul(optarg, NULL, 0); break;
+			case 'i': isr_only = true; break;
+			case 'c': config.cpu_hz = strtoul(optarg, NULL, 0) * 1000000; break;
+			case 's': config.block_cycles = strtoul(optarg, NULL, 0); break;
+			case 'k': config.spitfp_hz = strtoul(optarg, NULL, 0) * 1000; break;
+			case 'o':
+				out = fopen(optarg, "w");
+				if(out == NULL) {
+					perror(optarg);
+					return 1;
+				}
+				break;
+
+			default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	benchmark_isr(out, &config);
+	benchmark_handlers(out, &config);
+
+	for(uint32_t i = 0; i < baudrate_count && !isr_only; i++) {
+		for(Scenario scenario = SCENARIO_WRITE; scenario <= SCENARIO_READ_POLLING; scenario++) {
+			setup(&config, scenario, baudrates[i], duration_ms);
+			run(duration_ms, 100);
+			report(out, "throughput", baudrates[i], duration_ms, 100);
+
+			if(scenario != SCENARIO_WRITE) {
+				setup(&config, scenario, baudrates[i], duration_ms);
+				run(duration_ms, BENCHMARK_LATENCY_LOAD_PERCENT);
+				report(out, "latency", baudrates[i], duration_ms, BENCHMARK_LATENCY_LOAD_PERCENT);
+			}
+		}
+	}
+
+	if(out != stdout) {
+		fclose(out);
+	}
+
+	return 0;
+}
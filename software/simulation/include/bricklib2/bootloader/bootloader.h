@@ -0,0 +1,61 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * bootloader.h: Simulation stand-in for the bricklib2 bootloader interface
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef BOOTLOADER_H
+#define BOOTLOADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * On the bricklet these functions live in the bootloader and are called
+ * through a function table in flash. In the simulation they are provided
+ * by simulation/sim_bricklib2.c, which models the SPITFP link to the Brick.
+ */
+
+#define EEPROM_PAGE_SIZE 256
+
+typedef enum {
+	HANDLE_MESSAGE_RESPONSE_EMPTY,
+	HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE,
+	HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED,
+	HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER,
+	HANDLE_MESSAGE_RESPONSE_NONE
+} BootloaderHandleMessageResponse;
+
+typedef struct {
+	bool busy;
+} SPITFP;
+
+typedef struct {
+	SPITFP st;
+} BootloaderStatus;
+
+extern BootloaderStatus bootloader_status;
+
+void bootloader_tick(void);
+uint32_t bootloader_get_uid(void);
+bool bootloader_spitfp_is_send_possible(SPITFP *st);
+void bootloader_spitfp_send_ack_and_message(BootloaderStatus *bootloader_status, uint8_t *data, const uint8_t length);
+void bootloader_read_eeprom_page(const uint32_t page_num, uint32_t *data);
+bool bootloader_write_eeprom_page(const uint32_t page_num, uint32_t *data);
+
+#endif
@@ -0,0 +1,37 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * logging.h: Simulation stand-in for bricklib2 logging (disabled)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <stdio.h>
+#include <string.h>
+
+// Logging is disabled in the simulation, same as in the release firmware.
+#define logd(...) do {} while(0)
+#define logi(...) do {} while(0)
+#define logw(...) do {} while(0)
+#define loge(...) do {} while(0)
+#define logwohd(...) do {} while(0)
+#define uartbb_printf(...) do {} while(0)
+#define uartbb_puts(...) do {} while(0)
+
+#endif
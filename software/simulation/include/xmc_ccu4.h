@@ -0,0 +1,147 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_ccu4.h: Simulated XMC1 CCU4 timer driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_CCU4_H
+#define XMC_CCU4_H
+
+#include "xmc_common.h"
+
+// Only the period match event of an edge aligned timer is simulated.
+typedef struct {
+	bool running;
+	uint16_t period;
+	uint16_t period_shadow;
+	uint8_t prescaler;
+	uint32_t events;
+	uint8_t sr_period_match;
+	uint64_t next_period_match_ns;
+} XMC_CCU4_SLICE_t;
+
+typedef struct {
+	uint8_t dummy;
+} XMC_CCU4_MODULE_t;
+
+extern XMC_CCU4_MODULE_t sim_ccu40;
+extern XMC_CCU4_SLICE_t sim_ccu40_cc4[4];
+
+#define CCU40      (&sim_ccu40)
+#define CCU40_CC40 (&sim_ccu40_cc4[0])
+#define CCU40_CC41 (&sim_ccu40_cc4[1])
+#define CCU40_CC42 (&sim_ccu40_cc4[2])
+#define CCU40_CC43 (&sim_ccu40_cc4[3])
+
+typedef enum {
+	XMC_CCU4_SLICE_MCMS_ACTION_TRANSFER_PR_CR = 0
+} XMC_CCU4_SLICE_MCMS_ACTION_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_TIMER_COUNT_MODE_EA = 0,
+	XMC_CCU4_SLICE_TIMER_COUNT_MODE_CA
+} XMC_CCU4_SLICE_TIMER_COUNT_MODE_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_TIMER_REPEAT_MODE_REPEAT = 0,
+	XMC_CCU4_SLICE_TIMER_REPEAT_MODE_SINGLE
+} XMC_CCU4_SLICE_TIMER_REPEAT_MODE_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_PRESCALER_MODE_NORMAL = 0,
+	XMC_CCU4_SLICE_PRESCALER_MODE_FLOAT
+} XMC_CCU4_SLICE_PRESCALER_MODE_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_OUTPUT_PASSIVE_LEVEL_LOW = 0,
+	XMC_CCU4_SLICE_OUTPUT_PASSIVE_LEVEL_HIGH
+} XMC_CCU4_SLICE_OUTPUT_PASSIVE_LEVEL_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH = 0,
+	XMC_CCU4_SLICE_IRQ_ID_ONE_MATCH = 1
+} XMC_CCU4_SLICE_IRQ_ID_t;
+
+typedef enum {
+	XMC_CCU4_SLICE_SR_ID_0 = 0,
+	XMC_CCU4_SLICE_SR_ID_1,
+	XMC_CCU4_SLICE_SR_ID_2,
+	XMC_CCU4_SLICE_SR_ID_3
+} XMC_CCU4_SLICE_SR_ID_t;
+
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_0           (1 << 0)
+#define XMC_CCU4_SHADOW_TRANSFER_PRESCALER_SLICE_0 (1 << 2)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_1           (1 << 4)
+#define XMC_CCU4_SHADOW_TRANSFER_PRESCALER_SLICE_1 (1 << 6)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_2           (1 << 8)
+#define XMC_CCU4_SHADOW_TRANSFER_PRESCALER_SLICE_2 (1 << 10)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_3           (1 << 12)
+#define XMC_CCU4_SHADOW_TRANSFER_PRESCALER_SLICE_3 (1 << 14)
+
+typedef struct {
+	XMC_CCU4_SLICE_TIMER_COUNT_MODE_t timer_mode;
+	XMC_CCU4_SLICE_TIMER_REPEAT_MODE_t monoshot;
+	bool shadow_xfer_clear;
+	bool dither_timer_period;
+	bool dither_duty_cycle;
+	XMC_CCU4_SLICE_PRESCALER_MODE_t prescaler_mode;
+	bool mcm_enable;
+	uint8_t prescaler_initval;
+	uint8_t float_limit;
+	uint8_t dither_limit;
+	XMC_CCU4_SLICE_OUTPUT_PASSIVE_LEVEL_t passive_level;
+	bool timer_concatenation;
+} XMC_CCU4_SLICE_COMPARE_CONFIG_t;
+
+void XMC_CCU4_Init(XMC_CCU4_MODULE_t *const module, const XMC_CCU4_SLICE_MCMS_ACTION_t mcs_action);
+void XMC_CCU4_StartPrescaler(XMC_CCU4_MODULE_t *const module);
+void XMC_CCU4_EnableClock(XMC_CCU4_MODULE_t *const module, const uint8_t slice_number);
+void XMC_CCU4_EnableShadowTransfer(XMC_CCU4_MODULE_t *const module, const uint32_t shadow_transfer_msk);
+void XMC_CCU4_SLICE_CompareInit(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_COMPARE_CONFIG_t *const compare_init);
+void XMC_CCU4_SLICE_StartTimer(XMC_CCU4_SLICE_t *const slice);
+void XMC_CCU4_SLICE_StopTimer(XMC_CCU4_SLICE_t *const slice);
+void XMC_CCU4_SLICE_ClearTimer(XMC_CCU4_SLICE_t *const slice);
+
+__STATIC_INLINE void XMC_CCU4_SLICE_SetTimerPeriodMatch(XMC_CCU4_SLICE_t *const slice, const uint16_t period_val) {
+	slice->period_shadow = period_val;
+}
+
+__STATIC_INLINE void XMC_CCU4_SLICE_EnableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+	slice->events |= (1 << event);
+}
+
+__STATIC_INLINE void XMC_CCU4_SLICE_DisableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+	slice->events &= ~(1 << event);
+}
+
+__STATIC_INLINE void XMC_CCU4_SLICE_ClearEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+	(void)slice;
+	(void)event;
+}
+
+__STATIC_INLINE void XMC_CCU4_SLICE_SetInterruptNodePointer(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event, const XMC_CCU4_SLICE_SR_ID_t sr) {
+	if(event == XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH) {
+		slice->sr_period_match = sr;
+	}
+}
+
+__STATIC_INLINE bool XMC_CCU4_SLICE_IsTimerRunning(const XMC_CCU4_SLICE_t *const slice) {
+	return slice->running;
+}
+
+#endif
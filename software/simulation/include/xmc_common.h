@@ -0,0 +1,63 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_common.h: Simulated CMSIS/XMC common definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_COMMON_H
+#define XMC_COMMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define __STATIC_INLINE static inline
+
+typedef int32_t IRQn_Type;
+
+// NVIC of the virtual Cortex-M0, implemented in simulation/sim.c.
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority);
+
+// SysTick and SCB of the virtual Cortex-M0. SysTick runs with a 1ms period
+// like the bricklib2 system timer, VAL is derived from the virtual time.
+typedef struct {
+	uint32_t CTRL;
+	uint32_t LOAD;
+	uint32_t VAL;
+	uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+	uint32_t CPUID;
+	uint32_t ICSR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Msk (1UL << 26)
+
+SysTick_Type *sim_systick(void);
+SCB_Type *sim_scb(void);
+
+#define SysTick (sim_systick())
+#define SCB (sim_scb())
+
+#define __NOP() do {} while(0)
+
+#endif
@@ -0,0 +1,110 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_eru.h: Simulated XMC1 ERU (event request unit)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_ERU_H
+#define XMC_ERU_H
+
+#include "xmc_common.h"
+
+/*
+ * Only edge detection is simulated: an event trigger logic (ETL) channel
+ * watches the pin of its selected input and triggers the output gating unit
+ * (OGU) channel it points to. Only the inputs used by the firmware are
+ * mapped to pins (see sim.c).
+ */
+#define SIM_ERU_CHANNEL_NUM 4
+
+typedef struct {
+	uint8_t source[SIM_ERU_CHANNEL_NUM];
+	uint8_t input_a[SIM_ERU_CHANNEL_NUM];
+	uint8_t input_b[SIM_ERU_CHANNEL_NUM];
+	uint8_t edge_detection[SIM_ERU_CHANNEL_NUM];
+	uint8_t output_trigger_channel[SIM_ERU_CHANNEL_NUM];
+	bool enable_output_trigger[SIM_ERU_CHANNEL_NUM];
+	bool status_flag[SIM_ERU_CHANNEL_NUM];
+	bool service_request[SIM_ERU_CHANNEL_NUM];
+} XMC_ERU_t;
+
+extern XMC_ERU_t sim_eru0;
+
+#define XMC_ERU0 (&sim_eru0)
+
+typedef enum {
+	XMC_ERU_ETL_INPUT_A0 = 0,
+	XMC_ERU_ETL_INPUT_A1,
+	XMC_ERU_ETL_INPUT_A2,
+	XMC_ERU_ETL_INPUT_A3
+} XMC_ERU_ETL_INPUT_A_t;
+
+typedef enum {
+	XMC_ERU_ETL_INPUT_B0 = 0,
+	XMC_ERU_ETL_INPUT_B1,
+	XMC_ERU_ETL_INPUT_B2,
+	XMC_ERU_ETL_INPUT_B3
+} XMC_ERU_ETL_INPUT_B_t;
+
+typedef enum {
+	XMC_ERU_ETL_SOURCE_A = 0,
+	XMC_ERU_ETL_SOURCE_B = 1
+} XMC_ERU_ETL_SOURCE_t;
+
+typedef enum {
+	XMC_ERU_ETL_EDGE_DETECTION_DISABLED = 0,
+	XMC_ERU_ETL_EDGE_DETECTION_RISING = 1,
+	XMC_ERU_ETL_EDGE_DETECTION_FALLING = 2,
+	XMC_ERU_ETL_EDGE_DETECTION_BOTH = 3
+} XMC_ERU_ETL_EDGE_DETECTION_t;
+
+typedef enum {
+	XMC_ERU_ETL_STATUS_FLAG_MODE_SWCTRL = 0,
+	XMC_ERU_ETL_STATUS_FLAG_MODE_HWCTRL = 1
+} XMC_ERU_ETL_STATUS_FLAG_MODE_t;
+
+typedef enum {
+	XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL0 = 0,
+	XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL1,
+	XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL2,
+	XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL3
+} XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL_t;
+
+typedef enum {
+	XMC_ERU_OGU_SERVICE_REQUEST_DISABLED = 0,
+	XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER = 1
+} XMC_ERU_OGU_SERVICE_REQUEST_t;
+
+typedef struct {
+	uint8_t input_a;
+	uint8_t input_b;
+	uint8_t source;
+	uint8_t edge_detection;
+	uint8_t status_flag_mode;
+	uint8_t output_trigger_channel;
+	bool enable_output_trigger;
+} XMC_ERU_ETL_CONFIG_t;
+
+void XMC_ERU_ETL_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_ETL_CONFIG_t *const config);
+void XMC_ERU_OGU_SetServiceRequestMode(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_OGU_SERVICE_REQUEST_t mode);
+
+__STATIC_INLINE void XMC_ERU_ETL_ClearStatusFlag(XMC_ERU_t *const eru, const uint8_t channel) {
+	eru->status_flag[channel] = false;
+}
+
+#endif
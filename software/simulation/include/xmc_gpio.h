@@ -0,0 +1,95 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_gpio.h: Simulated XMC1 GPIO ports
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_GPIO_H
+#define XMC_GPIO_H
+
+#include "xmc_common.h"
+
+typedef struct {
+	uint32_t out;  // Output level per pin.
+	uint32_t in;   // Input level per pin (driven by the simulated peer).
+	uint32_t mode[16];
+} XMC_GPIO_PORT_t;
+
+extern XMC_GPIO_PORT_t sim_gpio_port[5];
+
+#define XMC_GPIO_PORT0 (&sim_gpio_port[0])
+#define XMC_GPIO_PORT1 (&sim_gpio_port[1])
+#define XMC_GPIO_PORT2 (&sim_gpio_port[2])
+#define XMC_GPIO_PORT4 (&sim_gpio_port[4])
+
+#define P1_1  XMC_GPIO_PORT1, 1
+#define P1_2  XMC_GPIO_PORT1, 2
+#define P1_3  XMC_GPIO_PORT1, 3
+#define P1_6  XMC_GPIO_PORT1, 6
+#define P2_0  XMC_GPIO_PORT2, 0
+#define P2_10 XMC_GPIO_PORT2, 10
+#define P2_11 XMC_GPIO_PORT2, 11
+#define P2_12 XMC_GPIO_PORT2, 12
+#define P2_13 XMC_GPIO_PORT2, 13
+#define P4_5  XMC_GPIO_PORT4, 5
+#define P4_6  XMC_GPIO_PORT4, 6
+
+typedef enum {
+	XMC_GPIO_MODE_INPUT_TRISTATE = 0x00,
+	XMC_GPIO_MODE_INPUT_PULL_DOWN = 0x08,
+	XMC_GPIO_MODE_INPUT_PULL_UP = 0x10,
+	XMC_GPIO_MODE_OUTPUT_PUSH_PULL = 0x80,
+	XMC_GPIO_MODE_OUTPUT_PUSH_PULL_ALT2 = 0x90,
+	XMC_GPIO_MODE_OUTPUT_PUSH_PULL_ALT7 = 0xB8
+} XMC_GPIO_MODE_t;
+
+#define P1_6_AF_U0C1_DOUT0  0
+#define P1_2_AF_U0C1_DOUT0  0
+#define P2_12_AF_U1C1_DOUT0 0
+
+typedef enum {
+	XMC_GPIO_OUTPUT_LEVEL_LOW = 0,
+	XMC_GPIO_OUTPUT_LEVEL_HIGH = 1
+} XMC_GPIO_OUTPUT_LEVEL_t;
+
+typedef enum {
+	XMC_GPIO_INPUT_HYSTERESIS_STANDARD = 0,
+	XMC_GPIO_INPUT_HYSTERESIS_LARGE = 1
+} XMC_GPIO_INPUT_HYSTERESIS_t;
+
+typedef struct {
+	uint32_t mode;
+	XMC_GPIO_OUTPUT_LEVEL_t output_level;
+	XMC_GPIO_INPUT_HYSTERESIS_t input_hysteresis;
+} XMC_GPIO_CONFIG_t;
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *const port, const uint8_t pin, const XMC_GPIO_CONFIG_t *const config);
+
+__STATIC_INLINE void XMC_GPIO_SetOutputHigh(XMC_GPIO_PORT_t *const port, const uint8_t pin) {
+	port->out |= (1 << pin);
+}
+
+__STATIC_INLINE void XMC_GPIO_SetOutputLow(XMC_GPIO_PORT_t *const port, const uint8_t pin) {
+	port->out &= ~(1 << pin);
+}
+
+__STATIC_INLINE uint32_t XMC_GPIO_GetInput(XMC_GPIO_PORT_t *const port, const uint8_t pin) {
+	return (port->in >> pin) & 1;
+}
+
+#endif
@@ -0,0 +1,51 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_scu.h: Simulated XMC1 SCU interrupt control
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_SCU_H
+#define XMC_SCU_H
+
+#include "xmc_common.h"
+
+// The IRQCTRL selector encodes the USIC1 service request that is routed to the IRQ.
+#define XMC_SCU_IRQCTRL_USIC1_SR_MARK    0x100
+#define XMC_SCU_IRQCTRL_USIC1_SR2_IRQ11  (XMC_SCU_IRQCTRL_USIC1_SR_MARK | 2)
+#define XMC_SCU_IRQCTRL_USIC1_SR3_IRQ12  (XMC_SCU_IRQCTRL_USIC1_SR_MARK | 3)
+#define XMC_SCU_IRQCTRL_USIC1_SR4_IRQ13  (XMC_SCU_IRQCTRL_USIC1_SR_MARK | 4)
+#define XMC_SCU_IRQCTRL_USIC1_SR5_IRQ14  (XMC_SCU_IRQCTRL_USIC1_SR_MARK | 5)
+
+// Same for the CCU40 service requests.
+#define XMC_SCU_IRQCTRL_CCU40_SR_MARK    0x200
+#define XMC_SCU_IRQCTRL_CCU40_SR0_IRQ21  (XMC_SCU_IRQCTRL_CCU40_SR_MARK | 0)
+#define XMC_SCU_IRQCTRL_CCU40_SR1_IRQ22  (XMC_SCU_IRQCTRL_CCU40_SR_MARK | 1)
+#define XMC_SCU_IRQCTRL_CCU40_SR2_IRQ23  (XMC_SCU_IRQCTRL_CCU40_SR_MARK | 2)
+#define XMC_SCU_IRQCTRL_CCU40_SR3_IRQ24  (XMC_SCU_IRQCTRL_CCU40_SR_MARK | 3)
+
+// Same for the ERU0 service requests.
+#define XMC_SCU_IRQCTRL_ERU0_SR_MARK     0x400
+#define XMC_SCU_IRQCTRL_ERU0_SR0_IRQ3    (XMC_SCU_IRQCTRL_ERU0_SR_MARK | 0)
+#define XMC_SCU_IRQCTRL_ERU0_SR1_IRQ4    (XMC_SCU_IRQCTRL_ERU0_SR_MARK | 1)
+#define XMC_SCU_IRQCTRL_ERU0_SR2_IRQ5    (XMC_SCU_IRQCTRL_ERU0_SR_MARK | 2)
+#define XMC_SCU_IRQCTRL_ERU0_SR3_IRQ6    (XMC_SCU_IRQCTRL_ERU0_SR_MARK | 3)
+
+void XMC_SCU_SetInterruptControl(const uint8_t irq_number, const uint32_t source);
+uint32_t XMC_SCU_CLOCK_GetPeripheralClockFrequency(void);
+
+#endif
@@ -0,0 +1,91 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_uart.h: Simulated XMC1 UART driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_UART_H
+#define XMC_UART_H
+
+#include "xmc_usic.h"
+
+#define XMC_UART0_CH1 USIC0_CH1
+#define XMC_UART1_CH1 USIC1_CH1
+#define XMC_SPI0_CH1  USIC0_CH1
+
+typedef enum {
+	XMC_UART_CH_STATUS_OK = 0,
+	XMC_UART_CH_STATUS_ERROR,
+	XMC_UART_CH_STATUS_BUSY
+} XMC_UART_CH_STATUS_t;
+
+// ASC mode bits of PSR.
+typedef enum {
+	XMC_UART_CH_STATUS_FLAG_TRANSMISSION_IDLE = (1 << 0),
+	XMC_UART_CH_STATUS_FLAG_SYNCHRONIZATION_BREAK_DETECTED = (1 << 2),
+	XMC_UART_CH_STATUS_FLAG_RECEIVER_NOISE_DETECTED = (1 << 4),
+	XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0 = (1 << 5),
+	XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_1 = (1 << 6),
+	XMC_UART_CH_STATUS_FLAG_DATA_LOST_INDICATION = (1 << 11),
+	XMC_UART_CH_STATUS_FLAG_ALTERNATIVE_RECEIVE_INDICATION = (1 << 15)
+} XMC_UART_CH_STATUS_FLAG_t;
+
+// Channel events share the XMC_USIC_CH_EVENT_t bits, protocol events are above.
+typedef enum {
+	XMC_UART_CH_EVENT_DATA_LOST = XMC_USIC_CH_EVENT_DATA_LOST,
+	XMC_UART_CH_EVENT_ALTERNATIVE_RECEIVE = XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE,
+	XMC_UART_CH_EVENT_SYNCHRONIZATION_BREAK = (1 << 17),
+	XMC_UART_CH_EVENT_RECEIVER_NOISE = (1 << 18),
+	XMC_UART_CH_EVENT_FORMAT_ERROR = (1 << 19)
+} XMC_UART_CH_EVENT_t;
+
+typedef struct {
+	uint32_t baudrate;
+	uint8_t data_bits;
+	uint8_t frame_length;
+	uint8_t stop_bits;
+	uint8_t oversampling;
+	XMC_USIC_CH_PARITY_MODE_t parity_mode;
+} XMC_UART_CH_CONFIG_t;
+
+void XMC_UART_CH_Init(XMC_USIC_CH_t *const channel, const XMC_UART_CH_CONFIG_t *const config);
+void XMC_UART_CH_SetInputSource(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INPUT_t input, const uint8_t source);
+XMC_UART_CH_STATUS_t XMC_UART_CH_Stop(XMC_USIC_CH_t *const channel);
+void XMC_UART_CH_Start(XMC_USIC_CH_t *const channel);
+
+__STATIC_INLINE uint32_t XMC_UART_CH_GetStatusFlag(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->psr;
+}
+
+__STATIC_INLINE void XMC_UART_CH_ClearStatusFlag(XMC_USIC_CH_t *const channel, const uint32_t flag) {
+	channel->accesses++;
+	channel->psr &= ~flag;
+}
+
+__STATIC_INLINE void XMC_UART_CH_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->channel_events |= event;
+}
+
+__STATIC_INLINE void XMC_UART_CH_DisableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->channel_events &= ~event;
+}
+
+#endif
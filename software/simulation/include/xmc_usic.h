@@ -0,0 +1,276 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * xmc_usic.h: Simulated XMC1 USIC channel with 32 word RX/TX FIFOs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_USIC_H
+#define XMC_USIC_H
+
+#include "xmc_common.h"
+
+#define SIM_USIC_FIFO_SIZE 32
+
+// Receiver control information (RCI) of an RX FIFO word in OUTR.
+#define USIC_CH_OUTR_RCI_Pos 16
+#define USIC_CH_OUTR_RCI_Msk (0x1F << USIC_CH_OUTR_RCI_Pos)
+
+// Baudrate generator fields, same layout as on the XMC1400.
+#define USIC_CH_FDR_STEP_Pos 0
+#define USIC_CH_FDR_STEP_Msk (0x3FF << USIC_CH_FDR_STEP_Pos)
+#define USIC_CH_FDR_DM_Pos 14
+#define USIC_CH_FDR_DM_Msk (0x3 << USIC_CH_FDR_DM_Pos)
+#define USIC_CH_BRG_PCTQ_Pos 8
+#define USIC_CH_BRG_PCTQ_Msk (0x3 << USIC_CH_BRG_PCTQ_Pos)
+#define USIC_CH_BRG_DCTQ_Pos 10
+#define USIC_CH_BRG_DCTQ_Msk (0x1F << USIC_CH_BRG_DCTQ_Pos)
+#define USIC_CH_BRG_PDIV_Pos 16
+#define USIC_CH_BRG_PDIV_Msk (0x3FF << USIC_CH_BRG_PDIV_Pos)
+#define USIC_CH_PCR_ASCMode_SMD_Pos 0
+#define USIC_CH_PCR_ASCMode_SMD_Msk (0x1 << USIC_CH_PCR_ASCMode_SMD_Pos)
+#define USIC_CH_PCR_ASCMode_SP_Pos 8
+#define USIC_CH_PCR_ASCMode_SP_Msk (0x1F << USIC_CH_PCR_ASCMode_SP_Pos)
+
+/*
+ * Reading OUTR pops the RX FIFO, so the register is modelled as a call.
+ * RS232_USIC->OUTR reads the oldest word including the RCI. It is the only
+ * way the firmware reads the RX FIFO, XMC_USIC_CH_RXFIFO_GetData() (a read
+ * of the same register) is intentionally not provided.
+ */
+#define OUTR outr_read()
+
+/*
+ * The virtual USIC channel does not model the register file. Only the
+ * FIFO and service request behaviour that rs232.c relies on is modelled,
+ * plus the baudrate generator registers (the line runs at the rate they
+ * result in, or at the configured baudrate if FDR was not written).
+ * Data is moved by the line model in simulation/sim.c.
+ */
+typedef struct {
+	// Receive FIFO, words are stored in the OUTR layout (data and RCI).
+	uint32_t rx_fifo[SIM_USIC_FIFO_SIZE];
+	uint8_t rx_read;
+	uint8_t rx_count;
+	uint8_t rx_size;
+	uint8_t rx_limit;
+	uint32_t rx_events;
+	uint8_t rx_sr_standard;
+	uint8_t rx_sr_alternate;
+
+	// Transmit FIFO.
+	uint16_t tx_fifo[SIM_USIC_FIFO_SIZE];
+	uint8_t tx_read;
+	uint8_t tx_count;
+	uint8_t tx_size;
+	uint8_t tx_limit;
+	uint32_t tx_events;
+	uint8_t tx_sr_standard;
+	uint8_t tx_start_mode;
+
+	// Channel (protocol) events.
+	uint32_t channel_events;
+	uint8_t sr_alternate_receive;
+	uint8_t sr_protocol;
+	uint32_t psr;
+	uint32_t (*outr_read)(void);
+
+	// Protocol configuration.
+	bool running;
+	uint32_t baudrate;
+	uint8_t data_bits;
+	uint8_t stop_bits;
+	uint8_t parity_mode;
+	uint8_t oversampling;
+	uint32_t FDR;
+	uint32_t BRG;
+	uint32_t PCR_ASCMode;
+
+	// Statistics.
+	uint32_t accesses;
+	uint32_t rx_fifo_overflows;
+} XMC_USIC_CH_t;
+
+extern XMC_USIC_CH_t sim_usic0_ch1;
+extern XMC_USIC_CH_t sim_usic1_ch1;
+
+#define USIC0_CH1 (&sim_usic0_ch1)
+#define USIC1_CH1 (&sim_usic1_ch1)
+
+typedef enum {
+	XMC_USIC_CH_FIFO_DISABLE = 0,
+	XMC_USIC_CH_FIFO_SIZE_2WORDS,
+	XMC_USIC_CH_FIFO_SIZE_4WORDS,
+	XMC_USIC_CH_FIFO_SIZE_8WORDS,
+	XMC_USIC_CH_FIFO_SIZE_16WORDS,
+	XMC_USIC_CH_FIFO_SIZE_32WORDS,
+	XMC_USIC_CH_FIFO_SIZE_64WORDS
+} XMC_USIC_CH_FIFO_SIZE_t;
+
+typedef enum {
+	XMC_USIC_CH_PARITY_MODE_NONE = 0,
+	XMC_USIC_CH_PARITY_MODE_EVEN = 2,
+	XMC_USIC_CH_PARITY_MODE_ODD = 3
+} XMC_USIC_CH_PARITY_MODE_t;
+
+typedef enum {
+	XMC_USIC_CH_INPUT_DX0 = 0,
+	XMC_USIC_CH_INPUT_DX1,
+	XMC_USIC_CH_INPUT_DX2
+} XMC_USIC_CH_INPUT_t;
+
+typedef enum {
+	XMC_USIC_CH_EVENT_RECEIVE_START = (1 << 10),
+	XMC_USIC_CH_EVENT_DATA_LOST = (1 << 11),
+	XMC_USIC_CH_EVENT_TRANSMIT_SHIFT = (1 << 12),
+	XMC_USIC_CH_EVENT_TRANSMIT_BUFFER = (1 << 13),
+	XMC_USIC_CH_EVENT_STANDARD_RECEIVE = (1 << 14),
+	XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE = (1 << 15)
+} XMC_USIC_CH_EVENT_t;
+
+typedef enum {
+	XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_DISABLED = 0,
+	XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_NORMAL = (1 << USIC_CH_FDR_DM_Pos),
+	XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_FRACTIONAL = (2 << USIC_CH_FDR_DM_Pos)
+} XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_t;
+
+// TCSR.TDEN, only "disabled" and "start on TDV" are simulated.
+typedef enum {
+	XMC_USIC_CH_START_TRANSMISION_DISABLED = 0,
+	XMC_USIC_CH_START_TRANSMISION_ON_TDV = 1
+} XMC_USIC_CH_START_TRANSMISION_MODE_t;
+
+typedef enum {
+	XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD = (1 << 30),
+	XMC_USIC_CH_TXFIFO_EVENT_CONF_ERROR = (1 << 31)
+} XMC_USIC_CH_TXFIFO_EVENT_CONF_t;
+
+typedef enum {
+	XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD = (1 << 30),
+	XMC_USIC_CH_RXFIFO_EVENT_CONF_ERROR = (1 << 31),
+	XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE = (1 << 29)
+} XMC_USIC_CH_RXFIFO_EVENT_CONF_t;
+
+typedef enum {
+	XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_STANDARD = 0,
+	XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_ERROR
+} XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_t;
+
+typedef enum {
+	XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD = 0,
+	XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ERROR,
+	XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE
+} XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t;
+
+typedef enum {
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_TRANSMIT_SHIFT = 0,
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_TRANSMIT_BUFFER,
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_RECEIVE,
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_ALTERNATE_RECEIVE,
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_PROTOCOL
+} XMC_USIC_CH_INTERRUPT_NODE_POINTER_t;
+
+void XMC_USIC_CH_TXFIFO_Configure(XMC_USIC_CH_t *const channel, const uint32_t data_pointer, const XMC_USIC_CH_FIFO_SIZE_t size, const uint32_t limit);
+void XMC_USIC_CH_RXFIFO_Configure(XMC_USIC_CH_t *const channel, const uint32_t data_pointer, const XMC_USIC_CH_FIFO_SIZE_t size, const uint32_t limit);
+void XMC_USIC_CH_TXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request);
+void XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request);
+void XMC_USIC_CH_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request);
+void XMC_USIC_CH_TriggerServiceRequest(XMC_USIC_CH_t *const channel, const uint32_t service_request_line);
+
+__STATIC_INLINE void XMC_USIC_CH_SetFractionalDivider(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_t mode, const uint16_t step) {
+	channel->accesses++;
+	channel->FDR = mode | step;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_SetStartTransmisionMode(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_START_TRANSMISION_MODE_t mode) {
+	channel->accesses++;
+	channel->tx_start_mode = mode;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_TXFIFO_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->tx_events |= event;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_TXFIFO_DisableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->tx_events &= ~event;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_RXFIFO_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->rx_events |= event;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_RXFIFO_DisableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->rx_events &= ~event;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->channel_events |= event;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_DisableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {
+	channel->accesses++;
+	channel->channel_events &= ~event;
+}
+
+__STATIC_INLINE bool XMC_USIC_CH_RXFIFO_IsEmpty(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->rx_count == 0;
+}
+
+__STATIC_INLINE bool XMC_USIC_CH_RXFIFO_IsFull(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->rx_count == channel->rx_size;
+}
+
+__STATIC_INLINE uint32_t XMC_USIC_CH_RXFIFO_GetLevel(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->rx_count;
+}
+
+__STATIC_INLINE bool XMC_USIC_CH_TXFIFO_IsFull(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->tx_count == channel->tx_size;
+}
+
+__STATIC_INLINE bool XMC_USIC_CH_TXFIFO_IsEmpty(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->tx_count == 0;
+}
+
+__STATIC_INLINE uint32_t XMC_USIC_CH_TXFIFO_GetLevel(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	return channel->tx_count;
+}
+
+__STATIC_INLINE void XMC_USIC_CH_TXFIFO_PutData(XMC_USIC_CH_t *const channel, const uint16_t data) {
+	channel->accesses++;
+
+	// Writing to a full FIFO is lost, like on the hardware.
+	if(channel->tx_count == channel->tx_size) {
+		return;
+	}
+
+	channel->tx_fifo[(channel->tx_read + channel->tx_count) % SIM_USIC_FIFO_SIZE] = data;
+	channel->tx_count++;
+}
+
+#endif
@@ -0,0 +1,278 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * main.c: Command line driver for the RS232 V2 simulation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "sim.h"
+
+#include "communication.h"
+#include "rs232.h"
+
+#define MODE_RX 0
+#define MODE_TX 1
+#define MODE_LOOPBACK 2
+#define MODE_XOFF 3
+
+typedef struct {
+	uint64_t callback_messages;
+	uint64_t callback_bytes;
+	uint64_t written_bytes;
+	uint64_t callback_sequence_errors;
+	uint8_t callback_expected;
+	bool callback_synced;
+	bool skip_fc_sw_bytes;
+	bool write_pending;
+	uint64_t xoff_decided_ns;
+	uint64_t xoff_latency_ns;
+} Driver;
+
+static Driver driver;
+
+static void spitfp_hook(const uint8_t *data, const uint8_t length, const uint64_t now_ns, void *context) {
+	const TFPMessageHeader *header = (const TFPMessageHeader*)data;
+
+	if(header->fid == FID_CALLBACK_READ_LOW_LEVEL) {
+		const ReadLowLevel_Callback *cb = (const ReadLowLevel_Callback*)data;
+		const uint16_t left = cb->message_length - cb->message_chunk_offset;
+		const uint16_t count = left < sizeof(cb->message_chunk_data) ? left : sizeof(cb->message_chunk_data);
+
+		// In rx mode the peer sends 0..255 in a loop, every gap is lost or corrupted data.
+		for(uint16_t i = 0; i < count; i++) {
+			const uint8_t data = cb->message_chunk_data[i];
+			if(driver.callback_synced && data != driver.callback_expected) {
+				driver.callback_sequence_errors++;
+			}
+
+			// With software flow control XON/XOFF never reach the host.
+			driver.callback_expected = data + 1;
+			while(driver.skip_fc_sw_bytes && (driver.callback_expected == FC_SW_XON || driver.callback_expected == FC_SW_XOFF)) {
+				driver.callback_expected++;
+			}
+			driver.callback_synced = true;
+		}
+
+		driver.callback_messages++;
+		driver.callback_bytes += count;
+	} else if(header->fid == FID_WRITE_LOW_LEVEL) {
+		driver.written_bytes += ((const WriteLowLevel_Response*)data)->message_chunk_written;
+		driver.write_pending = false;
+	}
+}
+
+// Time from the RX buffer reaching the high watermark until XOFF is on the line.
+static void line_tx_hook(const uint8_t byte, const uint64_t now_ns, void *context) {
+	if((byte == FC_SW_XOFF) && (driver.xoff_decided_ns != 0) && (driver.xoff_latency_ns == 0)) {
+		driver.xoff_latency_ns = now_ns - driver.xoff_decided_ns;
+	}
+}
+
+static void request_read_callback_coalescing(const uint16_t minimum_bytes, const uint32_t maximum_latency) {
+	SetReadCallbackCoalescingConfiguration request;
+	sim_make_header(&request.header, sizeof(request), FID_SET_READ_CALLBACK_COALESCING_CONFIGURATION, false);
+	request.minimum_bytes = minimum_bytes;
+	request.maximum_latency = maximum_latency;
+	sim_host_request(&request, sizeof(request));
+}
+
+static void print_cost(const char *name, const SimCost *cost) {
+	printf("%s_calls=%u\n", name, cost->calls);
+	printf("%s_cycles_avg=%.1f\n", name, cost->calls ? (double)cost->cycles / cost->calls : 0.0);
+	printf("%s_cycles_max=%u\n", name, cost->cycles_max);
+	printf("%s_blocks_avg=%.1f\n", name, cost->calls ? (double)cost->blocks / cost->calls : 0.0);
+	printf("%s_accesses_avg=%.1f\n", name, cost->calls ? (double)cost->accesses / cost->calls : 0.0);
+}
+
+static void usage(const char *name) {
+	printf("Usage: %s [options]\n"
+	       "  --mode rx|tx|loopback|xoff traffic direction (default rx), xoff: both\n"
+	       "                          directions, host does not read, measures XOFF latency\n"
+	       "  --baudrate N            line baudrate (default 115200)\n"
+	       "  --flowcontrol N         0 = off, 1 = software, 2 = hardware (default 0)\n"
+	       "  --duration-ms N         virtual run time (default 1000)\n"
+	       "  --cpu-mhz N             virtual CPU clock (default 48)\n"
+	       "  --block-cycles N        cycles per executed basic block (default 8)\n"
+	       "  --spitfp-khz N          SPITFP clock (default 1400)\n"
+	       "  --trickle-us N          rx: peer sends one byte every N us (default 0 = continuous)\n"
+	       "  --coalesce-bytes N      read callback minimum bytes (default 1)\n"
+	       "  --coalesce-us N         read callback maximum latency in us (default 0)\n", name);
+}
+
+int main(int argc, char **argv) {
+	SimConfig config;
+	sim_config_default(&config);
+
+	int mode = MODE_RX;
+	uint32_t baudrate = 115200;
+	uint8_t flowcontrol = RS232_V2_FLOWCONTROL_OFF;
+	uint32_t duration_ms = 1000;
+	uint32_t trickle_us = 0;
+	uint16_t coalesce_bytes = 1;
+	uint32_t coalesce_us = 0;
+
+	static const struct option options[] = {
+		{"mode",        required_argument, NULL, 'm'},
+		{"baudrate",    required_argument, NULL, 'b'},
+		{"flowcontrol", required_argument, NULL, 'f'},
+		{"duration-ms", required_argument, NULL, 'd'},
+		{"cpu-mhz",     required_argument, NULL, 'c'},
+		{"block-cycles", required_argument, NULL, 's'},
+		{"spitfp-khz",  required_argument, NULL, 'k'},
+		{"trickle-us",  required_argument, NULL, 't'},
+		{"coalesce-bytes", required_argument, NULL, 'n'},
+		{"coalesce-us", required_argument, NULL, 'l'},
+		{"help",        no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+		switch(opt) {
+			case 'm':
+				if(strcmp(optarg, "rx") == 0) {
+					mode = MODE_RX;
+				} else if(strcmp(optarg, "tx") == 0) {
+					mode = MODE_TX;
+				} else if(strcmp(optarg, "loopback") == 0) {
+					mode = MODE_LOOPBACK;
+				} else if(strcmp(optarg, "xoff") == 0) {
+					mode = MODE_XOFF;
+				} else {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'b': baudrate = strtoul(optarg, NULL, 0); break;
+			case 'f': flowcontrol = strtoul(optarg, NULL, 0); break;
+			case 'd': duration_ms = strtoul(optarg, NULL, 0); break;
+			case 'c': config.cpu_hz = strtoul(optarg, NULL, 0) * 1000000; break;
+			case 's': config.block_cycles = strtoul(optarg, NULL, 0); break;
+			case 'k': config.spitfp_hz = strtoul(optarg, NULL, 0) * 1000; break;
+			case 't': trickle_us = strtoul(optarg, NULL, 0); break;
+			case 'n': coalesce_bytes = strtoul(optarg, NULL, 0); break;
+			case 'l': coalesce_us = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	sim_init(&config);
+	sim_set_spitfp_hook(spitfp_hook, NULL);
+	sim_set_line_tx_hook(line_tx_hook, NULL);
+	sim_peer_set_flowcontrol(flowcontrol);
+	sim_peer_set_loopback(mode == MODE_LOOPBACK);
+
+	sim_request_configuration(baudrate, flowcontrol);
+	if((mode != MODE_TX) && (mode != MODE_XOFF)) {
+		sim_request_enable_read_callback();
+		request_read_callback_coalescing(coalesce_bytes, coalesce_us);
+	}
+
+	// Let the configuration settle before measuring.
+	sim_run_for(10 * 1000000ULL);
+	sim_reset_stats();
+	driver.callback_messages = 0;
+	driver.callback_bytes = 0;
+	driver.written_bytes = 0;
+	driver.callback_sequence_errors = 0;
+	driver.callback_synced = false;
+	driver.skip_fc_sw_bytes = flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE;
+
+	static uint8_t alphabet[60];
+	for(uint8_t i = 0; i < sizeof(alphabet); i++) {
+		alphabet[i] = 'A' + (i % 26);
+	}
+
+	static uint8_t pattern[256];
+	for(int i = 0; i < 256; i++) {
+		pattern[i] = i;
+
+		// The peer does not pause the bricklet in xoff mode.
+		if((mode == MODE_XOFF) && (i == FC_SW_XON || i == FC_SW_XOFF)) {
+			pattern[i] = 'X';
+		}
+	}
+
+	const uint64_t end_ns = sim_now_ns() + duration_ms * 1000000ULL;
+	uint64_t trickle_next_ns = sim_now_ns();
+	uint8_t trickle_byte = 0;
+	while(sim_now_ns() < end_ns) {
+		if(mode == MODE_RX && trickle_us > 0) {
+			if(sim_now_ns() >= trickle_next_ns) {
+				sim_peer_send(&pattern[trickle_byte++], 1);
+				trickle_next_ns += trickle_us * 1000ULL;
+			}
+		} else if((mode == MODE_RX || mode == MODE_XOFF) && sim_peer_send_pending() < sizeof(pattern)) {
+			sim_peer_send(pattern, sizeof(pattern));
+		}
+
+		if(mode != MODE_RX && !driver.write_pending) {
+			driver.write_pending = sim_request_write(alphabet, sizeof(alphabet));
+		}
+
+		sim_main_loop_iteration();
+
+		if((mode == MODE_XOFF) && (driver.xoff_decided_ns == 0) && (rs232.fc_sw_state_rx == FC_SW_STATE_RX_WAIT)) {
+			driver.xoff_decided_ns = sim_now_ns();
+		}
+	}
+
+	const SimStats *stats = sim_get_stats();
+	const double seconds = duration_ms / 1000.0;
+
+	printf("baudrate=%u\n", baudrate);
+	printf("flowcontrol=%u\n", flowcontrol);
+	printf("duration_ms=%u\n", duration_ms);
+	printf("cpu_hz=%u\n", config.cpu_hz);
+	printf("block_cycles=%u\n", config.block_cycles);
+	printf("line_rx_bytes=%llu\n", (unsigned long long)stats->rx_line_bytes);
+	printf("line_tx_bytes=%llu\n", (unsigned long long)stats->tx_line_bytes);
+	printf("line_rx_bytes_per_s=%.0f\n", stats->rx_line_bytes / seconds);
+	printf("line_tx_bytes_per_s=%.0f\n", stats->tx_line_bytes / seconds);
+	printf("callback_messages=%llu\n", (unsigned long long)driver.callback_messages);
+	printf("callback_bytes=%llu\n", (unsigned long long)driver.callback_bytes);
+	printf("written_bytes=%llu\n", (unsigned long long)driver.written_bytes);
+	if(mode == MODE_RX) {
+		printf("callback_sequence_errors=%llu\n", (unsigned long long)driver.callback_sequence_errors);
+	}
+	if(mode == MODE_XOFF) {
+		printf("xoff_latency_us=%.1f\n", driver.xoff_latency_ns / 1000.0);
+	}
+	printf("spitfp_messages=%llu\n", (unsigned long long)stats->spitfp_messages);
+	printf("usic_rx_fifo_overflows=%u\n", stats->rx_fifo_overflows);
+	printf("error_count_overrun=%u\n", rs232._error_count_overrun);
+	printf("error_count_parity=%u\n", rs232._error_count_parity);
+	printf("main_loop_iterations=%llu\n", (unsigned long long)stats->main_loop_iterations);
+	print_cost("rx_irq", &stats->rx_irq);
+	print_cost("tx_irq", &stats->tx_irq);
+	print_cost("rxa_irq", &stats->rxa_irq);
+	print_cost("frame_gap_irq", &stats->frame_gap_irq);
+	print_cost("cts_irq", &stats->cts_irq);
+	print_cost("rx_edge_irq", &stats->rx_edge_irq);
+	print_cost("rs232_tick", &stats->rs232_tick);
+	print_cost("modbus_tick", &stats->modbus_tick);
+	print_cost("bootloader_tick", &stats->bootloader_tick);
+	print_cost("communication_tick", &stats->communication_tick);
+
+	return 0;
+}
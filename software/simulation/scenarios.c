@@ -0,0 +1,621 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * scenarios.c: Data integrity scenarios for the RS232 V2 simulation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Every scenario runs on a fresh simulation. The peer streams a known
+ * pseudo-random byte sequence while the firmware moves the buffered RX data
+ * around, the host has to receive it in order and everything it did not
+ * receive has to be reported as dropped (see scenario_check()). Data the
+ * host writes has to reach the line unchanged.
+ *
+ * reconfigure   set_buffer_config moves the RX/TX split back and forth
+ *               while both directions are busy.
+ * pool          The buffer pool grows the RX part while the host reads
+ *               slower than the peer sends and shrinks it again while the
+ *               host writes faster than the line.
+ * transaction   Transaction responses are cut out of the middle of the RX
+ *               buffer while the peer keeps sending.
+ * drop_oldest   The drop-oldest policy drops in the RX interrupt and, while
+ *               a read stream holds the front of the RX buffer, behind it
+ *               in the tick.
+ *
+ * Exits with 1 if a scenario failed, runs only the named scenarios if
+ * names are given on the command line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#include "communication.h"
+#include "rs232.h"
+
+#define SCENARIO_STREAM_SIZE (64*1024)
+#define SCENARIO_SYNC_LENGTH 8
+#define SCENARIO_SETTLE_NS (10 * 1000000ULL)
+#define SCENARIO_DRAIN_NS (3000 * 1000000ULL)
+#define SCENARIO_PEER_BURST 64
+#define SCENARIO_RESPONSE_MAX 1024
+
+typedef struct {
+	// Peer to host.
+	uint8_t rx_stream[SCENARIO_STREAM_SIZE];
+	uint32_t rx_length;
+	uint32_t rx_sent;
+	uint8_t rx_received[SCENARIO_STREAM_SIZE];
+	uint32_t rx_received_count;
+	bool read_in_flight;
+	bool read_stream_open;
+
+	// Transaction responses, cut out of the RX stream by the bricklet.
+	uint8_t responses[SCENARIO_STREAM_SIZE];
+	uint32_t responses_count;
+	uint32_t response_end[SCENARIO_RESPONSE_MAX];
+	uint32_t response_num;
+	bool transaction_in_flight;
+
+	// Host to peer.
+	uint8_t tx_stream[SCENARIO_STREAM_SIZE];
+	uint32_t tx_length;
+	uint32_t tx_written;
+	uint32_t tx_line_count;
+	uint32_t tx_line_errors;
+	bool write_in_flight;
+
+	uint32_t dropped;
+	bool dropped_received;
+} Scenario;
+
+static Scenario sc;
+
+static uint16_t chunk_length(const uint16_t length, const uint16_t offset, const uint16_t chunk_size) {
+	if(length <= offset) {
+		return 0;
+	}
+
+	return length - offset < chunk_size ? length - offset : chunk_size;
+}
+
+static void received(const char *data, const uint16_t count) {
+	for(uint16_t i = 0; (i < count) && (sc.rx_received_count < SCENARIO_STREAM_SIZE); i++) {
+		sc.rx_received[sc.rx_received_count++] = data[i];
+	}
+}
+
+static void spitfp_hook(const uint8_t *data, const uint8_t length, const uint64_t now_ns, void *context) {
+	const TFPMessageHeader *header = (const TFPMessageHeader*)data;
+
+	switch(header->fid) {
+		case FID_CALLBACK_READ_LOW_LEVEL: {
+			const ReadLowLevel_Callback *cb = (const ReadLowLevel_Callback*)data;
+			received(cb->message_chunk_data, chunk_length(cb->message_length, cb->message_chunk_offset, sizeof(cb->message_chunk_data)));
+			break;
+		}
+
+		case FID_READ_LOW_LEVEL: {
+			const ReadLowLevel_Response *response = (const ReadLowLevel_Response*)data;
+			const uint16_t count = chunk_length(response->message_length, response->message_chunk_offset, sizeof(response->message_chunk_data));
+
+			received(response->message_chunk_data, count);
+			sc.read_in_flight = false;
+			sc.read_stream_open = response->message_chunk_offset + count < response->message_length;
+			break;
+		}
+
+		case FID_WRITE_LOW_LEVEL: {
+			sc.tx_written += ((const WriteLowLevel_Response*)data)->message_chunk_written;
+			sc.write_in_flight = false;
+			break;
+		}
+
+		case FID_TRANSACTION_LOW_LEVEL: {
+			const uint8_t written = ((const TransactionLowLevel_Response*)data)->message_chunk_written;
+
+			// A transaction that was not started (e.g. another one is in progress) writes nothing.
+			sc.tx_written += written;
+			sc.transaction_in_flight = written > 0;
+			break;
+		}
+
+		case FID_CALLBACK_TRANSACTION_RESPONSE_LOW_LEVEL: {
+			const TransactionResponseLowLevel_Callback *cb = (const TransactionResponseLowLevel_Callback*)data;
+			const uint16_t count = chunk_length(cb->response_length, cb->response_chunk_offset, sizeof(cb->response_chunk_data));
+
+			memcpy(&sc.responses[sc.responses_count], cb->response_chunk_data, count);
+			sc.responses_count += count;
+
+			if(cb->response_chunk_offset + count >= cb->response_length) {
+				if((cb->response_length > 0) && (sc.response_num < SCENARIO_RESPONSE_MAX)) {
+					sc.response_end[sc.response_num++] = sc.responses_count;
+				}
+
+				sc.transaction_in_flight = false;
+			}
+			break;
+		}
+
+		case FID_GET_RX_OVERFLOW_POLICY: {
+			const GetRXOverflowPolicy_Response *response = (const GetRXOverflowPolicy_Response*)data;
+			sc.dropped = response->dropped_newest + response->dropped_oldest;
+			sc.dropped_received = true;
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+static void line_tx_hook(const uint8_t byte, const uint64_t now_ns, void *context) {
+	if((sc.tx_line_count >= sc.tx_written) || (byte != sc.tx_stream[sc.tx_line_count])) {
+		sc.tx_line_errors++;
+	}
+
+	sc.tx_line_count++;
+}
+
+static void stream_fill(uint8_t *stream, const uint32_t length, uint32_t seed) {
+	for(uint32_t i = 0; i < length; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		stream[i] = seed >> 24;
+	}
+}
+
+static void setup(const uint32_t baudrate, const uint32_t rx_length, const uint32_t tx_length) {
+	SimConfig config;
+	sim_config_default(&config);
+
+	memset(&sc, 0, sizeof(Scenario));
+	sc.rx_length = rx_length;
+	sc.tx_length = tx_length;
+	stream_fill(sc.rx_stream, rx_length, 0x2545F491);
+	stream_fill(sc.tx_stream, tx_length, 0x9E3779B9);
+
+	sim_init(&config);
+	sim_set_spitfp_hook(spitfp_hook, NULL);
+	sim_set_line_tx_hook(line_tx_hook, NULL);
+	sim_request_configuration(baudrate, RS232_V2_FLOWCONTROL_OFF);
+	sim_run_for(SCENARIO_SETTLE_NS);
+}
+
+// Keeps the peer sending until the whole RX stream is on the line.
+static void peer_tick(void) {
+	if((sc.rx_sent < sc.rx_length) && (sim_peer_send_pending() < SCENARIO_PEER_BURST)) {
+		const uint32_t count = sc.rx_length - sc.rx_sent < SCENARIO_PEER_BURST ? sc.rx_length - sc.rx_sent : SCENARIO_PEER_BURST;
+
+		sim_peer_send(&sc.rx_stream[sc.rx_sent], count);
+		sc.rx_sent += count;
+	}
+}
+
+static bool peer_done(void) {
+	return (sc.rx_sent == sc.rx_length) && (sim_peer_send_pending() == 0);
+}
+
+static void write_tick(void) {
+	if(!sc.write_in_flight && (sc.tx_written < sc.tx_length)) {
+		const uint32_t count = sc.tx_length - sc.tx_written < 60 ? sc.tx_length - sc.tx_written : 60;
+
+		sc.write_in_flight = sim_request_write(&sc.tx_stream[sc.tx_written], count);
+	}
+}
+
+// Sends the next byte of the TX stream as a transaction without a terminator.
+static void transaction_tick(const uint16_t response_length) {
+	if(!sc.transaction_in_flight && (sc.tx_written < sc.tx_length)) {
+		TransactionLowLevel request;
+		sim_make_header(&request.header, sizeof(request), FID_TRANSACTION_LOW_LEVEL, true);
+		memset(request.message_chunk_data, 0, sizeof(request.message_chunk_data));
+		request.message_length = 1;
+		request.message_chunk_offset = 0;
+		request.message_chunk_data[0] = sc.tx_stream[sc.tx_written];
+		request.response_length = response_length;
+		request.terminator = -1;
+		request.timeout = 100;
+
+		sc.transaction_in_flight = sim_host_request(&request, sizeof(request));
+	}
+}
+
+// Polls read_low_level with one request in flight.
+static void read_tick(const uint16_t length) {
+	if(!sc.read_in_flight) {
+		ReadLowLevel request;
+		sim_make_header(&request.header, sizeof(request), FID_READ_LOW_LEVEL, true);
+		request.length = length;
+
+		sc.read_in_flight = sim_host_request(&request, sizeof(request));
+	}
+}
+
+/*
+ * Runs until the peer is done and the host got everything from the RX
+ * buffer, with read_length > 0 the host polls instead of using the read
+ * callback.
+ */
+static void drain(const uint16_t read_length) {
+	const uint64_t end_ns = sim_now_ns() + SCENARIO_DRAIN_NS;
+
+	while(sim_now_ns() < end_ns) {
+		peer_tick();
+		write_tick();
+		if(read_length > 0) {
+			read_tick(read_length);
+		}
+		sim_main_loop_iteration();
+
+		if(peer_done() && (ringbuffer_get_used(&rs232.rb_rx) == 0) && (ringbuffer_get_used(&rs232.rb_tx) == 0) &&
+		   !sc.read_in_flight && !sc.write_in_flight && !sc.transaction_in_flight &&
+		   (sc.tx_line_count == sc.tx_written)) {
+			break;
+		}
+	}
+
+	// Let the last callback and the last byte on the line finish.
+	sim_run_for(SCENARIO_SETTLE_NS);
+}
+
+// First position after p where length bytes of data are in the RX stream.
+static uint32_t stream_find(uint32_t p, const uint8_t *data, const uint32_t length) {
+	do {
+		p++;
+	} while((p + length <= sc.rx_sent) && (memcmp(&sc.rx_stream[p], data, length) != 0));
+
+	return p + length <= sc.rx_sent ? p : sc.rx_sent;
+}
+
+/*
+ * Follows data through the RX stream starting at position. Bytes may be
+ * missing in between, after a gap SCENARIO_SYNC_LENGTH bytes (or what is
+ * left of data) have to match again. Shorter parts between two gaps, like
+ * the bytes a read stream still held when the bytes behind them were
+ * dropped, are placed at the first matching byte. Returns false if data
+ * is not an in-order part of the sent RX stream.
+ */
+static bool in_order(const uint8_t *data, const uint32_t count, uint32_t *position) {
+	uint32_t p = *position;
+
+	for(uint32_t i = 0; i < count; i++) {
+		if((p < sc.rx_sent) && (sc.rx_stream[p] == data[i])) {
+			p++;
+			continue;
+		}
+
+		const uint32_t sync = count - i < SCENARIO_SYNC_LENGTH ? count - i : SCENARIO_SYNC_LENGTH;
+		uint32_t next = stream_find(p, &data[i], sync);
+
+		if(next == sc.rx_sent) {
+			next = stream_find(p, &data[i], 1);
+		}
+
+		if(next == sc.rx_sent) {
+			printf("  byte %u of %u received out of order\n", i, count);
+			return false;
+		}
+
+		p = next + 1;
+	}
+
+	*position = p;
+	return true;
+}
+
+static bool scenario_check(const char *name, const bool ok) {
+	GetRXOverflowPolicy request;
+	sim_make_header(&request.header, sizeof(request), FID_GET_RX_OVERFLOW_POLICY, true);
+	sim_host_request(&request, sizeof(request));
+
+	const uint64_t end_ns = sim_now_ns() + SCENARIO_SETTLE_NS;
+	while(!sc.dropped_received && (sim_now_ns() < end_ns)) {
+		sim_main_loop_iteration();
+	}
+
+	bool passed = ok && sc.dropped_received;
+	uint32_t position = 0;
+
+	passed = in_order(sc.rx_received, sc.rx_received_count, &position) && passed;
+
+	// Every response is a contiguous part of the RX stream, behind the one before.
+	position = 0;
+	for(uint32_t i = 0; i < sc.response_num; i++) {
+		const uint32_t start = i == 0 ? 0 : sc.response_end[i - 1];
+		const uint32_t length = sc.response_end[i] - start;
+		uint32_t response_position = position;
+
+		if(!in_order(&sc.responses[start], length, &response_position) ||
+		   (memcmp(&sc.responses[start], &sc.rx_stream[response_position - length], length) != 0)) {
+			printf("  response %u is not a contiguous part of the RX stream\n", i);
+			passed = false;
+		}
+
+		position = response_position;
+	}
+
+	if(sc.rx_received_count + sc.responses_count + sc.dropped != sc.rx_sent) {
+		printf("  %u bytes received, %u in responses and %u dropped, %u sent\n", sc.rx_received_count, sc.responses_count, sc.dropped, sc.rx_sent);
+		passed = false;
+	}
+
+	if((sc.tx_line_errors != 0) || (sc.tx_line_count != sc.tx_written) || (sc.tx_written != sc.tx_length)) {
+		printf("  %u of %u bytes written, %u on the line, %u wrong\n", sc.tx_written, sc.tx_length, sc.tx_line_count, sc.tx_line_errors);
+		passed = false;
+	}
+
+	printf("%s: sent=%u received=%u responses=%u dropped=%u written=%u usic_rx_fifo_overflows=%u %s\n",
+	       name, sc.rx_sent, sc.rx_received_count, sc.response_num, sc.dropped, sc.tx_written,
+	       sim_get_stats()->rx_fifo_overflows, passed ? "ok" : "FAILED");
+
+	return passed;
+}
+
+static void request_buffer_config(const uint16_t receive_buffer_size) {
+	SetBufferConfig request;
+	sim_make_header(&request.header, sizeof(request), FID_SET_BUFFER_CONFIG, false);
+	request.receive_buffer_size = receive_buffer_size;
+	request.send_buffer_size = RS232_BUFFER_SIZE - receive_buffer_size;
+	sim_host_request(&request, sizeof(request));
+}
+
+/*
+ * The host reads with the read callback and writes at about 2/3 of the
+ * line rate, so both ringbuffers are in use whenever the split moves. A
+ * split that can't move yet has to be applied before the next one is
+ * requested.
+ */
+static bool scenario_reconfigure(void) {
+	static const uint16_t receive_buffer_sizes[] = {2048, 8192, 3072, 6144, 1024, 9216, 5120};
+	const uint64_t period_ns = 700 * 1000000ULL;
+	bool ok = true;
+
+	setup(115200, 60000, 50000);
+	sim_request_enable_read_callback();
+
+	uint64_t next_write_ns = sim_now_ns();
+	uint64_t next_config_ns = sim_now_ns() + period_ns;
+	uint32_t config = 0;
+
+	while(!peer_done()) {
+		peer_tick();
+
+		// One chunk every 5 ms.
+		if(sim_now_ns() >= next_write_ns) {
+			write_tick();
+			next_write_ns += 5 * 1000000ULL;
+		}
+
+		if((sim_now_ns() >= next_config_ns) && (config < sizeof(receive_buffer_sizes) / sizeof(uint16_t))) {
+			if((config > 0) && (rs232.rb_rx.size != receive_buffer_sizes[config - 1])) {
+				printf("  receive buffer size %u not applied after 700 ms\n", receive_buffer_sizes[config - 1]);
+				ok = false;
+			}
+
+			request_buffer_config(receive_buffer_sizes[config++]);
+			next_config_ns += period_ns;
+		}
+
+		sim_main_loop_iteration();
+	}
+
+	drain(0);
+
+	if(rs232.rb_rx.size != receive_buffer_sizes[config - 1]) {
+		printf("  receive buffer size %u not applied\n", receive_buffer_sizes[config - 1]);
+		ok = false;
+	}
+
+	return scenario_check("reconfigure", ok);
+}
+
+/*
+ * The host keeps up for half a second, so the RX data has moved away from
+ * the start of the RX part. For the next second it reads one chunk every
+ * 12 ms, about half of what the peer sends. Then it reads and writes with
+ * one request in flight each, the TX buffer fills up while the RX buffer
+ * is emptied.
+ */
+static bool scenario_pool(void) {
+	uint16_t size_max = 0;
+	uint16_t size_min = RS232_BUFFER_SIZE;
+	bool ok = true;
+
+	setup(115200, 40000, 30000);
+
+	SetBufferPoolConfiguration request;
+	sim_make_header(&request.header, sizeof(request), FID_SET_BUFFER_POOL_CONFIGURATION, false);
+	request.enabled = true;
+	request.receive_buffer_minimum = 1024;
+	request.send_buffer_minimum = 1024;
+	sim_host_request(&request, sizeof(request));
+
+	const uint16_t size_initial = rs232.rb_rx.size;
+	const uint64_t slow_start_ns = sim_now_ns() + 500 * 1000000ULL;
+	const uint64_t slow_end_ns = slow_start_ns + 1000 * 1000000ULL;
+	uint64_t next_read_ns = slow_start_ns;
+
+	while(!peer_done()) {
+		peer_tick();
+
+		if(sim_now_ns() < slow_start_ns) {
+			read_tick(0xFFFF);
+		} else if(sim_now_ns() < slow_end_ns) {
+			if(sim_now_ns() >= next_read_ns) {
+				read_tick(60);
+				next_read_ns += 12 * 1000000ULL;
+			}
+		} else {
+			read_tick(0xFFFF);
+			write_tick();
+		}
+
+		sim_main_loop_iteration();
+
+		// The smallest RX part after it grew the most.
+		if(rs232.rb_rx.size > size_max) {
+			size_max = rs232.rb_rx.size;
+			size_min = size_max;
+		} else if(rs232.rb_rx.size < size_min) {
+			size_min = rs232.rb_rx.size;
+		}
+	}
+
+	drain(0xFFFF);
+
+	if((size_max <= size_initial) || (size_min >= size_max)) {
+		printf("  receive buffer started at %u, grew to %u and shrank to %u\n", size_initial, size_max, size_min);
+		ok = false;
+	}
+
+	return scenario_check("pool", ok);
+}
+
+/*
+ * The host reads with the read callback and starts a transaction with a 16
+ * byte response every 40 ms. The callback is held back during a
+ * transaction, so the response is cut out behind the RX data in front of
+ * it while the RX interrupt keeps adding data behind it.
+ */
+static bool scenario_transaction(void) {
+	const uint16_t response_length = 16;
+	bool ok = true;
+
+	setup(115200, 30000, 1000);
+	sim_request_enable_read_callback();
+
+	uint64_t next_transaction_ns = sim_now_ns();
+
+	while(!peer_done()) {
+		peer_tick();
+
+		if(sim_now_ns() >= next_transaction_ns) {
+			transaction_tick(response_length);
+			next_transaction_ns += 40 * 1000000ULL;
+		}
+
+		sim_main_loop_iteration();
+	}
+
+	// The host writes no other data.
+	sc.tx_length = sc.tx_written;
+	drain(0);
+
+	if(sc.response_num < 10) {
+		printf("  only %u transactions\n", sc.response_num);
+		ok = false;
+	}
+
+	for(uint32_t i = 0; i < sc.response_num; i++) {
+		if(sc.response_end[i] - (i == 0 ? 0 : sc.response_end[i - 1]) != response_length) {
+			printf("  response %u is incomplete\n", i);
+			ok = false;
+		}
+	}
+
+	return scenario_check("transaction", ok);
+}
+
+/*
+ * The host reads 600 byte streams, one chunk every 20 ms, about a quarter
+ * of what the peer sends. For one second in the middle it does not read
+ * but starts a transaction every 100 ms: the RX interrupt drops by itself
+ * in between and has to keep the front of the RX buffer during a
+ * transaction. The simulation does not preempt the main loop with the RX
+ * interrupt, at 57600 baud the RX FIFO covers cutting a response out
+ * behind a full RX buffer.
+ */
+static bool scenario_drop_oldest(void) {
+	bool ok = true;
+
+	setup(57600, 40000, 100);
+
+	SetRXOverflowPolicy request;
+	sim_make_header(&request.header, sizeof(request), FID_SET_RX_OVERFLOW_POLICY, false);
+	request.policy = RS232_V2_RX_OVERFLOW_POLICY_DROP_OLDEST;
+	sim_host_request(&request, sizeof(request));
+
+	const uint64_t pause_start_ns = sim_now_ns() + 1000 * 1000000ULL;
+	const uint64_t pause_end_ns = pause_start_ns + 1000 * 1000000ULL;
+	uint64_t next_read_ns = sim_now_ns();
+	uint64_t next_transaction_ns = pause_start_ns;
+	uint32_t dropped_in_stream = 0;
+
+	while(!peer_done()) {
+		peer_tick();
+
+		const bool pause = (sim_now_ns() >= pause_start_ns) && (sim_now_ns() < pause_end_ns) && !sc.read_stream_open;
+
+		if(!pause && (sim_now_ns() >= next_read_ns)) {
+			read_tick(600);
+			next_read_ns += 20 * 1000000ULL;
+		} else if(pause && (sim_now_ns() >= next_transaction_ns)) {
+			transaction_tick(16);
+			next_transaction_ns = sim_now_ns() + 100 * 1000000ULL;
+		}
+
+		const uint32_t dropped = rs232.rx_overflow_dropped_oldest;
+		sim_main_loop_iteration();
+
+		if(rs232.read_stream_status.in_progress) {
+			dropped_in_stream += rs232.rx_overflow_dropped_oldest - dropped;
+		}
+	}
+
+	sc.tx_length = sc.tx_written;
+	drain(0xFFFF);
+
+	if((dropped_in_stream == 0) || (dropped_in_stream == rs232.rx_overflow_dropped_oldest)) {
+		printf("  %u of %u bytes dropped during a read stream\n", dropped_in_stream, rs232.rx_overflow_dropped_oldest);
+		ok = false;
+	}
+
+	return scenario_check("drop_oldest", ok);
+}
+
+static const struct {
+	const char *name;
+	bool (*run)(void);
+} scenarios[] = {
+	{"reconfigure", scenario_reconfigure},
+	{"pool", scenario_pool},
+	{"transaction", scenario_transaction},
+	{"drop_oldest", scenario_drop_oldest},
+};
+
+int main(int argc, char **argv) {
+	int failed = 0;
+
+	for(uint32_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		bool selected = argc < 2;
+
+		for(int j = 1; j < argc; j++) {
+			selected = selected || (strcmp(argv[j], scenarios[i].name) == 0);
+		}
+
+		if(selected && !scenarios[i].run()) {
+			failed++;
+		}
+	}
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,1006 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * sim.c: Virtual CPU, NVIC, GPIO, USIC and serial line
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "xmc_common.h"
+#include "xmc_ccu4.h"
+#include "xmc_eru.h"
+#include "xmc_gpio.h"
+#include "xmc_scu.h"
+#include "xmc_usic.h"
+#include "xmc_uart.h"
+
+#include "bricklib2/bootloader/bootloader.h"
+#include "bricklib2/utility/communication_callback.h"
+
+#include "communication.h"
+#include "modbus.h"
+#include "rs232.h"
+
+#define SIM_NEVER UINT64_MAX
+#define SIM_IRQ_NUM 32
+#define SIM_SR_NUM 6
+#define SIM_CCU4_SR_NUM 4
+#define SIM_CCU4_SLICE_NUM 4
+#define SIM_PEER_QUEUE_SIZE (1 << 16)
+#define SIM_PEER_ERROR_POS 8
+// Start bit, up to 8 data bits, parity bit and stop bit each change the line at most once.
+#define SIM_PEER_EDGE_NUM 11
+
+// Interrupt handlers of rs232.c.
+void IRQ_Hdlr_5(void);
+void IRQ_Hdlr_6(void);
+void IRQ_Hdlr_11(void);
+void IRQ_Hdlr_12(void);
+void IRQ_Hdlr_13(void);
+void IRQ_Hdlr_21(void);
+
+XMC_GPIO_PORT_t sim_gpio_port[5];
+XMC_CCU4_MODULE_t sim_ccu40;
+XMC_ERU_t sim_eru0;
+XMC_CCU4_SLICE_t sim_ccu40_cc4[SIM_CCU4_SLICE_NUM];
+XMC_USIC_CH_t sim_usic0_ch1;
+XMC_USIC_CH_t sim_usic1_ch1;
+
+typedef struct {
+	void (*handler)(void);
+	SimCost *cost;
+} SimIRQ;
+
+typedef struct {
+	SimConfig config;
+	SimStats stats;
+	uint64_t now_ns;
+
+	// Cost model, see sim_execute().
+	uint64_t blocks;
+	uint64_t nested_blocks;
+	uint32_t nested_accesses;
+
+	// NVIC.
+	uint32_t irq_enabled;
+	uint32_t irq_pending;
+	uint8_t irq_priority[SIM_IRQ_NUM];
+	int8_t sr_to_irq[SIM_SR_NUM];
+	int8_t ccu4_sr_to_irq[SIM_CCU4_SR_NUM];
+	int8_t eru_sr_to_irq[SIM_ERU_CHANNEL_NUM];
+	SimIRQ irq[SIM_IRQ_NUM];
+	bool in_irq;
+
+	// Peer to bricklet.
+	uint16_t peer_queue[SIM_PEER_QUEUE_SIZE];
+	uint32_t peer_queue_start;
+	uint32_t peer_queue_used;
+	bool peer_rx_active;
+	uint16_t peer_rx_byte;
+	uint64_t peer_rx_done_ns;
+	uint32_t peer_baudrate;
+	uint64_t peer_edge_ns[SIM_PEER_EDGE_NUM];
+	uint8_t peer_edge_count;
+	uint8_t peer_edge_index;
+	int peer_flowcontrol;
+	bool peer_xoff;
+	bool peer_loopback;
+	uint8_t peer_next_errors;
+	SimLineHook line_rx_hook;
+	void *line_rx_context;
+
+	// Bricklet to peer.
+	bool tx_active;
+	uint8_t tx_byte;
+	uint64_t tx_done_ns;
+	SimLineHook line_tx_hook;
+	void *line_tx_context;
+} Sim;
+
+static Sim sim;
+
+void sim_config_default(SimConfig *config) {
+	config->cpu_hz = 48000000;
+	config->block_cycles = 8;
+	config->access_cycles = 2;
+	config->irq_overhead_cycles = 32;
+	config->bootloader_tick_cycles = 200;
+	config->spitfp_hz = 1400000;
+	config->spitfp_turnaround_ns = 100000;
+}
+
+const SimConfig *sim_get_config(void) {
+	return &sim.config;
+}
+
+uint64_t sim_now_ns(void) {
+	return sim.now_ns;
+}
+
+uint64_t sim_cycles_to_ns(const uint64_t cycles) {
+	return cycles * 1000000000ULL / sim.config.cpu_hz;
+}
+
+// Rate of the baudrate generator, the configured baudrate if FDR was not written.
+static double sim_usic_baudrate(const XMC_USIC_CH_t *usic) {
+	const uint32_t step = (usic->FDR & USIC_CH_FDR_STEP_Msk) >> USIC_CH_FDR_STEP_Pos;
+	double f = sim.config.cpu_hz;
+
+	switch(usic->FDR & USIC_CH_FDR_DM_Msk) {
+		case XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_NORMAL: f /= 1024 - step; break;
+		case XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_FRACTIONAL: f = f * step / 1024; break;
+		default: return usic->baudrate;
+	}
+
+	const uint32_t pdiv = (usic->BRG & USIC_CH_BRG_PDIV_Msk) >> USIC_CH_BRG_PDIV_Pos;
+	const uint32_t dctq = (usic->BRG & USIC_CH_BRG_DCTQ_Msk) >> USIC_CH_BRG_DCTQ_Pos;
+
+	return f / (pdiv + 1) / (dctq + 1);
+}
+
+// Start bit + data bits + optional parity bit + stop bits.
+static uint32_t sim_frame_bits(const XMC_USIC_CH_t *usic) {
+	return 1 + usic->data_bits + (usic->parity_mode != XMC_USIC_CH_PARITY_MODE_NONE ? 1 : 0) + usic->stop_bits;
+}
+
+uint64_t sim_byte_ns(void) {
+	const XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+	const double baudrate = sim_usic_baudrate(usic);
+	if(baudrate <= 0) {
+		return SIM_NEVER;
+	}
+
+	return (uint64_t)(sim_frame_bits(usic) * 1e9 / baudrate + 0.5);
+}
+
+/*
+ * The firmware sources are built with -fsanitize-coverage=trace-pc (see
+ * config_simulation.txt), the compiler calls this at every basic block.
+ */
+void __sanitizer_cov_trace_pc(void) {
+	sim.blocks++;
+}
+
+static void sim_raise_service_request(const uint32_t sr) {
+	if(sr < SIM_SR_NUM && sim.sr_to_irq[sr] >= 0) {
+		sim.irq_pending |= (1 << sim.sr_to_irq[sr]);
+	}
+}
+
+// NVIC.
+
+void NVIC_EnableIRQ(IRQn_Type irqn) {
+	sim.irq_enabled |= (1 << irqn);
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn) {
+	sim.irq_enabled &= ~(1 << irqn);
+}
+
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority) {
+	sim.irq_priority[irqn] = priority;
+}
+
+// SysTick counts down from LOAD once per ms, in step with system_timer_get_ms().
+SysTick_Type *sim_systick(void) {
+	static SysTick_Type systick;
+	const uint64_t ns_in_ms = sim_now_ns() % 1000000;
+
+	systick.LOAD = sim.config.cpu_hz / 1000 - 1;
+	systick.VAL = systick.LOAD - (uint32_t)(ns_in_ms * sim.config.cpu_hz / 1000000000ULL);
+
+	return &systick;
+}
+
+// Interrupts are only dispatched between main loop steps, so SysTick is never pending.
+SCB_Type *sim_scb(void) {
+	static SCB_Type scb;
+
+	scb.ICSR = 0;
+
+	return &scb;
+}
+
+// SCU.
+
+void XMC_SCU_SetInterruptControl(const uint8_t irq_number, const uint32_t source) {
+	if(source & XMC_SCU_IRQCTRL_USIC1_SR_MARK) {
+		sim.sr_to_irq[source & 0xFF] = irq_number;
+	} else if(source & XMC_SCU_IRQCTRL_CCU40_SR_MARK) {
+		sim.ccu4_sr_to_irq[source & 0xFF] = irq_number;
+	} else if(source & XMC_SCU_IRQCTRL_ERU0_SR_MARK) {
+		sim.eru_sr_to_irq[source & 0xFF] = irq_number;
+	}
+}
+
+uint32_t XMC_SCU_CLOCK_GetPeripheralClockFrequency(void) {
+	return sim.config.cpu_hz;
+}
+
+// ERU.
+
+void XMC_ERU_ETL_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_ETL_CONFIG_t *const config) {
+	eru->source[channel] = config->source;
+	eru->input_a[channel] = config->input_a;
+	eru->input_b[channel] = config->input_b;
+	eru->edge_detection[channel] = config->edge_detection;
+	eru->output_trigger_channel[channel] = config->output_trigger_channel;
+	eru->enable_output_trigger[channel] = config->enable_output_trigger;
+	eru->status_flag[channel] = false;
+}
+
+void XMC_ERU_OGU_SetServiceRequestMode(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_OGU_SERVICE_REQUEST_t mode) {
+	eru->service_request[channel] = mode == XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER;
+}
+
+// Pin (bit number of port 2) of the selected ETL input, -1 if not simulated.
+static int8_t sim_eru_pin(const uint8_t channel) {
+	if(sim_eru0.source[channel] == XMC_ERU_ETL_SOURCE_B) {
+		if(channel == 3 && sim_eru0.input_b[channel] == XMC_ERU_ETL_INPUT_B1) {
+			return 10; // CTS, ERU0.3B1.
+		}
+	} else {
+		if(channel == 2 && sim_eru0.input_a[channel] == XMC_ERU_ETL_INPUT_A2) {
+			return 13; // RX, ERU0.2A2.
+		}
+	}
+
+	return -1;
+}
+
+static bool sim_eru_watches_pin(const int8_t pin) {
+	for(uint8_t channel = 0; channel < SIM_ERU_CHANNEL_NUM; channel++) {
+		if(sim_eru0.edge_detection[channel] != XMC_ERU_ETL_EDGE_DETECTION_DISABLED && sim_eru_pin(channel) == pin) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * ERU interrupts are taken at the time of the edge, as if they preempted
+ * the code that is running. The edge timestamps of the baudrate detection
+ * depend on that. Inside of another handler they stay pending.
+ */
+static void sim_execute(void (*fn)(void), SimCost *cost, const uint32_t extra_cycles);
+
+static void sim_eru_edge(const int8_t pin, const bool rising) {
+	for(uint8_t channel = 0; channel < SIM_ERU_CHANNEL_NUM; channel++) {
+		const uint8_t edge = sim_eru0.edge_detection[channel];
+		if(!(edge & (rising ? XMC_ERU_ETL_EDGE_DETECTION_RISING : XMC_ERU_ETL_EDGE_DETECTION_FALLING)) || sim_eru_pin(channel) != pin) {
+			continue;
+		}
+
+		sim_eru0.status_flag[channel] = true;
+
+		const uint8_t ogu = sim_eru0.output_trigger_channel[channel];
+		if(!sim_eru0.enable_output_trigger[channel] || !sim_eru0.service_request[ogu] || sim.eru_sr_to_irq[ogu] < 0) {
+			continue;
+		}
+
+		// Edges during the handler are tail-chained.
+		const int8_t irq = sim.eru_sr_to_irq[ogu];
+		sim.irq_pending |= (1 << irq);
+		if(!sim.in_irq && sim.irq[irq].handler != NULL) {
+			sim.in_irq = true;
+			while((sim.irq_pending & sim.irq_enabled) & (1 << irq)) {
+				sim.irq_pending &= ~(1 << irq);
+				sim_execute(sim.irq[irq].handler, sim.irq[irq].cost, sim.config.irq_overhead_cycles);
+			}
+			sim.in_irq = false;
+		}
+	}
+}
+
+// CCU4.
+
+void XMC_CCU4_Init(XMC_CCU4_MODULE_t *const module, const XMC_CCU4_SLICE_MCMS_ACTION_t mcs_action) {
+}
+
+void XMC_CCU4_StartPrescaler(XMC_CCU4_MODULE_t *const module) {
+}
+
+void XMC_CCU4_EnableClock(XMC_CCU4_MODULE_t *const module, const uint8_t slice_number) {
+}
+
+void XMC_CCU4_EnableShadowTransfer(XMC_CCU4_MODULE_t *const module, const uint32_t shadow_transfer_msk) {
+	for(uint8_t i = 0; i < SIM_CCU4_SLICE_NUM; i++) {
+		if(shadow_transfer_msk & (XMC_CCU4_SHADOW_TRANSFER_SLICE_0 << (4*i))) {
+			sim_ccu40_cc4[i].period = sim_ccu40_cc4[i].period_shadow;
+		}
+	}
+}
+
+void XMC_CCU4_SLICE_CompareInit(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_COMPARE_CONFIG_t *const compare_init) {
+	slice->prescaler = compare_init->prescaler_initval;
+}
+
+static uint64_t sim_ccu4_period_ns(const XMC_CCU4_SLICE_t *const slice) {
+	return ((uint64_t)slice->period + 1) * (1ULL << slice->prescaler) * 1000000000ULL / sim.config.cpu_hz;
+}
+
+void XMC_CCU4_SLICE_StartTimer(XMC_CCU4_SLICE_t *const slice) {
+	if(!slice->running) {
+		slice->running = true;
+		slice->next_period_match_ns = sim.now_ns + sim_ccu4_period_ns(slice);
+	}
+}
+
+void XMC_CCU4_SLICE_StopTimer(XMC_CCU4_SLICE_t *const slice) {
+	slice->running = false;
+}
+
+void XMC_CCU4_SLICE_ClearTimer(XMC_CCU4_SLICE_t *const slice) {
+	if(slice->running) {
+		slice->next_period_match_ns = sim.now_ns + sim_ccu4_period_ns(slice);
+	}
+}
+
+static uint64_t sim_ccu4_next_ns(void) {
+	uint64_t next_ns = SIM_NEVER;
+	for(uint8_t i = 0; i < SIM_CCU4_SLICE_NUM; i++) {
+		if(sim_ccu40_cc4[i].running && sim_ccu40_cc4[i].next_period_match_ns < next_ns) {
+			next_ns = sim_ccu40_cc4[i].next_period_match_ns;
+		}
+	}
+
+	return next_ns;
+}
+
+static void sim_ccu4_period_match(void) {
+	for(uint8_t i = 0; i < SIM_CCU4_SLICE_NUM; i++) {
+		XMC_CCU4_SLICE_t *slice = &sim_ccu40_cc4[i];
+		if(slice->running && slice->next_period_match_ns <= sim.now_ns) {
+			slice->next_period_match_ns += sim_ccu4_period_ns(slice);
+			if((slice->events & (1 << XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH)) && sim.ccu4_sr_to_irq[slice->sr_period_match] >= 0) {
+				sim.irq_pending |= (1 << sim.ccu4_sr_to_irq[slice->sr_period_match]);
+			}
+		}
+	}
+}
+
+// GPIO.
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *const port, const uint8_t pin, const XMC_GPIO_CONFIG_t *const config) {
+	port->mode[pin] = config->mode;
+	if(config->mode & XMC_GPIO_MODE_OUTPUT_PUSH_PULL) {
+		if(config->output_level == XMC_GPIO_OUTPUT_LEVEL_HIGH) {
+			port->out |= (1 << pin);
+		} else {
+			port->out &= ~(1 << pin);
+		}
+	}
+}
+
+// USIC.
+
+static uint8_t sim_fifo_size(const XMC_USIC_CH_FIFO_SIZE_t size) {
+	return size == XMC_USIC_CH_FIFO_DISABLE ? 0 : (1 << size);
+}
+
+static uint32_t sim_usic1_outr_read(void) {
+	XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+	usic->accesses++;
+
+	// Reading an empty FIFO returns the last word again, like the hardware.
+	if(usic->rx_count == 0) {
+		return usic->rx_fifo[(usic->rx_read + SIM_USIC_FIFO_SIZE - 1) % SIM_USIC_FIFO_SIZE];
+	}
+
+	const uint32_t word = usic->rx_fifo[usic->rx_read];
+	usic->rx_read = (usic->rx_read + 1) % SIM_USIC_FIFO_SIZE;
+	usic->rx_count--;
+
+	return word;
+}
+
+void XMC_USIC_CH_TXFIFO_Configure(XMC_USIC_CH_t *const channel, const uint32_t data_pointer, const XMC_USIC_CH_FIFO_SIZE_t size, const uint32_t limit) {
+	channel->accesses++;
+	channel->tx_size = sim_fifo_size(size);
+	channel->tx_limit = limit;
+	channel->tx_read = 0;
+	channel->tx_count = 0;
+}
+
+void XMC_USIC_CH_RXFIFO_Configure(XMC_USIC_CH_t *const channel, const uint32_t data_pointer, const XMC_USIC_CH_FIFO_SIZE_t size, const uint32_t limit) {
+	channel->accesses++;
+	channel->rx_size = sim_fifo_size(size);
+	channel->rx_limit = limit;
+	channel->rx_read = 0;
+	channel->rx_count = 0;
+}
+
+void XMC_USIC_CH_TXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request) {
+	channel->accesses++;
+	if(interrupt_node == XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_STANDARD) {
+		channel->tx_sr_standard = service_request;
+	}
+}
+
+void XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request) {
+	channel->accesses++;
+	if(interrupt_node == XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD) {
+		channel->rx_sr_standard = service_request;
+	} else if(interrupt_node == XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE) {
+		channel->rx_sr_alternate = service_request;
+	}
+}
+
+void XMC_USIC_CH_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request) {
+	channel->accesses++;
+	if(interrupt_node == XMC_USIC_CH_INTERRUPT_NODE_POINTER_ALTERNATE_RECEIVE) {
+		channel->sr_alternate_receive = service_request;
+	} else if(interrupt_node == XMC_USIC_CH_INTERRUPT_NODE_POINTER_PROTOCOL) {
+		channel->sr_protocol = service_request;
+	}
+}
+
+void XMC_USIC_CH_TriggerServiceRequest(XMC_USIC_CH_t *const channel, const uint32_t service_request_line) {
+	channel->accesses++;
+	if(channel == &sim_usic1_ch1) {
+		sim_raise_service_request(service_request_line);
+	}
+}
+
+void XMC_UART_CH_Init(XMC_USIC_CH_t *const channel, const XMC_UART_CH_CONFIG_t *const config) {
+	channel->accesses++;
+	channel->running = false;
+	channel->baudrate = config->baudrate;
+	channel->data_bits = config->data_bits;
+	channel->stop_bits = config->stop_bits;
+	channel->parity_mode = config->parity_mode;
+	channel->oversampling = config->oversampling;
+	channel->FDR = 0;
+	channel->BRG = (config->oversampling - 1) << USIC_CH_BRG_DCTQ_Pos;
+	channel->PCR_ASCMode = (1 << USIC_CH_PCR_ASCMode_SMD_Pos) | (((config->oversampling >> 1) + 1) << USIC_CH_PCR_ASCMode_SP_Pos);
+	channel->rx_events = 0;
+	channel->tx_events = 0;
+	channel->channel_events = 0;
+	channel->tx_start_mode = XMC_USIC_CH_START_TRANSMISION_ON_TDV;
+	if(!sim.tx_active) {
+		channel->psr |= XMC_UART_CH_STATUS_FLAG_TRANSMISSION_IDLE;
+	}
+}
+
+void XMC_UART_CH_SetInputSource(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INPUT_t input, const uint8_t source) {
+	channel->accesses++;
+}
+
+XMC_UART_CH_STATUS_t XMC_UART_CH_Stop(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	channel->running = false;
+
+	return XMC_UART_CH_STATUS_OK;
+}
+
+void XMC_UART_CH_Start(XMC_USIC_CH_t *const channel) {
+	channel->accesses++;
+	channel->running = true;
+}
+
+// Serial line.
+
+static bool sim_peer_may_send(void) {
+	if(sim.peer_queue_used == 0) {
+		return false;
+	}
+
+	switch(sim.peer_flowcontrol) {
+		case SIM_PEER_FLOWCONTROL_SOFTWARE: return !sim.peer_xoff;
+		case SIM_PEER_FLOWCONTROL_HARDWARE: return sim_rts_asserted();
+		default: return true;
+	}
+}
+
+static void sim_line_rx_done(void) {
+	XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+
+	sim.stats.rx_line_bytes++;
+	sim.peer_rx_active = false;
+
+	if(!usic->running) {
+		return;
+	}
+
+	if(sim.line_rx_hook != NULL) {
+		sim.line_rx_hook(sim.peer_rx_byte & 0xFF, sim.now_ns, sim.line_rx_context);
+	}
+
+	const uint8_t errors = sim.peer_rx_byte >> SIM_PEER_ERROR_POS;
+	uint32_t psr = 0;
+
+	if(errors & SIM_LINE_ERROR_FRAMING) {
+		psr |= XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0;
+	}
+	if(errors & SIM_LINE_ERROR_BREAK) {
+		psr |= XMC_UART_CH_STATUS_FLAG_SYNCHRONIZATION_BREAK_DETECTED | XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0;
+	}
+	if(errors & SIM_LINE_ERROR_NOISE) {
+		psr |= XMC_UART_CH_STATUS_FLAG_RECEIVER_NOISE_DETECTED;
+	}
+
+	if(usic->rx_count == usic->rx_size) {
+		usic->rx_fifo_overflows++;
+		sim.stats.rx_fifo_overflows++;
+		psr |= XMC_UART_CH_STATUS_FLAG_DATA_LOST_INDICATION;
+	}
+	else {
+		// A break is received as a 0 word. RCI[4] is the parity error flag.
+		const uint32_t data = (errors & SIM_LINE_ERROR_BREAK) ? 0 : (sim.peer_rx_byte & 0xFF);
+		const uint32_t rci = (errors & SIM_LINE_ERROR_PARITY) ? (1 << (USIC_CH_OUTR_RCI_Pos + 4)) : 0;
+
+		usic->rx_fifo[(usic->rx_read + usic->rx_count) % SIM_USIC_FIFO_SIZE] = data | rci;
+		usic->rx_count++;
+
+		// Standard RX FIFO event if the filling level exceeds the limit.
+		if((usic->rx_count == usic->rx_limit + 1) && (usic->rx_events & XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD)) {
+			sim_raise_service_request(usic->rx_sr_standard);
+		}
+
+		if(errors & SIM_LINE_ERROR_PARITY) {
+			usic->psr |= XMC_UART_CH_STATUS_FLAG_ALTERNATIVE_RECEIVE_INDICATION;
+			if(usic->channel_events & XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE) {
+				sim_raise_service_request(usic->sr_alternate_receive);
+			}
+		}
+	}
+
+	// Protocol events, each flag can trigger the protocol service request.
+	usic->psr |= psr;
+	if(((psr & XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0) && (usic->channel_events & XMC_UART_CH_EVENT_FORMAT_ERROR)) ||
+	   ((psr & XMC_UART_CH_STATUS_FLAG_SYNCHRONIZATION_BREAK_DETECTED) && (usic->channel_events & XMC_UART_CH_EVENT_SYNCHRONIZATION_BREAK)) ||
+	   ((psr & XMC_UART_CH_STATUS_FLAG_RECEIVER_NOISE_DETECTED) && (usic->channel_events & XMC_UART_CH_EVENT_RECEIVER_NOISE)) ||
+	   ((psr & XMC_UART_CH_STATUS_FLAG_DATA_LOST_INDICATION) && (usic->channel_events & XMC_UART_CH_EVENT_DATA_LOST))) {
+		sim_raise_service_request(usic->sr_protocol);
+	}
+}
+
+static void sim_line_tx_done(void) {
+	sim.stats.tx_line_bytes++;
+	sim.tx_active = false;
+	sim_usic1_ch1.psr |= XMC_UART_CH_STATUS_FLAG_TRANSMISSION_IDLE;
+
+	if(sim.peer_flowcontrol == SIM_PEER_FLOWCONTROL_SOFTWARE) {
+		if(sim.tx_byte == FC_SW_XOFF) {
+			sim.peer_xoff = true;
+		} else if(sim.tx_byte == FC_SW_XON) {
+			sim.peer_xoff = false;
+		}
+	}
+
+	if(sim.line_tx_hook != NULL) {
+		sim.line_tx_hook(sim.tx_byte, sim.now_ns, sim.line_tx_context);
+	}
+
+	if(sim.peer_loopback) {
+		sim_peer_send(&sim.tx_byte, 1);
+	}
+}
+
+// The peer sends with the exact configured baudrate, unless it has its own.
+static uint32_t sim_peer_baudrate(void) {
+	return sim.peer_baudrate != 0 ? sim.peer_baudrate : sim_usic1_ch1.baudrate;
+}
+
+// Like sim_byte_ns(), but with the baudrate of the peer.
+static uint64_t sim_peer_byte_ns(void) {
+	const uint32_t baudrate = sim_peer_baudrate();
+	if(baudrate == 0) {
+		return SIM_NEVER;
+	}
+
+	return (sim_frame_bits(&sim_usic1_ch1) * 1000000000ULL + baudrate - 1) / baudrate;
+}
+
+/*
+ * Starts the next byte of the peer. If the baudrate of the peer and the
+ * rate of the bricklet differ by more than 2.5% the byte is received with a
+ * framing error. The single edges on the RX pin are only generated if the
+ * ERU watches it.
+ */
+static void sim_peer_start_byte(void) {
+	const XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+
+	sim.peer_rx_active = true;
+	sim.peer_rx_byte = sim.peer_queue[sim.peer_queue_start];
+	sim.peer_rx_done_ns = sim.now_ns + sim_peer_byte_ns();
+	sim.peer_queue_start = (sim.peer_queue_start + 1) % SIM_PEER_QUEUE_SIZE;
+	sim.peer_queue_used--;
+	sim.peer_edge_count = 0;
+	sim.peer_edge_index = 0;
+
+	const double rate = sim_usic_baudrate(usic);
+	const double diff = sim_peer_baudrate() - rate;
+	if((rate > 0) && ((diff < 0 ? -diff : diff) * 40 > rate)) {
+		sim.peer_rx_byte |= SIM_LINE_ERROR_FRAMING << SIM_PEER_ERROR_POS;
+	}
+
+	if(!sim_eru_watches_pin(13)) {
+		return;
+	}
+
+	const uint32_t baudrate = sim_peer_baudrate();
+	const uint8_t data = sim.peer_rx_byte & 0xFF;
+	uint8_t levels[SIM_PEER_EDGE_NUM];
+	uint8_t bits = 0;
+
+	levels[bits++] = 0;
+	for(uint8_t i = 0; i < usic->data_bits; i++) {
+		levels[bits++] = (data >> i) & 1;
+	}
+	if(usic->parity_mode != XMC_USIC_CH_PARITY_MODE_NONE) {
+		levels[bits++] = (__builtin_popcount(data & ((1 << usic->data_bits) - 1)) & 1) ^ (usic->parity_mode == XMC_USIC_CH_PARITY_MODE_ODD ? 1 : 0);
+	}
+	levels[bits++] = 1;
+
+	uint8_t level = 1;
+	for(uint8_t i = 0; i < bits; i++) {
+		if(levels[i] != level) {
+			level = levels[i];
+			sim.peer_edge_ns[sim.peer_edge_count++] = sim.now_ns + i * 1000000000ULL / baudrate;
+		}
+	}
+}
+
+// Edges alternate, starting with the falling edge of the start bit.
+static void sim_peer_edge(void) {
+	const bool rising = sim.peer_edge_index & 1;
+
+	sim.peer_edge_index++;
+	if(rising) {
+		sim_gpio_port[2].in |= (1 << 13);
+	} else {
+		sim_gpio_port[2].in &= ~(1 << 13);
+	}
+
+	sim_eru_edge(13, rising);
+}
+
+// Moves the virtual time forward, the line keeps running while the CPU is busy.
+static void sim_advance(const uint64_t duration_ns) {
+	const uint64_t target_ns = sim.now_ns + duration_ns;
+	XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+
+	while(true) {
+		if(!sim.peer_rx_active && sim_peer_may_send()) {
+			sim_peer_start_byte();
+		}
+
+		if(!sim.tx_active && usic->running && usic->tx_start_mode != XMC_USIC_CH_START_TRANSMISION_DISABLED && usic->tx_count > 0) {
+			sim.tx_active = true;
+			usic->psr &= ~XMC_UART_CH_STATUS_FLAG_TRANSMISSION_IDLE;
+			sim.tx_byte = usic->tx_fifo[usic->tx_read];
+			sim.tx_done_ns = sim.now_ns + sim_byte_ns();
+			usic->tx_read = (usic->tx_read + 1) % SIM_USIC_FIFO_SIZE;
+			usic->tx_count--;
+
+			// Standard TX FIFO event if the filling level falls below the limit.
+			if((usic->tx_count == usic->tx_limit - 1) && (usic->tx_events & XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD)) {
+				sim_raise_service_request(usic->tx_sr_standard);
+			}
+		}
+
+		const uint64_t rx_ns = sim.peer_rx_active ? sim.peer_rx_done_ns : SIM_NEVER;
+		const uint64_t tx_ns = sim.tx_active ? sim.tx_done_ns : SIM_NEVER;
+		const uint64_t timer_ns = sim_ccu4_next_ns();
+		const uint64_t edge_ns = (sim.peer_rx_active && sim.peer_edge_index < sim.peer_edge_count) ? sim.peer_edge_ns[sim.peer_edge_index] : SIM_NEVER;
+		uint64_t next_ns = rx_ns < tx_ns ? rx_ns : tx_ns;
+		if(timer_ns < next_ns) {
+			next_ns = timer_ns;
+		}
+		if(edge_ns <= next_ns) {
+			next_ns = edge_ns;
+		}
+
+		if(next_ns > target_ns) {
+			break;
+		}
+
+		sim.now_ns = next_ns;
+		if(next_ns == edge_ns) {
+			sim_peer_edge();
+		} else if(next_ns == rx_ns) {
+			sim_line_rx_done();
+		} else if(next_ns == tx_ns) {
+			sim_line_tx_done();
+		} else {
+			sim_ccu4_period_match();
+		}
+	}
+
+	// A preempting ERU interrupt may have moved the time past the target.
+	if(sim.now_ns < target_ns) {
+		sim.now_ns = target_ns;
+	}
+}
+
+/*
+ * Runs fn and counts the basic blocks and USIC register accesses it executes.
+ * Interrupts that run nested inside fn (ERU edges) are charged to themselves,
+ * not to fn.
+ */
+static void sim_count(void (*fn)(void), uint64_t *blocks, uint32_t *accesses) {
+	const uint64_t blocks_start = sim.blocks;
+	const uint32_t accesses_start = sim_usic1_ch1.accesses;
+	const uint64_t nested_blocks_start = sim.nested_blocks;
+	const uint32_t nested_accesses_start = sim.nested_accesses;
+
+	fn();
+
+	const uint64_t blocks_total = sim.blocks - blocks_start;
+	const uint32_t accesses_total = sim_usic1_ch1.accesses - accesses_start;
+
+	*blocks = blocks_total - (sim.nested_blocks - nested_blocks_start);
+	*accesses = accesses_total - (sim.nested_accesses - nested_accesses_start);
+
+	sim.nested_blocks = nested_blocks_start + blocks_total;
+	sim.nested_accesses = nested_accesses_start + accesses_total;
+}
+
+static uint64_t sim_cost_cycles(const uint64_t blocks, const uint32_t accesses) {
+	return blocks * sim.config.block_cycles + (uint64_t)accesses * sim.config.access_cycles;
+}
+
+/*
+ * Runs fn and charges a fixed number of cycles per executed basic block
+ * and per USIC register access. The cost only depends on the code path,
+ * so a run is reproducible on every host.
+ */
+static void sim_execute(void (*fn)(void), SimCost *cost, const uint32_t extra_cycles) {
+	uint64_t blocks;
+	uint32_t accesses;
+
+	sim_count(fn, &blocks, &accesses);
+
+	const uint64_t cycles = sim_cost_cycles(blocks, accesses) + extra_cycles;
+
+	cost->calls++;
+	cost->cycles += cycles;
+	cost->blocks += blocks;
+	cost->accesses += accesses;
+	if(cycles > cost->cycles_max) {
+		cost->cycles_max = cycles;
+	}
+
+	sim_advance(sim_cycles_to_ns(cycles));
+}
+
+static void sim_dispatch_irqs(void) {
+	if(sim.in_irq) {
+		return;
+	}
+
+	sim.in_irq = true;
+	while(sim.irq_pending & sim.irq_enabled) {
+		const uint32_t active = sim.irq_pending & sim.irq_enabled;
+
+		// Lowest priority value first, lowest IRQ number on equal priority.
+		int irq = -1;
+		for(int i = 0; i < SIM_IRQ_NUM; i++) {
+			if((active & (1 << i)) && (irq < 0 || sim.irq_priority[i] < sim.irq_priority[irq])) {
+				irq = i;
+			}
+		}
+
+		sim.irq_pending &= ~(1 << irq);
+		if(sim.irq[irq].handler != NULL) {
+			sim_execute(sim.irq[irq].handler, sim.irq[irq].cost, sim.config.irq_overhead_cycles);
+		}
+	}
+	sim.in_irq = false;
+}
+
+static void sim_bootloader_tick(void) {
+	bootloader_tick();
+}
+
+void sim_main_loop_iteration(void) {
+	sim_dispatch_irqs();
+	sim_execute(rs232_tick, &sim.stats.rs232_tick, 0);
+	sim_dispatch_irqs();
+	sim_execute(modbus_tick, &sim.stats.modbus_tick, 0);
+	sim_dispatch_irqs();
+	sim_execute(sim_bootloader_tick, &sim.stats.bootloader_tick, sim.config.bootloader_tick_cycles);
+	sim_dispatch_irqs();
+	sim_execute(communication_tick, &sim.stats.communication_tick, 0);
+	sim.stats.main_loop_iterations++;
+}
+
+void sim_run_for(const uint64_t duration_ns) {
+	const uint64_t end_ns = sim.now_ns + duration_ns;
+	while(sim.now_ns < end_ns) {
+		sim_main_loop_iteration();
+	}
+}
+
+// Measures a single call without advancing the virtual time.
+uint32_t sim_measure_cycles(void (*fn)(void), uint32_t *accesses) {
+	uint64_t blocks;
+	uint32_t call_accesses;
+
+	sim_count(fn, &blocks, &call_accesses);
+
+	if(accesses != NULL) {
+		*accesses = call_accesses;
+	}
+
+	return sim_cost_cycles(blocks, call_accesses);
+}
+
+void sim_usic_rx_push(const uint8_t *data, const uint8_t length) {
+	XMC_USIC_CH_t *usic = &sim_usic1_ch1;
+	for(uint8_t i = 0; i < length && usic->rx_count < usic->rx_size; i++) {
+		usic->rx_fifo[(usic->rx_read + usic->rx_count) % SIM_USIC_FIFO_SIZE] = data[i];
+		usic->rx_count++;
+	}
+}
+
+void sim_usic_tx_clear(void) {
+	sim_usic1_ch1.tx_read = 0;
+	sim_usic1_ch1.tx_count = 0;
+}
+
+// Peer.
+
+void sim_peer_send(const uint8_t *data, const uint32_t length) {
+	for(uint32_t i = 0; i < length && sim.peer_queue_used < SIM_PEER_QUEUE_SIZE; i++) {
+		uint16_t word = data[i];
+		word |= sim.peer_next_errors << SIM_PEER_ERROR_POS;
+		sim.peer_next_errors = 0;
+
+		sim.peer_queue[(sim.peer_queue_start + sim.peer_queue_used) % SIM_PEER_QUEUE_SIZE] = word;
+		sim.peer_queue_used++;
+	}
+}
+
+uint32_t sim_peer_send_pending(void) {
+	return sim.peer_queue_used + (sim.peer_rx_active ? 1 : 0);
+}
+
+void sim_peer_set_flowcontrol(const int mode) {
+	sim.peer_flowcontrol = mode;
+	sim.peer_xoff = false;
+}
+
+void sim_peer_set_cts(const bool asserted) {
+	// CTS input reads 0 if the peer asserts it (RS232 logic 0).
+	const bool was_asserted = !(sim_gpio_port[2].in & (1 << 10));
+	if(asserted) {
+		sim_gpio_port[2].in &= ~(1 << 10);
+	} else {
+		sim_gpio_port[2].in |= (1 << 10);
+	}
+
+	if(asserted != was_asserted) {
+		sim_eru_edge(10, !asserted);
+	}
+}
+
+void sim_peer_set_baudrate(const uint32_t baudrate) {
+	sim.peer_baudrate = baudrate;
+}
+
+void sim_peer_set_loopback(const bool loopback) {
+	sim.peer_loopback = loopback;
+}
+
+void sim_peer_inject_parity_error(void) {
+	sim_peer_inject_line_error(SIM_LINE_ERROR_PARITY);
+}
+
+void sim_peer_inject_line_error(const uint8_t errors) {
+	sim.peer_next_errors |= errors;
+}
+
+bool sim_rts_asserted(void) {
+	// RTS output low is RS232 logic 1 (asserted).
+	return (sim_gpio_port[2].out & (1 << 11)) == 0;
+}
+
+void sim_set_line_rx_hook(SimLineHook hook, void *context) {
+	sim.line_rx_hook = hook;
+	sim.line_rx_context = context;
+}
+
+void sim_set_line_tx_hook(SimLineHook hook, void *context) {
+	sim.line_tx_hook = hook;
+	sim.line_tx_context = context;
+}
+
+void sim_make_header(TFPMessageHeader *header, const uint8_t length, const uint8_t fid, const bool return_expected) {
+	tfp_make_default_header(header, SIM_UID, length, fid);
+	header->return_expected = return_expected;
+}
+
+bool sim_request_configuration(const uint32_t baudrate, const uint8_t flowcontrol) {
+	SetConfiguration request;
+	sim_make_header(&request.header, sizeof(request), FID_SET_CONFIGURATION, false);
+	request.baudrate = baudrate;
+	request.parity = RS232_V2_PARITY_NONE;
+	request.stopbits = RS232_V2_STOPBITS_1;
+	request.wordlength = RS232_V2_WORDLENGTH_8;
+	request.flowcontrol = flowcontrol;
+
+	return sim_host_request(&request, sizeof(request));
+}
+
+bool sim_request_enable_read_callback(void) {
+	EnableReadCallback request;
+	sim_make_header(&request.header, sizeof(request), FID_ENABLE_READ_CALLBACK, false);
+
+	return sim_host_request(&request, sizeof(request));
+}
+
+bool sim_request_write(const uint8_t *data, const uint8_t length) {
+	WriteLowLevel request;
+	sim_make_header(&request.header, sizeof(request), FID_WRITE_LOW_LEVEL, true);
+	request.message_length = length;
+	request.message_chunk_offset = 0;
+	memset(request.message_chunk_data, 0, sizeof(request.message_chunk_data));
+	memcpy(request.message_chunk_data, data, length);
+
+	return sim_host_request(&request, sizeof(request));
+}
+
+const SimStats *sim_get_stats(void) {
+	return &sim.stats;
+}
+
+void sim_reset_stats(void) {
+	memset(&sim.stats, 0, sizeof(SimStats));
+}
+
+void sim_count_spitfp_message(const uint8_t length) {
+	sim.stats.spitfp_messages++;
+	sim.stats.spitfp_bytes += length;
+}
+
+void sim_init(const SimConfig *config) {
+	memset(&sim, 0, sizeof(Sim));
+	memset(sim_gpio_port, 0, sizeof(sim_gpio_port));
+	sim_gpio_port[2].in |= (1 << 13); // RX idle.
+	memset(&sim_usic0_ch1, 0, sizeof(XMC_USIC_CH_t));
+	memset(&sim_usic1_ch1, 0, sizeof(XMC_USIC_CH_t));
+	sim_usic1_ch1.outr_read = sim_usic1_outr_read;
+	memset(&sim_ccu40_cc4, 0, sizeof(sim_ccu40_cc4));
+	memset(sim.sr_to_irq, -1, sizeof(sim.sr_to_irq));
+	memset(sim.ccu4_sr_to_irq, -1, sizeof(sim.ccu4_sr_to_irq));
+	memset(&sim_eru0, 0, sizeof(XMC_ERU_t));
+	memset(sim.eru_sr_to_irq, -1, sizeof(sim.eru_sr_to_irq));
+
+	sim.config = *config;
+	sim.irq[RS232_IRQ_RX]  = (SimIRQ){IRQ_Hdlr_11, &sim.stats.rx_irq};
+	sim.irq[RS232_IRQ_TX]  = (SimIRQ){IRQ_Hdlr_12, &sim.stats.tx_irq};
+	sim.irq[RS232_IRQ_RXA] = (SimIRQ){IRQ_Hdlr_13, &sim.stats.rxa_irq};
+	sim.irq[RS232_IRQ_FRAME_GAP] = (SimIRQ){IRQ_Hdlr_21, &sim.stats.frame_gap_irq};
+	sim.irq[RS232_IRQ_CTS] = (SimIRQ){IRQ_Hdlr_5, &sim.stats.cts_irq};
+	sim.irq[RS232_IRQ_RX_EDGE] = (SimIRQ){IRQ_Hdlr_6, &sim.stats.rx_edge_irq};
+
+	// Peer asserts CTS by default.
+	sim_peer_set_cts(true);
+
+	sim_bricklib2_init();
+	communication_init();
+	rs232_init();
+	modbus_init();
+	sim_reset_stats();
+}
@@ -0,0 +1,134 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * sim.h: Host-side simulation of the RS232 V2 Bricklet
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bricklib2/protocols/tfp/tfp.h"
+
+#define SIM_UID 0x12345678
+
+#define SIM_PEER_FLOWCONTROL_OFF      0
+#define SIM_PEER_FLOWCONTROL_SOFTWARE 1
+#define SIM_PEER_FLOWCONTROL_HARDWARE 2
+
+#define SIM_LINE_ERROR_PARITY  (1 << 0)
+#define SIM_LINE_ERROR_FRAMING (1 << 1)
+#define SIM_LINE_ERROR_BREAK   (1 << 2)
+#define SIM_LINE_ERROR_NOISE   (1 << 3)
+
+typedef struct {
+	uint32_t cpu_hz;                    // Virtual CPU clock (XMC1400 runs at 48 MHz).
+	uint32_t block_cycles;              // Cycles charged per executed basic block of the firmware.
+	uint32_t access_cycles;             // Extra cycles charged per USIC register access (peripheral bus).
+	uint32_t irq_overhead_cycles;       // Cortex-M0 exception entry and exit.
+	uint32_t bootloader_tick_cycles;    // SPITFP servicing in bootloader_tick(), not executed on the host.
+	uint32_t spitfp_hz;                 // SPI clock between Brick and Bricklet.
+	uint32_t spitfp_turnaround_ns;      // Per message overhead of the SPITFP link (ACK, polling).
+} SimConfig;
+
+typedef struct {
+	uint32_t calls;
+	uint64_t cycles;
+	uint32_t cycles_max;
+	uint64_t blocks;                    // Executed basic blocks.
+	uint64_t accesses;                  // USIC register accesses.
+} SimCost;
+
+typedef struct {
+	uint64_t rx_line_bytes;             // Bytes sent by the peer.
+	uint64_t tx_line_bytes;             // Bytes sent by the bricklet.
+	uint32_t rx_fifo_overflows;         // Bytes lost because the USIC RX FIFO was full.
+
+	SimCost rx_irq;
+	SimCost tx_irq;
+	SimCost rxa_irq;
+	SimCost frame_gap_irq;
+	SimCost cts_irq;
+	SimCost rx_edge_irq;
+	SimCost rs232_tick;
+	SimCost modbus_tick;
+	SimCost bootloader_tick;
+	SimCost communication_tick;
+
+	uint64_t spitfp_messages;
+	uint64_t spitfp_bytes;
+	uint64_t main_loop_iterations;
+} SimStats;
+
+typedef void (*SimLineHook)(const uint8_t byte, const uint64_t now_ns, void *context);
+typedef void (*SimSPITFPHook)(const uint8_t *data, const uint8_t length, const uint64_t now_ns, void *context);
+
+void sim_config_default(SimConfig *config);
+void sim_init(const SimConfig *config);
+const SimConfig *sim_get_config(void);
+
+uint64_t sim_now_ns(void);
+uint64_t sim_cycles_to_ns(const uint64_t cycles);
+uint64_t sim_byte_ns(void);
+
+void sim_main_loop_iteration(void);
+void sim_run_for(const uint64_t duration_ns);
+
+// Direct access for measuring single handler calls.
+uint32_t sim_measure_cycles(void (*fn)(void), uint32_t *accesses);
+void sim_usic_rx_push(const uint8_t *data, const uint8_t length);
+void sim_usic_tx_clear(void);
+
+// Peer on the other end of the serial line.
+void sim_peer_send(const uint8_t *data, const uint32_t length);
+uint32_t sim_peer_send_pending(void);
+void sim_peer_set_flowcontrol(const int mode);
+void sim_peer_set_cts(const bool asserted);
+void sim_peer_set_baudrate(const uint32_t baudrate); // 0 = baudrate of the bricklet.
+void sim_peer_set_loopback(const bool loopback);
+void sim_peer_inject_parity_error(void);
+void sim_peer_inject_line_error(const uint8_t errors);
+bool sim_rts_asserted(void);
+void sim_set_line_rx_hook(SimLineHook hook, void *context);
+void sim_set_line_tx_hook(SimLineHook hook, void *context);
+
+// Host on the other end of the SPITFP link.
+bool sim_host_request(const void *message, const uint8_t length);
+uint32_t sim_host_request_pending(void);
+void sim_set_spitfp_hook(SimSPITFPHook hook, void *context);
+
+// Requests like the bindings send them, false if the host queue is full.
+void sim_make_header(TFPMessageHeader *header, const uint8_t length, const uint8_t fid, const bool return_expected);
+bool sim_request_configuration(const uint32_t baudrate, const uint8_t flowcontrol);
+bool sim_request_enable_read_callback(void);
+bool sim_request_write(const uint8_t *data, const uint8_t length); // One write_low_level chunk of up to 60 bytes.
+
+// Emulated EEPROM of the bootloader, kept across sim_init().
+void sim_eeprom_erase(void);
+uint32_t sim_eeprom_write_count(void);
+
+const SimStats *sim_get_stats(void);
+void sim_reset_stats(void);
+
+// Used by the bricklib2 stand-ins in sim_bricklib2.c.
+void sim_bricklib2_init(void);
+void sim_count_spitfp_message(const uint8_t length);
+
+#endif
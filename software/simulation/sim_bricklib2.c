@@ -0,0 +1,260 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * sim_bricklib2.c: bricklib2 stand-ins for the host (bootloader, SPITFP, TFP, timer)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "sim.h"
+
+#include <string.h>
+
+#include "bricklib2/bootloader/bootloader.h"
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/protocols/tfp/tfp.h"
+#include "bricklib2/utility/communication_callback.h"
+
+#include "communication.h"
+
+#define SIM_TFP_MESSAGE_SIZE 80
+#define SIM_HOST_QUEUE_SIZE 16
+#define SIM_SPITFP_PROTOCOL_OVERHEAD 3
+#define SIM_EEPROM_PAGES 4 // BOOTLOADER_FLASH_EEPROM_SIZE / EEPROM_PAGE_SIZE
+
+#define SIM_TFP_ERROR_INVALID_PARAMETER 1
+#define SIM_TFP_ERROR_NOT_SUPPORTED 2
+
+typedef struct {
+	uint8_t data[SIM_TFP_MESSAGE_SIZE];
+	uint8_t length;
+	uint64_t arrival_ns;
+} SimHostMessage;
+
+BootloaderStatus bootloader_status;
+
+static SimHostMessage sim_host_queue[SIM_HOST_QUEUE_SIZE];
+static uint32_t sim_host_queue_start;
+static uint32_t sim_host_queue_used;
+static uint64_t sim_spitfp_rx_free_ns; // Brick to bricklet.
+static uint64_t sim_spitfp_tx_free_ns; // Bricklet to Brick.
+static SimSPITFPHook sim_spitfp_hook;
+static void *sim_spitfp_context;
+
+// Survives sim_init(), like the flash survives a restart of the bricklet.
+static uint8_t sim_eeprom[SIM_EEPROM_PAGES][EEPROM_PAGE_SIZE];
+static bool sim_eeprom_valid;
+static uint32_t sim_eeprom_writes;
+
+static uint32_t communication_callback_last_ms;
+static uint8_t communication_callback_index;
+static bool (*const communication_callbacks[COMMUNICATION_CALLBACK_HANDLER_NUM])(void) = {
+	COMMUNICATION_CALLBACK_LIST_INIT
+};
+
+void sim_bricklib2_init(void) {
+	memset(&bootloader_status, 0, sizeof(BootloaderStatus));
+	sim_host_queue_start = 0;
+	sim_host_queue_used = 0;
+	sim_spitfp_rx_free_ns = 0;
+	sim_spitfp_tx_free_ns = 0;
+	sim_spitfp_hook = NULL;
+	sim_spitfp_context = NULL;
+}
+
+/*
+ * SPITFP is full duplex. Each direction carries one message at a time and
+ * is occupied for its transfer time plus ACK/polling overhead.
+ */
+static uint64_t sim_spitfp_transfer_ns(const uint8_t length) {
+	const SimConfig *config = sim_get_config();
+	const uint64_t bits = (length + SIM_SPITFP_PROTOCOL_OVERHEAD) * 8ULL;
+
+	return bits * 1000000000ULL / config->spitfp_hz + config->spitfp_turnaround_ns;
+}
+
+bool sim_host_request(const void *message, const uint8_t length) {
+	if(sim_host_queue_used == SIM_HOST_QUEUE_SIZE || length > SIM_TFP_MESSAGE_SIZE) {
+		return false;
+	}
+
+	SimHostMessage *m = &sim_host_queue[(sim_host_queue_start + sim_host_queue_used) % SIM_HOST_QUEUE_SIZE];
+	memcpy(m->data, message, length);
+	m->length = length;
+	m->arrival_ns = (sim_spitfp_rx_free_ns > sim_now_ns() ? sim_spitfp_rx_free_ns : sim_now_ns()) + sim_spitfp_transfer_ns(length);
+	sim_spitfp_rx_free_ns = m->arrival_ns;
+	sim_host_queue_used++;
+
+	return true;
+}
+
+uint32_t sim_host_request_pending(void) {
+	return sim_host_queue_used;
+}
+
+void sim_set_spitfp_hook(SimSPITFPHook hook, void *context) {
+	sim_spitfp_hook = hook;
+	sim_spitfp_context = context;
+}
+
+// Bootloader.
+
+void bootloader_tick(void) {
+	// The bootloader only takes a request if the response can be sent.
+	if(sim_host_queue_used == 0 ||
+	   sim_now_ns() < sim_host_queue[sim_host_queue_start].arrival_ns ||
+	   !bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		return;
+	}
+
+	SimHostMessage *request = &sim_host_queue[sim_host_queue_start];
+	sim_host_queue_start = (sim_host_queue_start + 1) % SIM_HOST_QUEUE_SIZE;
+	sim_host_queue_used--;
+
+	// Like the bootloader, the response starts as a copy of the request header.
+	uint8_t response[SIM_TFP_MESSAGE_SIZE] = {0};
+	memcpy(response, request->data, sizeof(TFPMessageHeader));
+	TFPMessageHeader *header = (TFPMessageHeader*)response;
+	header->length = sizeof(TFPMessageHeader);
+
+	bool send = tfp_is_return_expected(request->data);
+	switch(handle_message(request->data, response)) {
+		case HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE: send = true; break;
+		case HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED: header->error = SIM_TFP_ERROR_NOT_SUPPORTED; break;
+		case HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER: header->error = SIM_TFP_ERROR_INVALID_PARAMETER; break;
+		case HANDLE_MESSAGE_RESPONSE_NONE: send = false; break;
+		default: break;
+	}
+
+	if(send) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, response, header->length);
+	}
+}
+
+uint32_t bootloader_get_uid(void) {
+	return SIM_UID;
+}
+
+bool bootloader_spitfp_is_send_possible(SPITFP *st) {
+	return sim_now_ns() >= sim_spitfp_tx_free_ns;
+}
+
+void bootloader_spitfp_send_ack_and_message(BootloaderStatus *bootloader_status, uint8_t *data, const uint8_t length) {
+	sim_count_spitfp_message(length);
+	if(sim_spitfp_hook != NULL) {
+		sim_spitfp_hook(data, length, sim_now_ns(), sim_spitfp_context);
+	}
+
+	sim_spitfp_tx_free_ns = sim_now_ns() + sim_spitfp_transfer_ns(length);
+}
+
+void bootloader_read_eeprom_page(const uint32_t page_num, uint32_t *data) {
+	if(!sim_eeprom_valid) {
+		sim_eeprom_erase();
+	}
+
+	if(page_num >= SIM_EEPROM_PAGES) {
+		memset(data, 0xFF, EEPROM_PAGE_SIZE);
+		return;
+	}
+
+	memcpy(data, sim_eeprom[page_num], EEPROM_PAGE_SIZE);
+}
+
+bool bootloader_write_eeprom_page(const uint32_t page_num, uint32_t *data) {
+	if(page_num >= SIM_EEPROM_PAGES) {
+		return false;
+	}
+
+	if(!sim_eeprom_valid) {
+		sim_eeprom_erase();
+	}
+
+	memcpy(sim_eeprom[page_num], data, EEPROM_PAGE_SIZE);
+	sim_eeprom_writes++;
+
+	return true;
+}
+
+void sim_eeprom_erase(void) {
+	memset(sim_eeprom, 0xFF, sizeof(sim_eeprom));
+	sim_eeprom_valid = true;
+}
+
+uint32_t sim_eeprom_write_count(void) {
+	return sim_eeprom_writes;
+}
+
+// System timer.
+
+uint32_t system_timer_get_ms(void) {
+	return (uint32_t)(sim_now_ns() / 1000000);
+}
+
+bool system_timer_is_time_elapsed_ms(const uint32_t start_measurement, const uint32_t time_to_be_elapsed) {
+	return (uint32_t)(system_timer_get_ms() - start_measurement) >= time_to_be_elapsed;
+}
+
+// TFP.
+
+uint32_t tfp_get_uid_from_message(const void *message) {
+	return ((const TFPMessageHeader*)message)->uid;
+}
+
+uint8_t tfp_get_length_from_message(const void *message) {
+	return ((const TFPMessageHeader*)message)->length;
+}
+
+uint8_t tfp_get_fid_from_message(const void *message) {
+	return ((const TFPMessageHeader*)message)->fid;
+}
+
+uint8_t tfp_get_sequence_number_from_message(const void *message) {
+	return ((const TFPMessageHeader*)message)->sequence_num;
+}
+
+bool tfp_is_return_expected(const void *message) {
+	return ((const TFPMessageHeader*)message)->return_expected;
+}
+
+void tfp_make_default_header(TFPMessageHeader *header, const uint32_t uid, const uint8_t length, const uint8_t fid) {
+	memset(header, 0, sizeof(TFPMessageHeader));
+	header->uid = uid;
+	header->length = length;
+	header->fid = fid;
+}
+
+// Callback scheduler, one callback per tick in round-robin order like bricklib2.
+
+void communication_callback_init(void) {
+	communication_callback_last_ms = 0;
+	communication_callback_index = 0;
+}
+
+void communication_callback_tick(void) {
+	if(!system_timer_is_time_elapsed_ms(communication_callback_last_ms, COMMUNICATION_CALLBACK_TICK_WAIT_MS)) {
+		return;
+	}
+
+	communication_callback_last_ms = system_timer_get_ms();
+	for(uint8_t i = 0; i < COMMUNICATION_CALLBACK_HANDLER_NUM; i++) {
+		const uint8_t index = communication_callback_index;
+		communication_callback_index = (communication_callback_index + 1) % COMMUNICATION_CALLBACK_HANDLER_NUM;
+		if(communication_callbacks[index]()) {
+			return;
+		}
+	}
+}
@@ -21,14 +21,19 @@
 
 #include "communication.h"
 
+#include <string.h>
+
 #include "bricklib2/utility/communication_callback.h"
 #include "bricklib2/protocols/tfp/tfp.h"
 #include "bricklib2/logging/logging.h"
+#include "bricklib2/hal/system_timer/system_timer.h"
 
 #include "xmc_usic.h"
 #include "xmc_uart.h"
 
 #include "rs232.h"
+#include "crc.h"
+#include "modbus.h"
 
 BootloaderHandleMessageResponse handle_message(const void *message, void *response) {
 	switch(tfp_get_fid_from_message(message)) {
@@ -45,28 +50,92 @@ BootloaderHandleMessageResponse handle_message(const void *message, void *respon
 		case FID_GET_ERROR_COUNT: return get_error_count(message, response);
 		case FID_SET_FRAME_READABLE_CALLBACK_CONFIGURATION: return set_frame_readable_callback_configuration(message);
 		case FID_GET_FRAME_READABLE_CALLBACK_CONFIGURATION: return get_frame_readable_callback_configuration(message, response);
+		case FID_SET_FRAME_DELIMITER_CONFIGURATION: return set_frame_delimiter_configuration(message);
+		case FID_GET_FRAME_DELIMITER_CONFIGURATION: return get_frame_delimiter_configuration(message, response);
+		case FID_READ_FRAME_LOW_LEVEL: return read_frame_low_level(message, response);
+		case FID_SET_FRAME_GAP_CONFIGURATION: return set_frame_gap_configuration(message);
+		case FID_GET_FRAME_GAP_CONFIGURATION: return get_frame_gap_configuration(message, response);
+		case FID_SET_FRAME_CALLBACK_CONFIGURATION: return set_frame_callback_configuration(message);
+		case FID_GET_FRAME_CALLBACK_CONFIGURATION: return get_frame_callback_configuration(message, response);
+		case FID_SET_READ_CALLBACK_COALESCING_CONFIGURATION: return set_read_callback_coalescing_configuration(message);
+		case FID_GET_READ_CALLBACK_COALESCING_CONFIGURATION: return get_read_callback_coalescing_configuration(message, response);
+		case FID_SET_RX_TIMESTAMP_CONFIGURATION: return set_rx_timestamp_configuration(message);
+		case FID_GET_RX_TIMESTAMP_CONFIGURATION: return get_rx_timestamp_configuration(message, response);
+		case FID_READ_FRAME_TIMESTAMP: return read_frame_timestamp(message, response);
+		case FID_SET_CRC_CONFIGURATION: return set_crc_configuration(message);
+		case FID_GET_CRC_CONFIGURATION: return get_crc_configuration(message, response);
+		case FID_GET_CRC_ERROR_COUNT: return get_crc_error_count(message, response);
+		case FID_SET_MODBUS_MASTER_CONFIGURATION: return set_modbus_master_configuration(message);
+		case FID_GET_MODBUS_MASTER_CONFIGURATION: return get_modbus_master_configuration(message, response);
+		case FID_MODBUS_MASTER_REQUEST: return modbus_master_request(message, response);
+		case FID_SET_POLL_ENTRY: return set_poll_entry(message);
+		case FID_GET_POLL_ENTRY: return get_poll_entry(message, response);
+		case FID_TRANSACTION_LOW_LEVEL: return transaction_low_level(message, response);
+		case FID_GET_ERROR_COUNT_EXTENDED: return get_error_count_extended(message, response);
+		case FID_GET_STATISTICS: return get_statistics(message, response);
+		case FID_RESET_STATISTICS: return reset_statistics(message);
+		case FID_SET_FLOWCONTROL_CONFIGURATION: return set_flowcontrol_configuration(message);
+		case FID_GET_FLOWCONTROL_CONFIGURATION: return get_flowcontrol_configuration(message, response);
+		case FID_GET_FLOWCONTROL_STATUS: return get_flowcontrol_status(message, response);
+		case FID_START_BAUDRATE_DETECTION: return start_baudrate_detection(message);
+		case FID_GET_ACHIEVED_BAUDRATE: return get_achieved_baudrate(message, response);
+		case FID_SAVE_CONFIGURATION: return save_configuration(message, response);
+		case FID_CLEAR_SAVED_CONFIGURATION: return clear_saved_configuration(message, response);
+		case FID_SET_FULL_CONFIGURATION: return set_full_configuration(message);
+		case FID_GET_RECONFIGURATION_STATUS: return get_reconfiguration_status(message, response);
+		case FID_SET_BUFFER_POOL_CONFIGURATION: return set_buffer_pool_configuration(message);
+		case FID_GET_BUFFER_POOL_CONFIGURATION: return get_buffer_pool_configuration(message, response);
+		case FID_SET_RX_OVERFLOW_POLICY: return set_rx_overflow_policy(message);
+		case FID_GET_RX_OVERFLOW_POLICY: return get_rx_overflow_policy(message, response);
+		case FID_WRITE_STREAM_LOW_LEVEL: return write_stream_low_level(message);
+		case FID_GET_WRITE_CREDIT: return get_write_credit(message, response);
+		case FID_SET_WRITE_CREDIT_CALLBACK_CONFIGURATION: return set_write_credit_callback_configuration(message);
+		case FID_GET_WRITE_CREDIT_CALLBACK_CONFIGURATION: return get_write_credit_callback_configuration(message, response);
 		default: return HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED;
 	}
 }
 
 BootloaderHandleMessageResponse write_low_level(const WriteLowLevel *data, WriteLowLevel_Response *response) {
 	uint8_t written = 0;
+	uint16_t length = data->message_length - data->message_chunk_offset;
+	const bool last_chunk = length <= sizeof(data->message_chunk_data);
+	const uint8_t crc_length = rs232.crc_append_tx ? crc_get_length(rs232.crc_type) : 0;
 	response->header.length = sizeof(WriteLowLevel_Response);
 
-	if((data->message_length - data->message_chunk_offset) >= sizeof(data->message_chunk_data)) {
+	if(!last_chunk) {
 		// Whole chunk with data.
-		for(written = 0; written < sizeof(data->message_chunk_data); written++) {
-			if(!ringbuffer_add(&rs232.rb_tx, data->message_chunk_data[written])) {
-				break;
+		length = sizeof(data->message_chunk_data);
+	}
+
+	if(crc_length > 0) {
+		if(data->message_chunk_offset == 0) {
+			rs232.crc_tx = crc_start(rs232.crc_type);
+		}
+
+		if(last_chunk) {
+			// Only write as much of the last chunk that the checksum still fits.
+			const uint16_t free = ringbuffer_get_free(&rs232.rb_tx);
+
+			if(free < crc_length) {
+				length = 0;
+			}
+			else if(length > free - crc_length) {
+				length = free - crc_length;
 			}
 		}
 	}
-	else {
-		// Partial chunk with data.
-		for(written = 0; written < (data->message_length - data->message_chunk_offset); written++) {
-			if(!ringbuffer_add(&rs232.rb_tx, data->message_chunk_data[written])) {
-				break;
-			}
+
+	written = rs232_ringbuffer_add_n(&rs232.rb_tx, (const uint8_t *)data->message_chunk_data, length);
+
+	if((crc_length > 0) && (data->message_length > 0)) {
+		rs232.crc_tx = crc_update(rs232.crc_type, rs232.crc_tx, (const uint8_t *)data->message_chunk_data, written);
+
+		if(data->message_chunk_offset + written == data->message_length) {
+			// Complete message written, append the checksum.
+			uint8_t checksum[CRC_MAX_LENGTH];
+
+			crc_finish(rs232.crc_type, rs232.crc_tx, checksum);
+			rs232_ringbuffer_add_n(&rs232.rb_tx, checksum, crc_length);
 		}
 	}
 
@@ -86,8 +155,8 @@ BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLow
 	response->message_chunk_offset = 0;
 	response->header.length = sizeof(ReadLowLevel_Response);
 
-	// This function operates only when read callback is disabled.
-	if(rs232.read_callback_enabled) {
+	// This function operates only when read callback is disabled and no transaction is in progress.
+	if(rs232.read_callback_enabled || (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
 		return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 	}
 
@@ -103,6 +172,7 @@ BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLow
 	if(!rs232.read_stream_status.in_progress) {
 		// Start of new stream.
 		rs232.read_stream_status.in_progress = true;
+		rs232_rx_drop_oldest_update();
 
 		if(data->length >= rb_available) {
 			/*
@@ -122,17 +192,13 @@ BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLow
 
 		if(response->message_length <= sizeof(response->message_chunk_data)) {
 			// Available data fits in a single chunk.
-			for(uint8_t i = 0; i < response->message_length; i++) {
-				ringbuffer_get(&rs232.rb_rx, (uint8_t *)&response->message_chunk_data[i]);
-			}
+			rs232_ringbuffer_get_n(&rs232.rb_rx, (uint8_t *)response->message_chunk_data, response->message_length);
 
 			reset_read_stream_status();
 		}
 		else {
 			// Requested data requires more than one chunk.
-			for(uint8_t i = 0; i < sizeof(response->message_chunk_data); i++) {
-				ringbuffer_get(&rs232.rb_rx, (uint8_t *)&response->message_chunk_data[i]);
-			}
+			rs232_ringbuffer_get_n(&rs232.rb_rx, (uint8_t *)response->message_chunk_data, sizeof(response->message_chunk_data));
 
 			rs232.read_stream_status.stream_sent += sizeof(response->message_chunk_data);
 		}
@@ -144,16 +210,14 @@ BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLow
 
 		if((rs232.read_stream_status.stream_total_length - rs232.read_stream_status.stream_sent) >= \
 			sizeof(response->message_chunk_data)) {
-				for(uint8_t i = 0; i < sizeof(response->message_chunk_data); i++) {
-					ringbuffer_get(&rs232.rb_rx, (uint8_t *)&response->message_chunk_data[i]);
-				}
+				rs232_ringbuffer_get_n(&rs232.rb_rx, (uint8_t *)response->message_chunk_data, sizeof(response->message_chunk_data));
 
 				rs232.read_stream_status.stream_sent += sizeof(response->message_chunk_data);
 		}
 		else {
-			for(uint8_t i = 0; i < (rs232.read_stream_status.stream_total_length - rs232.read_stream_status.stream_sent); i++) {
-				ringbuffer_get(&rs232.rb_rx, (uint8_t *)&response->message_chunk_data[i]);
-			}
+			rs232_ringbuffer_get_n(&rs232.rb_rx,
+			                       (uint8_t *)response->message_chunk_data,
+			                       rs232.read_stream_status.stream_total_length - rs232.read_stream_status.stream_sent);
 
 			rs232.read_stream_status.stream_sent += \
 				(rs232.read_stream_status.stream_total_length - rs232.read_stream_status.stream_sent);
@@ -165,14 +229,25 @@ BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLow
 		}
 	}
 
+	if(rs232_frame_is_enabled()) {
+		// Data was read past the frame detection, start over at the new ringbuffer start.
+		rs232_frame_reset();
+	}
+
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
 BootloaderHandleMessageResponse enable_read_callback(const EnableReadCallback *data) {
 	logd("[+] RS232-V2: enable_read_callback()\n\r");
 
+	if(modbus.enabled) {
+		modbus_set_enabled(false);
+	}
+
 	rs232.read_callback_enabled = true;
 	rs232.frame_readable_cb_frame_size = 0;
+	rs232.frame_callback_enabled = false;
+	rs232_frame_disable();
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
@@ -194,40 +269,32 @@ BootloaderHandleMessageResponse is_read_callback_enabled(const IsReadCallbackEna
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
+/*
+ * Line parameter changes are applied once the data that is already in the
+ * TX buffer is sent, so that e.g. a baudrate switch command still goes out
+ * with the old baudrate. The RX buffer is kept.
+ */
 BootloaderHandleMessageResponse set_configuration(const SetConfiguration *data) {
 	logd("[+] RS232-V2: set_configuration()\n\r");
 
-	if (data->baudrate < CONFIG_BAUDRATE_MIN || data->baudrate > CONFIG_BAUDRATE_MAX) {
-		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
-	}
+	RS232Configuration_t config = rs232.reconfigure;
 
-	if (data->parity > CONFIG_PARITY_MAX) {
-		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
-	}
-
-	if (data->stopbits < CONFIG_STOPBITS_MIN || data->stopbits > CONFIG_STOPBITS_MAX) {
-		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
-	}
-
-	if (data->wordlength < CONFIG_WORDLENGTH_MIN || data->wordlength > CONFIG_WORDLENGTH_MAX) {
-		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
-	}
+	config.baudrate = data->baudrate;
+	config.parity = data->parity;
+	config.stopbits = data->stopbits;
+	config.wordlength = data->wordlength;
+	config.flowcontrol = data->flowcontrol;
 
-	if (data->flowcontrol > CONFIG_FLOWCONTROL_MAX) {
+	if(!rs232_configuration_is_valid(&config)) {
 		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}
 
-	rs232.baudrate = data->baudrate;
-	rs232.parity = data->parity;
-	rs232.stopbits = data->stopbits;
-	rs232.wordlength = data->wordlength;
-	rs232.flowcontrol = data->flowcontrol;
-
-	rs232_apply_configuration();
+	rs232_reconfigure(&config, true);
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
 
+// Returns the active configuration, a pending change is reported by get_reconfiguration_status.
 BootloaderHandleMessageResponse get_configuration(const GetConfiguration *data, GetConfiguration_Response *response) {
 	logd("[+] RS232-V2: get_configuration()\n\r");
 
@@ -241,20 +308,24 @@ BootloaderHandleMessageResponse get_configuration(const GetConfiguration *data,
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
+/*
+ * The buffered RX and TX data is kept. A smaller receive buffer waits until
+ * the RX data behind the new border is read, a smaller send buffer until the
+ * TX data in front of it is sent (see get_reconfiguration_status).
+ */
 BootloaderHandleMessageResponse set_buffer_config(const SetBufferConfig *data) {
 	logd("[+] RS232-V2: set_buffer_config()\n\r");
 
-	if((data->receive_buffer_size < 1024) ||
-	   (data->send_buffer_size < 1024) ||
-	   ((data->receive_buffer_size + data->send_buffer_size) != RS232_BUFFER_SIZE)) {
+	RS232Configuration_t config = rs232.reconfigure;
+
+	config.buffer_size_rx = data->receive_buffer_size;
+	config.buffer_size_tx = data->send_buffer_size;
 
+	if(!rs232_configuration_is_valid(&config)) {
 		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}
 
-	rs232.buffer_size_rx = data->receive_buffer_size;
-	rs232.buffer_size_tx = data->send_buffer_size;
-
-	rs232_apply_configuration();
+	rs232_reconfigure(&config, true);
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
@@ -291,10 +362,18 @@ BootloaderHandleMessageResponse get_error_count(const GetErrorCount *data, GetEr
 
 BootloaderHandleMessageResponse set_frame_readable_callback_configuration(const SetFrameReadableCallbackConfiguration *data) {
 	if(data->frame_size > 0) {
+		if(modbus.enabled) {
+			modbus_set_enabled(false);
+		}
+
 		rs232.read_callback_enabled = false;
+		rs232.frame_callback_enabled = false;
+		rs232_frame_disable();
 	}
 	rs232.frame_readable_cb_frame_size = data->frame_size;
+	rs232_rx_drop_oldest_update();
 	rs232.frame_readable_cb_already_sent = false;
+	rs232_rx_timestamp_reset();
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
 
@@ -305,23 +384,688 @@ BootloaderHandleMessageResponse get_frame_readable_callback_configuration(const
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
+BootloaderHandleMessageResponse set_frame_delimiter_configuration(const SetFrameDelimiterConfiguration *data) {
+	if(data->delimiter_length > sizeof(data->delimiter)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	if(data->delimiter_length > 0) {
+		if(modbus.enabled) {
+			modbus_set_enabled(false);
+		}
+
+		rs232.read_callback_enabled = false;
+		rs232.frame_readable_cb_frame_size = 0;
+	}
+
+	rs232_frame_set_delimiter(data->delimiter, data->delimiter_length);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_frame_delimiter_configuration(const GetFrameDelimiterConfiguration *data, GetFrameDelimiterConfiguration_Response *response) {
+	response->header.length = sizeof(GetFrameDelimiterConfiguration_Response);
+	response->delimiter_length = rs232.frame_delimiter_length;
+	memcpy(response->delimiter, rs232.frame_delimiter, sizeof(response->delimiter));
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+// Copies the next chunk of the current frame, starts with the next complete frame if none is in progress.
+static bool frame_chunk_next(uint16_t *frame_length, uint16_t *frame_chunk_offset, char *frame_chunk_data) {
+	RS232ReadStreamStatus_t *const status = &rs232.read_frame_stream_status;
+
+	if(!status->in_progress) {
+		status->stream_total_length = rs232_frame_pop();
+		status->stream_sent = 0;
+
+		if(status->stream_total_length == 0) {
+			return false;
+		}
+
+		status->in_progress = true;
+	}
+
+	uint16_t count = status->stream_total_length - status->stream_sent;
+	if(count > 60) {
+		count = 60;
+	}
+
+	*frame_length = status->stream_total_length;
+	*frame_chunk_offset = status->stream_sent;
+	rs232_ringbuffer_get_n(&rs232.rb_rx, (uint8_t *)frame_chunk_data, count);
+	status->stream_sent += count;
+
+	if(status->stream_sent == status->stream_total_length) {
+		// Last chunk of the frame.
+		status->in_progress = false;
+		rs232.frame_available_cb_already_sent = false;
+	}
+
+	return true;
+}
+
+BootloaderHandleMessageResponse read_frame_low_level(const ReadFrameLowLevel *data, ReadFrameLowLevel_Response *response) {
+	response->header.length = sizeof(ReadFrameLowLevel_Response);
+	response->frame_length = 0;
+	response->frame_chunk_offset = 0;
+
+	// Frames are delivered by callback, frame_length 0 means there is no complete frame.
+	if(!rs232_frame_is_enabled() || rs232.frame_callback_enabled || modbus.enabled ||
+	   (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
+		return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+	}
+
+	uint16_t frame_length = 0;
+	uint16_t frame_chunk_offset = 0;
+	frame_chunk_next(&frame_length, &frame_chunk_offset, response->frame_chunk_data);
+	response->frame_length = frame_length;
+	response->frame_chunk_offset = frame_chunk_offset;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_frame_gap_configuration(const SetFrameGapConfiguration *data) {
+	if(data->gap_length > 0) {
+		if(modbus.enabled) {
+			modbus_set_enabled(false);
+		}
+
+		rs232.read_callback_enabled = false;
+		rs232.frame_readable_cb_frame_size = 0;
+	}
+
+	rs232_frame_set_gap(data->gap_length);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_frame_gap_configuration(const GetFrameGapConfiguration *data, GetFrameGapConfiguration_Response *response) {
+	response->header.length = sizeof(GetFrameGapConfiguration_Response);
+	response->gap_length = rs232.frame_gap_length;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_frame_callback_configuration(const SetFrameCallbackConfiguration *data) {
+	if(data->enabled) {
+		if(modbus.enabled) {
+			modbus_set_enabled(false);
+		}
+
+		rs232.read_callback_enabled = false;
+		rs232.frame_readable_cb_frame_size = 0;
+		rs232_rx_drop_oldest_update();
+	}
+
+	rs232.frame_callback_enabled = data->enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_frame_callback_configuration(const GetFrameCallbackConfiguration *data, GetFrameCallbackConfiguration_Response *response) {
+	response->header.length = sizeof(GetFrameCallbackConfiguration_Response);
+	response->enabled = rs232.frame_callback_enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * The read callback is sent once minimum_bytes are buffered or the oldest
+ * buffered byte is older than maximum_latency us. A maximum_latency of 0
+ * means no latency bound, the callback waits for minimum_bytes (or until
+ * the RX buffer is full or flow control stopped the peer). With the
+ * defaults (1 byte, 0us) every byte is sent as soon as possible.
+ */
+BootloaderHandleMessageResponse set_read_callback_coalescing_configuration(const SetReadCallbackCoalescingConfiguration *data) {
+	if(data->minimum_bytes == 0) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232.read_callback_minimum_bytes = data->minimum_bytes;
+	rs232.read_callback_maximum_latency = data->maximum_latency;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_read_callback_coalescing_configuration(const GetReadCallbackCoalescingConfiguration *data, GetReadCallbackCoalescingConfiguration_Response *response) {
+	response->header.length = sizeof(GetReadCallbackCoalescingConfiguration_Response);
+	response->minimum_bytes = rs232.read_callback_minimum_bytes;
+	response->maximum_latency = rs232.read_callback_maximum_latency;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * With RX timestamps enabled the read callback is replaced by the read
+ * timestamped callback and frame readable frames can be matched with
+ * read_frame_timestamp. Timestamps are in us and wrap around.
+ */
+BootloaderHandleMessageResponse set_rx_timestamp_configuration(const SetRXTimestampConfiguration *data) {
+	rs232_rx_timestamp_reset();
+	rs232.rx_timestamp_enabled = data->enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_rx_timestamp_configuration(const GetRXTimestampConfiguration *data, GetRXTimestampConfiguration_Response *response) {
+	response->header.length = sizeof(GetRXTimestampConfiguration_Response);
+	response->enabled = rs232.rx_timestamp_enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse read_frame_timestamp(const ReadFrameTimestamp *data, ReadFrameTimestamp_Response *response) {
+	RS232RXTimestamp_t timestamp = {0, 0};
+
+	response->header.length = sizeof(ReadFrameTimestamp_Response);
+	response->frame_count = rs232_rx_timestamp_pop(&timestamp);
+	response->first_byte_timestamp = timestamp.first_byte;
+	response->last_byte_timestamp = timestamp.last_byte;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * The checksum is appended to every message written with write_low_level
+ * and checked on every frame of the delimiter or gap frame detection. In
+ * delimiter mode the checksum is expected in front of the delimiter.
+ */
+BootloaderHandleMessageResponse set_crc_configuration(const SetCRCConfiguration *data) {
+	if(data->crc_type > RS232_V2_CRC_TYPE_SUM8) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232.crc_type = data->crc_type;
+	rs232.crc_append_tx = data->append_tx;
+	rs232.crc_verify_rx = data->verify_rx;
+	rs232.crc_drop_invalid_rx = data->drop_invalid_rx;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_crc_configuration(const GetCRCConfiguration *data, GetCRCConfiguration_Response *response) {
+	response->header.length = sizeof(GetCRCConfiguration_Response);
+	response->crc_type = rs232.crc_type;
+	response->append_tx = rs232.crc_append_tx;
+	response->verify_rx = rs232.crc_verify_rx;
+	response->drop_invalid_rx = rs232.crc_drop_invalid_rx;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_crc_error_count(const GetCRCErrorCount *data, GetCRCErrorCount_Response *response) {
+	response->header.length = sizeof(GetCRCErrorCount_Response);
+	response->error_count_crc = rs232.error_count_crc;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_modbus_master_configuration(const SetModbusMasterConfiguration *data) {
+	if(data->enabled) {
+		rs232.read_callback_enabled = false;
+		rs232.frame_readable_cb_frame_size = 0;
+		rs232.frame_callback_enabled = false;
+	}
+
+	modbus.response_timeout = data->response_timeout;
+	if(data->enabled || modbus.enabled) {
+		modbus_set_enabled(data->enabled);
+	}
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_modbus_master_configuration(const GetModbusMasterConfiguration *data, GetModbusMasterConfiguration_Response *response) {
+	response->header.length = sizeof(GetModbusMasterConfiguration_Response);
+	response->enabled = modbus.enabled;
+	response->response_timeout = modbus.response_timeout;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse modbus_master_request(const ModbusMasterRequest *data, ModbusMasterRequest_Response *response) {
+	if(data->data_length > sizeof(data->data)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(ModbusMasterRequest_Response);
+	response->request_id = modbus_request(data->slave_address,
+	                                      data->function_code,
+	                                      data->address,
+	                                      data->count,
+	                                      data->data,
+	                                      data->data_length);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Entry index of the polling table is sent every period ms (0 = disabled).
+ * With response_length > 0 or a terminator (0-255, -1 = none) the next
+ * entry is only sent after the response arrived or the period elapsed.
+ */
+BootloaderHandleMessageResponse set_poll_entry(const SetPollEntry *data) {
+	if((data->index >= POLL_TABLE_SIZE) ||
+	   (data->message_length > sizeof(data->message)) ||
+	   (data->terminator < -1) || (data->terminator > 255) ||
+	   ((data->period > 0) && (data->message_length == 0))) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232_poll_set_entry(data->index,
+	                     data->period,
+	                     data->response_length,
+	                     data->terminator,
+	                     data->message,
+	                     data->message_length);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_poll_entry(const GetPollEntry *data, GetPollEntry_Response *response) {
+	if(data->index >= POLL_TABLE_SIZE) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const RS232PollEntry_t *const entry = &rs232.poll[data->index];
+
+	response->header.length = sizeof(GetPollEntry_Response);
+	response->period = entry->period;
+	response->response_length = entry->response_length;
+	response->terminator = entry->terminator;
+	response->message_length = entry->message_length;
+	memcpy(response->message, entry->message, sizeof(response->message));
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * The request is written like with write_low_level. Once it is complete
+ * in the TX buffer the response is collected until response_length bytes
+ * (0 = any) or the terminator (-1 = none) arrived or timeout ms elapsed.
+ * It is returned with the transaction response callback, the read and frame
+ * paths are paused in the meantime. Bytes that arrived before the response
+ * are not part of it, they are read as usual afterwards.
+ */
+BootloaderHandleMessageResponse transaction_low_level(const TransactionLowLevel *data, TransactionLowLevel_Response *response) {
+	response->header.length = sizeof(TransactionLowLevel_Response);
+	response->message_chunk_written = 0;
+
+	if((data->terminator < -1) || (data->terminator > 255) ||
+	   (data->response_length >= rs232.buffer_size_rx) ||
+	   (data->message_chunk_offset > data->message_length)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	if(data->message_chunk_offset == 0) {
+		if(modbus.enabled ||
+		   ((rs232.transaction_state != TRANSACTION_STATE_IDLE) && (rs232.transaction_state != TRANSACTION_STATE_WRITE))) {
+			// Another transaction is in progress.
+			return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+		}
+
+		rs232.transaction_state = TRANSACTION_STATE_WRITE;
+		rs232_rx_drop_oldest_update();
+	}
+	else if(rs232.transaction_state != TRANSACTION_STATE_WRITE) {
+		return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+	}
+
+	uint16_t length = data->message_length - data->message_chunk_offset;
+	if(length > sizeof(data->message_chunk_data)) {
+		length = sizeof(data->message_chunk_data);
+	}
+
+	const uint8_t written = rs232_ringbuffer_add_n(&rs232.rb_tx, (const uint8_t *)data->message_chunk_data, length);
+
+	if(written != 0) {
+		XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+		XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+	}
+
+	if(data->message_chunk_offset + written == data->message_length) {
+		rs232_transaction_start(data->response_length, data->terminator, data->timeout);
+	}
+	else if(written < length) {
+		// TX buffer is full, the request is incomplete.
+		rs232.transaction_state = TRANSACTION_STATE_IDLE;
+		rs232_rx_drop_oldest_update();
+	}
+
+	response->message_chunk_written = written;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Overrun and parity are counted per byte. Framing, break, noise and FIFO
+ * overflow are counted per event, the USIC only reports them as sticky flags
+ * (see rs232_rxa_irq_handler()).
+ */
+BootloaderHandleMessageResponse get_error_count_extended(const GetErrorCountExtended *data, GetErrorCountExtended_Response *response) {
+	response->header.length = sizeof(GetErrorCountExtended_Response);
+	response->error_count_overrun = rs232.error_count_overrun;
+	response->error_count_parity = rs232.error_count_parity;
+	response->error_count_framing = rs232.error_count_framing;
+	response->error_count_break = rs232.error_count_break;
+	response->error_count_noise = rs232.error_count_noise;
+	response->error_count_fifo_overflow = rs232.error_count_fifo_overflow;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+// IRQ durations are measured in CPU cycles, SysTick->LOAD + 1 cycles are one ms.
+// They stay 0 without RS232_STATISTICS_IRQ_DURATION.
+static uint32_t irq_cycles_to_ns(const uint64_t cycles) {
+	return cycles * 1000000 / (SysTick->LOAD + 1);
+}
+
+BootloaderHandleMessageResponse get_statistics(const GetStatistics *data, GetStatistics_Response *response) {
+	const RS232Statistics_t *const statistics = &rs232.statistics;
+
+	response->header.length = sizeof(GetStatistics_Response);
+	response->main_loop_per_second = statistics->loop_per_second;
+	response->main_loop_period_max = statistics->loop_period_max;
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+	const RS232IRQStatistics_t rx_irq = statistics->rx_irq;
+	const RS232IRQStatistics_t tx_irq = statistics->tx_irq;
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	response->rx_irq_duration_max = irq_cycles_to_ns(rx_irq.cycles_max);
+	response->rx_irq_duration_average = (rx_irq.count == 0) ? 0 : irq_cycles_to_ns(rx_irq.cycles / rx_irq.count);
+	response->tx_irq_duration_max = irq_cycles_to_ns(tx_irq.cycles_max);
+	response->tx_irq_duration_average = (tx_irq.count == 0) ? 0 : irq_cycles_to_ns(tx_irq.cycles / tx_irq.count);
+
+	response->rx_buffer_high_watermark = statistics->rx_buffer_high_watermark;
+	response->tx_buffer_high_watermark = statistics->tx_buffer_high_watermark;
+	response->rx_bytes = statistics->rx_bytes;
+	response->tx_bytes = statistics->tx_bytes;
+	response->rx_bytes_per_second = statistics->rx_bytes_per_second;
+	response->tx_bytes_per_second = statistics->tx_bytes_per_second;
+	response->callback_send_blocked = statistics->callback_send_blocked;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse reset_statistics(const ResetStatistics *data) {
+	rs232_statistics_reset();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse set_flowcontrol_configuration(const SetFlowcontrolConfiguration *data) {
+	if((data->rx_high_watermark == 0) ||
+	   (data->rx_high_watermark > 100) ||
+	   (data->rx_low_watermark >= data->rx_high_watermark)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232_fc_set_watermarks(data->rx_high_watermark, data->rx_low_watermark);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_flowcontrol_configuration(const GetFlowcontrolConfiguration *data, GetFlowcontrolConfiguration_Response *response) {
+	response->header.length = sizeof(GetFlowcontrolConfiguration_Response);
+	response->rx_high_watermark = rs232.fc_rx_high_watermark;
+	response->rx_low_watermark = rs232.fc_rx_low_watermark;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_flowcontrol_status(const GetFlowcontrolStatus *data, GetFlowcontrolStatus_Response *response) {
+	response->header.length = sizeof(GetFlowcontrolStatus_Response);
+	response->rx_throttled = rs232_fc_is_rx_throttled();
+	response->tx_throttled = rs232_fc_is_tx_throttled();
+	response->rx_throttled_time = rs232.fc_rx_throttled_us / 1000;
+	response->tx_throttled_time = rs232.fc_tx_throttled_us / 1000;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse start_baudrate_detection(const StartBaudrateDetection *data) {
+	rs232_baudrate_detection_start(data->timeout);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_achieved_baudrate(const GetAchievedBaudrate *data, GetAchievedBaudrate_Response *response) {
+	response->header.length = sizeof(GetAchievedBaudrate_Response);
+	response->achieved_baudrate = rs232.divider.baudrate;
+	response->error_ppm = rs232.divider.error_ppm;
+	response->oversampling = rs232.divider.oversampling;
+	response->fractional_divider = rs232.divider.fractional;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * The saved configuration is used instead of the defaults on the next
+ * start, the bricklet then comes up ready to receive without any setup
+ * from the host. Modbus master mode and the poll table are not saved.
+ */
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data, SaveConfiguration_Response *response) {
+	response->header.length = sizeof(SaveConfiguration_Response);
+	response->success = rs232_configuration_save();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse clear_saved_configuration(const ClearSavedConfiguration *data, ClearSavedConfiguration_Response *response) {
+	response->header.length = sizeof(ClearSavedConfiguration_Response);
+	response->success = rs232_configuration_clear();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Line parameters, flow control and buffer split in one call, the USIC is
+ * set up only once. With tx_mode drain the TX buffer content is sent with
+ * the old line parameters first, with keep it is sent with the new ones.
+ */
+BootloaderHandleMessageResponse set_full_configuration(const SetFullConfiguration *data) {
+	const RS232Configuration_t config = {
+		.baudrate = data->baudrate,
+		.parity = data->parity,
+		.stopbits = data->stopbits,
+		.wordlength = data->wordlength,
+		.flowcontrol = data->flowcontrol,
+		.buffer_size_rx = data->receive_buffer_size,
+		.buffer_size_tx = data->send_buffer_size
+	};
+
+	if(!rs232_configuration_is_valid(&config) || (data->tx_mode > RS232_V2_TX_MODE_KEEP)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232_reconfigure(&config, data->tx_mode == RS232_V2_TX_MODE_DRAIN);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_reconfiguration_status(const GetReconfigurationStatus *data, GetReconfigurationStatus_Response *response) {
+	response->header.length = sizeof(GetReconfigurationStatus_Response);
+	response->pending = rs232.reconfigure_pending;
+	response->send_buffer_used = ringbuffer_get_used(&rs232.rb_tx);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * With the buffer pool enabled the receive and send buffer only keep their
+ * minimum size, the rest of the buffer moves to the direction that needs it.
+ * get_buffer_config returns the current split.
+ */
+BootloaderHandleMessageResponse set_buffer_pool_configuration(const SetBufferPoolConfiguration *data) {
+	if((data->receive_buffer_minimum < 1024) ||
+	   (data->send_buffer_minimum < 1024) ||
+	   ((data->receive_buffer_minimum + data->send_buffer_minimum) > RS232_BUFFER_SIZE)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232_buffer_pool_set(data->enabled, data->receive_buffer_minimum, data->send_buffer_minimum);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_buffer_pool_configuration(const GetBufferPoolConfiguration *data, GetBufferPoolConfiguration_Response *response) {
+	response->header.length = sizeof(GetBufferPoolConfiguration_Response);
+	response->enabled = rs232.buffer_pool_enabled;
+	response->receive_buffer_minimum = rs232.buffer_pool_minimum_rx;
+	response->send_buffer_minimum = rs232.buffer_pool_minimum_tx;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Bytes dropped by either policy are also counted as overrun. With block the
+ * peer is stopped by flow control, RTS is used if flow control is off.
+ * With drop-oldest, bytes counted as dropped newest are bytes the RX
+ * interrupt had to throw away because the main loop did not free up space
+ * in time while a read, frame, poll or transaction held the buffer.
+ */
+BootloaderHandleMessageResponse set_rx_overflow_policy(const SetRXOverflowPolicy *data) {
+	if(data->policy > RS232_V2_RX_OVERFLOW_POLICY_BLOCK) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	rs232_rx_overflow_set_policy(data->policy);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_rx_overflow_policy(const GetRXOverflowPolicy *data, GetRXOverflowPolicy_Response *response) {
+	response->header.length = sizeof(GetRXOverflowPolicy_Response);
+	response->policy = rs232.rx_overflow_policy;
+	response->dropped_newest = rs232.rx_overflow_dropped_newest;
+	response->dropped_oldest = rs232.rx_overflow_dropped_oldest;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Streaming write without a response per chunk. The host keeps track of the
+ * bytes it sent and may have up to credit bytes in flight that the bricklet
+ * didn't receive yet: credit - (sent - stream_received). The credit comes
+ * with get_write_credit and the write credit callback. Bytes that don't fit
+ * anyway are dropped and counted. The stream is sent as is, without CRC.
+ */
+BootloaderHandleMessageResponse write_stream_low_level(const WriteStreamLowLevel *data) {
+	if(data->message_chunk_length > sizeof(data->message_chunk_data)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t written = rs232_ringbuffer_add_n(&rs232.rb_tx, (const uint8_t *)data->message_chunk_data, data->message_chunk_length);
+
+	rs232.write_stream_received += data->message_chunk_length;
+	rs232.write_stream_dropped += data->message_chunk_length - written;
+
+	if(written != 0) {
+		XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+		XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+	}
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_write_credit(const GetWriteCredit *data, GetWriteCredit_Response *response) {
+	response->header.length = sizeof(GetWriteCredit_Response);
+	response->stream_received = rs232.write_stream_received;
+	response->stream_dropped = rs232.write_stream_dropped;
+	response->credit = rs232_write_credit();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_write_credit_callback_configuration(const SetWriteCreditCallbackConfiguration *data) {
+	rs232.write_credit_period = data->period;
+	rs232.write_credit_value_has_to_change = data->value_has_to_change;
+	rs232.write_credit_last_time = system_timer_get_ms();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_write_credit_callback_configuration(const GetWriteCreditCallbackConfiguration *data, GetWriteCreditCallbackConfiguration_Response *response) {
+	response->header.length = sizeof(GetWriteCreditCallbackConfiguration_Response);
+	response->period = rs232.write_credit_period;
+	response->value_has_to_change = rs232.write_credit_value_has_to_change;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+/*
+ * Sends a callback if the SPITFP send buffer is free, otherwise the caller
+ * keeps it buffered and it is counted in the statistics.
+ */
+static bool communication_callback_send(const void *cb, const uint8_t length) {
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)cb, length);
+
+		return true;
+	}
+
+	rs232.statistics.callback_send_blocked++;
+
+	return false;
+}
+
+// See set_read_callback_coalescing_configuration().
+static bool read_callback_coalescing_wait(const uint16_t used) {
+	if((used == 0) || (used >= rs232.read_callback_minimum_bytes)) {
+		return false;
+	}
+
+	// No more data will come in if the buffer is full or the peer was stopped by flow control.
+	if((used >= rs232.rb_rx.size - 1) || rs232.fc_hw_rx_wait || (rs232.fc_sw_state_rx == FC_SW_STATE_RX_WAIT)) {
+		return false;
+	}
+
+	if(rs232.read_callback_maximum_latency == 0) {
+		return true;
+	}
+
+	return (uint32_t)(rs232_get_time_us() - rs232.rx_oldest_us) < rs232.read_callback_maximum_latency;
+}
+
 bool handle_read_low_level_callback(void) {
 	static uint16_t used = 0;
-	static ReadLowLevel_Callback cb;
+	static ReadTimestampedLowLevel_Callback cb;
+	static uint8_t cb_length = sizeof(ReadLowLevel_Callback);
 	static bool is_buffered = false;
 	static uint16_t count_rb_read = 0;
 
 	if(!is_buffered) {
-		if(!rs232.read_callback_enabled) {
+		if(!rs232.read_callback_enabled || (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
 			is_buffered = false;
 
 			return false;
 		}
 
 		used = ringbuffer_get_used(&rs232.rb_rx);
+		rs232_rx_time_update();
+
+		if(!rs232.read_stream_status.in_progress && read_callback_coalescing_wait(used)) {
+			// Wait for more data.
+			return false;
+		}
 
 		if(used > 0 || rs232.read_stream_status.in_progress) {
-			tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ReadLowLevel_Callback), FID_CALLBACK_READ_LOW_LEVEL);
+			// The timestamped callback has the read callback layout plus the timestamps.
+			if(rs232.rx_timestamp_enabled) {
+				cb_length = sizeof(ReadTimestampedLowLevel_Callback);
+				tfp_make_default_header(&cb.header, bootloader_get_uid(), cb_length, FID_CALLBACK_READ_TIMESTAMPED_LOW_LEVEL);
+			}
+			else {
+				cb_length = sizeof(ReadLowLevel_Callback);
+				tfp_make_default_header(&cb.header, bootloader_get_uid(), cb_length, FID_CALLBACK_READ_LOW_LEVEL);
+			}
+
 			cb.message_length = 0;
 			cb.message_chunk_offset = 0;
 
@@ -334,6 +1078,11 @@ bool handle_read_low_level_callback(void) {
 
 				rs232.read_stream_status.in_progress = true;
 				rs232.read_stream_status.stream_total_length = used;
+				rs232_rx_drop_oldest_update();
+
+				// All chunks of a stream carry the timestamps of its oldest and newest byte.
+				cb.first_byte_timestamp = rs232.rx_oldest_us;
+				cb.last_byte_timestamp = rs232.rx_newest_us;
 
 				if(cb.message_length <= sizeof(cb.message_chunk_data)) {
 					// Available data fits in a single chunk.
@@ -365,11 +1114,14 @@ bool handle_read_low_level_callback(void) {
 			}
 
 			if(count_rb_read > 0) {
-				for(uint8_t i = 0; i < count_rb_read; i++) {
-					ringbuffer_get(&rs232.rb_rx, (uint8_t *)&cb.message_chunk_data[i]);
-				}
+				rs232_ringbuffer_get_n(&rs232.rb_rx, (uint8_t *)cb.message_chunk_data, count_rb_read);
 
 				rs232.read_stream_status.stream_sent += count_rb_read;
+
+				if(!rs232.read_stream_status.in_progress && (ringbuffer_get_used(&rs232.rb_rx) > 0)) {
+					// Data that arrived during the stream is at most as old as now.
+					rs232.rx_oldest_us = rs232_get_time_us();
+				}
 			}
 		}
 		else {
@@ -380,8 +1132,7 @@ bool handle_read_low_level_callback(void) {
 		}
 	}
 
-	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
-		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(ReadLowLevel_Callback));
+	if(communication_callback_send(&cb, cb_length)) {
 		is_buffered = false;
 
 		return true;
@@ -407,8 +1158,7 @@ bool handle_error_count_callback(void) {
 		cb.error_count_parity = rs232.error_count_parity;
 	}
 
-	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
-		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(ErrorCount_Callback));
+	if(communication_callback_send(&cb, sizeof(ErrorCount_Callback))) {
 		is_buffered = false;
 		rs232.do_error_count_callback = false;
 
@@ -427,7 +1177,7 @@ bool handle_frame_readable_callback(void) {
 	static uint16_t used = 0;
 
 	if(!is_buffered) {
-		if(rs232.frame_readable_cb_frame_size == 0) {
+		if((rs232.frame_readable_cb_frame_size == 0) || (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
 			return false;
 		}
 
@@ -445,8 +1195,7 @@ bool handle_frame_readable_callback(void) {
 		cb.frame_count = used / rs232.frame_readable_cb_frame_size;
 	}
 
-	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
-		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(FrameReadable_Callback));
+	if(communication_callback_send(&cb, sizeof(FrameReadable_Callback))) {
 		is_buffered = false;
 		return true;
 	} else {
@@ -456,6 +1205,235 @@ bool handle_frame_readable_callback(void) {
 	return false;
 }
 
+bool handle_frame_available_callback(void) {
+	static bool is_buffered = false;
+	static FrameAvailable_Callback cb;
+
+	if(!is_buffered) {
+		if(!rs232_frame_is_enabled() || rs232.frame_callback_enabled || modbus.enabled ||
+		   (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
+			return false;
+		}
+
+		if(rs232.frame_available_cb_already_sent || (rs232.frame_end_count == 0)) {
+			return false;
+		}
+
+		rs232.frame_available_cb_already_sent = true;
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(FrameAvailable_Callback), FID_CALLBACK_FRAME_AVAILABLE);
+		cb.frame_count = rs232.frame_end_count;
+	}
+
+	if(communication_callback_send(&cb, sizeof(FrameAvailable_Callback))) {
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_frame_low_level_callback(void) {
+	static bool is_buffered = false;
+	static FrameLowLevel_Callback cb;
+
+	if(!is_buffered) {
+		if(!rs232_frame_is_enabled() || !rs232.frame_callback_enabled ||
+		   (rs232.transaction_state > TRANSACTION_STATE_WRITE)) {
+			return false;
+		}
+
+		uint16_t frame_length;
+		uint16_t frame_chunk_offset;
+		if(!frame_chunk_next(&frame_length, &frame_chunk_offset, cb.frame_chunk_data)) {
+			return false;
+		}
+
+		cb.frame_length = frame_length;
+		cb.frame_chunk_offset = frame_chunk_offset;
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(FrameLowLevel_Callback), FID_CALLBACK_FRAME_LOW_LEVEL);
+	}
+
+	if(communication_callback_send(&cb, sizeof(FrameLowLevel_Callback))) {
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_modbus_master_response_low_level_callback(void) {
+	static bool is_buffered = false;
+	static ModbusMasterResponseLowLevel_Callback cb;
+	static uint16_t sent = 0;
+
+	if(!is_buffered) {
+		if(modbus.state != MODBUS_STATE_RESPONSE_READY) {
+			return false;
+		}
+
+		uint16_t count = modbus.data_length - sent;
+		if(count > sizeof(cb.data_chunk_data)) {
+			count = sizeof(cb.data_chunk_data);
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ModbusMasterResponseLowLevel_Callback), FID_CALLBACK_MODBUS_MASTER_RESPONSE_LOW_LEVEL);
+		cb.request_id = modbus.request_id;
+		cb.exception_code = modbus.exception_code;
+		cb.data_length = modbus.data_length;
+		cb.data_chunk_offset = sent;
+		memset(cb.data_chunk_data, 0, sizeof(cb.data_chunk_data));
+		memcpy(cb.data_chunk_data, &modbus.telegram[sent], count);
+
+		sent += count;
+		if(sent >= modbus.data_length) {
+			// Last chunk, the next request can be started.
+			sent = 0;
+			modbus_response_done();
+		}
+	}
+
+	if(communication_callback_send(&cb, sizeof(ModbusMasterResponseLowLevel_Callback))) {
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_transaction_response_low_level_callback(void) {
+	static bool is_buffered = false;
+	static TransactionResponseLowLevel_Callback cb;
+	static uint16_t sent = 0;
+
+	if(!is_buffered) {
+		if(rs232.transaction_state != TRANSACTION_STATE_RESPONSE_READY) {
+			sent = 0;
+			return false;
+		}
+
+		uint16_t count = rs232.transaction_rx_received - sent;
+		if(count > sizeof(cb.response_chunk_data)) {
+			count = sizeof(cb.response_chunk_data);
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(TransactionResponseLowLevel_Callback), FID_CALLBACK_TRANSACTION_RESPONSE_LOW_LEVEL);
+		cb.status = rs232.transaction_status;
+		cb.response_length = rs232.transaction_rx_received;
+		cb.response_chunk_offset = sent;
+		memset(cb.response_chunk_data, 0, sizeof(cb.response_chunk_data));
+		rs232_transaction_response_get((uint8_t *)cb.response_chunk_data, sent, count);
+
+		sent += count;
+		if(sent >= rs232.transaction_rx_received) {
+			// Last chunk, data before and after the response is left for the read path.
+			sent = 0;
+			rs232_transaction_done();
+		}
+	}
+
+	if(communication_callback_send(&cb, sizeof(TransactionResponseLowLevel_Callback))) {
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_error_count_extended_callback(void) {
+	static bool is_buffered = false;
+	static ErrorCountExtended_Callback cb;
+
+	if(!is_buffered) {
+		if(!rs232.do_error_count_extended_callback) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ErrorCountExtended_Callback), FID_CALLBACK_ERROR_COUNT_EXTENDED);
+		cb.error_count_overrun = rs232.error_count_overrun;
+		cb.error_count_parity = rs232.error_count_parity;
+		cb.error_count_framing = rs232.error_count_framing;
+		cb.error_count_break = rs232.error_count_break;
+		cb.error_count_noise = rs232.error_count_noise;
+		cb.error_count_fifo_overflow = rs232.error_count_fifo_overflow;
+	}
+
+	if(communication_callback_send(&cb, sizeof(ErrorCountExtended_Callback))) {
+		is_buffered = false;
+		rs232.do_error_count_extended_callback = false;
+
+		return true;
+	}
+	else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_baudrate_detected_callback(void) {
+	static bool is_buffered = false;
+	static BaudrateDetected_Callback cb;
+
+	if(!is_buffered) {
+		if(!rs232.do_baudrate_detected_callback) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(BaudrateDetected_Callback), FID_CALLBACK_BAUDRATE_DETECTED);
+		cb.baudrate = rs232.baudrate_detected;
+		cb.measured_baudrate = rs232.baudrate_measured;
+	}
+
+	if(communication_callback_send(&cb, sizeof(BaudrateDetected_Callback))) {
+		is_buffered = false;
+		rs232.do_baudrate_detected_callback = false;
+
+		return true;
+	}
+	else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_write_credit_callback(void) {
+	static bool is_buffered = false;
+	static WriteCredit_Callback cb;
+
+	if(!is_buffered) {
+		if(!rs232.do_write_credit_callback) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(WriteCredit_Callback), FID_CALLBACK_WRITE_CREDIT);
+		cb.stream_received = rs232.write_stream_received;
+		cb.stream_dropped = rs232.write_stream_dropped;
+		cb.credit = rs232_write_credit();
+	}
+
+	if(communication_callback_send(&cb, sizeof(WriteCredit_Callback))) {
+		is_buffered = false;
+		rs232.do_write_credit_callback = false;
+
+		return true;
+	}
+	else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
 void communication_tick(void) {
 	communication_callback_tick();
 }
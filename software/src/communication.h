@@ -50,6 +50,42 @@ void communication_init(void);
 #define RS232_V2_FLOWCONTROL_SOFTWARE 1
 #define RS232_V2_FLOWCONTROL_HARDWARE 2
 
+#define RS232_V2_TX_MODE_DRAIN 0
+#define RS232_V2_TX_MODE_KEEP 1
+
+#define RS232_V2_RX_OVERFLOW_POLICY_DROP_NEWEST 0
+#define RS232_V2_RX_OVERFLOW_POLICY_DROP_OLDEST 1
+#define RS232_V2_RX_OVERFLOW_POLICY_BLOCK 2
+
+#define RS232_V2_CRC_TYPE_NONE 0
+#define RS232_V2_CRC_TYPE_CRC16_MODBUS 1
+#define RS232_V2_CRC_TYPE_CRC16_CCITT 2
+#define RS232_V2_CRC_TYPE_CRC32 3
+#define RS232_V2_CRC_TYPE_XOR8 4
+#define RS232_V2_CRC_TYPE_SUM8 5
+
+#define RS232_V2_MODBUS_FUNCTION_CODE_READ_COILS 1
+#define RS232_V2_MODBUS_FUNCTION_CODE_READ_DISCRETE_INPUTS 2
+#define RS232_V2_MODBUS_FUNCTION_CODE_READ_HOLDING_REGISTERS 3
+#define RS232_V2_MODBUS_FUNCTION_CODE_READ_INPUT_REGISTERS 4
+#define RS232_V2_MODBUS_FUNCTION_CODE_WRITE_SINGLE_COIL 5
+#define RS232_V2_MODBUS_FUNCTION_CODE_WRITE_SINGLE_REGISTER 6
+#define RS232_V2_MODBUS_FUNCTION_CODE_WRITE_MULTIPLE_COILS 15
+#define RS232_V2_MODBUS_FUNCTION_CODE_WRITE_MULTIPLE_REGISTERS 16
+
+#define RS232_V2_MODBUS_EXCEPTION_CODE_INVALID_RESPONSE -3
+#define RS232_V2_MODBUS_EXCEPTION_CODE_CRC_ERROR -2
+#define RS232_V2_MODBUS_EXCEPTION_CODE_TIMEOUT -1
+#define RS232_V2_MODBUS_EXCEPTION_CODE_SUCCESS 0
+#define RS232_V2_MODBUS_EXCEPTION_CODE_ILLEGAL_FUNCTION 1
+#define RS232_V2_MODBUS_EXCEPTION_CODE_ILLEGAL_DATA_ADDRESS 2
+#define RS232_V2_MODBUS_EXCEPTION_CODE_ILLEGAL_DATA_VALUE 3
+#define RS232_V2_MODBUS_EXCEPTION_CODE_SLAVE_DEVICE_FAILURE 4
+
+#define RS232_V2_TRANSACTION_STATUS_COMPLETE 0
+#define RS232_V2_TRANSACTION_STATUS_TIMEOUT 1
+#define RS232_V2_TRANSACTION_STATUS_PARTIAL 2
+
 #define RS232_V2_BOOTLOADER_MODE_BOOTLOADER 0
 #define RS232_V2_BOOTLOADER_MODE_FIRMWARE 1
 #define RS232_V2_BOOTLOADER_MODE_BOOTLOADER_WAIT_FOR_REBOOT 2
@@ -82,10 +118,59 @@ void communication_init(void);
 #define FID_GET_ERROR_COUNT 11
 #define FID_SET_FRAME_READABLE_CALLBACK_CONFIGURATION 14
 #define FID_GET_FRAME_READABLE_CALLBACK_CONFIGURATION 15
+#define FID_SET_FRAME_DELIMITER_CONFIGURATION 17
+#define FID_GET_FRAME_DELIMITER_CONFIGURATION 18
+#define FID_READ_FRAME_LOW_LEVEL 19
+#define FID_SET_FRAME_GAP_CONFIGURATION 21
+#define FID_GET_FRAME_GAP_CONFIGURATION 22
+#define FID_SET_FRAME_CALLBACK_CONFIGURATION 23
+#define FID_GET_FRAME_CALLBACK_CONFIGURATION 24
+#define FID_SET_READ_CALLBACK_COALESCING_CONFIGURATION 26
+#define FID_GET_READ_CALLBACK_COALESCING_CONFIGURATION 27
+#define FID_SET_RX_TIMESTAMP_CONFIGURATION 28
+#define FID_GET_RX_TIMESTAMP_CONFIGURATION 29
+#define FID_READ_FRAME_TIMESTAMP 30
+#define FID_SET_CRC_CONFIGURATION 32
+#define FID_GET_CRC_CONFIGURATION 33
+#define FID_GET_CRC_ERROR_COUNT 34
+#define FID_SET_MODBUS_MASTER_CONFIGURATION 35
+#define FID_GET_MODBUS_MASTER_CONFIGURATION 36
+#define FID_MODBUS_MASTER_REQUEST 37
+#define FID_SET_POLL_ENTRY 39
+#define FID_GET_POLL_ENTRY 40
+#define FID_TRANSACTION_LOW_LEVEL 41
+#define FID_GET_ERROR_COUNT_EXTENDED 43
+#define FID_GET_STATISTICS 45
+#define FID_RESET_STATISTICS 46
+#define FID_SET_FLOWCONTROL_CONFIGURATION 47
+#define FID_GET_FLOWCONTROL_CONFIGURATION 48
+#define FID_GET_FLOWCONTROL_STATUS 49
+#define FID_START_BAUDRATE_DETECTION 50
+#define FID_GET_ACHIEVED_BAUDRATE 52
+#define FID_SAVE_CONFIGURATION 53
+#define FID_CLEAR_SAVED_CONFIGURATION 54
+#define FID_SET_FULL_CONFIGURATION 55
+#define FID_GET_RECONFIGURATION_STATUS 56
+#define FID_SET_BUFFER_POOL_CONFIGURATION 57
+#define FID_GET_BUFFER_POOL_CONFIGURATION 58
+#define FID_SET_RX_OVERFLOW_POLICY 59
+#define FID_GET_RX_OVERFLOW_POLICY 60
+#define FID_WRITE_STREAM_LOW_LEVEL 61
+#define FID_GET_WRITE_CREDIT 62
+#define FID_SET_WRITE_CREDIT_CALLBACK_CONFIGURATION 63
+#define FID_GET_WRITE_CREDIT_CALLBACK_CONFIGURATION 64
 
 #define FID_CALLBACK_READ_LOW_LEVEL 12
 #define FID_CALLBACK_ERROR_COUNT 13
 #define FID_CALLBACK_FRAME_READABLE 16
+#define FID_CALLBACK_FRAME_AVAILABLE 20
+#define FID_CALLBACK_FRAME_LOW_LEVEL 25
+#define FID_CALLBACK_READ_TIMESTAMPED_LOW_LEVEL 31
+#define FID_CALLBACK_MODBUS_MASTER_RESPONSE_LOW_LEVEL 38
+#define FID_CALLBACK_TRANSACTION_RESPONSE_LOW_LEVEL 42
+#define FID_CALLBACK_ERROR_COUNT_EXTENDED 44
+#define FID_CALLBACK_BAUDRATE_DETECTED 51
+#define FID_CALLBACK_WRITE_CREDIT 65
 
 typedef struct {
 	TFPMessageHeader header;
@@ -219,6 +304,453 @@ typedef struct {
 	uint16_t frame_count;
 } __attribute__((__packed__)) FrameReadable_Callback;
 
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t delimiter_length;
+	uint8_t delimiter[4];
+} __attribute__((__packed__)) SetFrameDelimiterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetFrameDelimiterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t delimiter_length;
+	uint8_t delimiter[4];
+} __attribute__((__packed__)) GetFrameDelimiterConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ReadFrameLowLevel;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t frame_length;
+	uint16_t frame_chunk_offset;
+	char frame_chunk_data[60];
+} __attribute__((__packed__)) ReadFrameLowLevel_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t frame_count;
+} __attribute__((__packed__)) FrameAvailable_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t gap_length;
+} __attribute__((__packed__)) SetFrameGapConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetFrameGapConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t gap_length;
+} __attribute__((__packed__)) GetFrameGapConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) SetFrameCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetFrameCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetFrameCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t frame_length;
+	uint16_t frame_chunk_offset;
+	char frame_chunk_data[60];
+} __attribute__((__packed__)) FrameLowLevel_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t minimum_bytes;
+	uint32_t maximum_latency;
+} __attribute__((__packed__)) SetReadCallbackCoalescingConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetReadCallbackCoalescingConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t minimum_bytes;
+	uint32_t maximum_latency;
+} __attribute__((__packed__)) GetReadCallbackCoalescingConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) SetRXTimestampConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetRXTimestampConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetRXTimestampConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ReadFrameTimestamp;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t frame_count;
+	uint32_t first_byte_timestamp;
+	uint32_t last_byte_timestamp;
+} __attribute__((__packed__)) ReadFrameTimestamp_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t message_length;
+	uint16_t message_chunk_offset;
+	char message_chunk_data[60];
+	uint32_t first_byte_timestamp;
+	uint32_t last_byte_timestamp;
+} __attribute__((__packed__)) ReadTimestampedLowLevel_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t crc_type;
+	bool append_tx;
+	bool verify_rx;
+	bool drop_invalid_rx;
+} __attribute__((__packed__)) SetCRCConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetCRCConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t crc_type;
+	bool append_tx;
+	bool verify_rx;
+	bool drop_invalid_rx;
+} __attribute__((__packed__)) GetCRCConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetCRCErrorCount;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t error_count_crc;
+} __attribute__((__packed__)) GetCRCErrorCount_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+	uint32_t response_timeout;
+} __attribute__((__packed__)) SetModbusMasterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetModbusMasterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+	uint32_t response_timeout;
+} __attribute__((__packed__)) GetModbusMasterConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t slave_address;
+	uint8_t function_code;
+	uint16_t address;
+	uint16_t count;
+	uint8_t data_length;
+	uint8_t data[56];
+} __attribute__((__packed__)) ModbusMasterRequest;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t request_id;
+} __attribute__((__packed__)) ModbusMasterRequest_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t request_id;
+	int8_t exception_code;
+	uint16_t data_length;
+	uint16_t data_chunk_offset;
+	uint8_t data_chunk_data[56];
+} __attribute__((__packed__)) ModbusMasterResponseLowLevel_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t index;
+	uint32_t period;
+	uint16_t response_length;
+	int16_t terminator;
+	uint8_t message_length;
+	uint8_t message[48];
+} __attribute__((__packed__)) SetPollEntry;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t index;
+} __attribute__((__packed__)) GetPollEntry;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	uint16_t response_length;
+	int16_t terminator;
+	uint8_t message_length;
+	uint8_t message[48];
+} __attribute__((__packed__)) GetPollEntry_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t message_length;
+	uint16_t message_chunk_offset;
+	char message_chunk_data[54];
+	uint16_t response_length;
+	int16_t terminator;
+	uint16_t timeout;
+} __attribute__((__packed__)) TransactionLowLevel;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t message_chunk_written;
+} __attribute__((__packed__)) TransactionLowLevel_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t status;
+	uint16_t response_length;
+	uint16_t response_chunk_offset;
+	char response_chunk_data[58];
+} __attribute__((__packed__)) TransactionResponseLowLevel_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetErrorCountExtended;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t error_count_overrun;
+	uint32_t error_count_parity;
+	uint32_t error_count_framing;
+	uint32_t error_count_break;
+	uint32_t error_count_noise;
+	uint32_t error_count_fifo_overflow;
+} __attribute__((__packed__)) GetErrorCountExtended_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t error_count_overrun;
+	uint32_t error_count_parity;
+	uint32_t error_count_framing;
+	uint32_t error_count_break;
+	uint32_t error_count_noise;
+	uint32_t error_count_fifo_overflow;
+} __attribute__((__packed__)) ErrorCountExtended_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetStatistics;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t main_loop_per_second;
+	uint32_t main_loop_period_max;
+	uint32_t rx_irq_duration_max;
+	uint32_t rx_irq_duration_average;
+	uint32_t tx_irq_duration_max;
+	uint32_t tx_irq_duration_average;
+	uint16_t rx_buffer_high_watermark;
+	uint16_t tx_buffer_high_watermark;
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint32_t rx_bytes_per_second;
+	uint32_t tx_bytes_per_second;
+	uint32_t callback_send_blocked;
+} __attribute__((__packed__)) GetStatistics_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ResetStatistics;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t rx_high_watermark;
+	uint8_t rx_low_watermark;
+} __attribute__((__packed__)) SetFlowcontrolConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetFlowcontrolConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t rx_high_watermark;
+	uint8_t rx_low_watermark;
+} __attribute__((__packed__)) GetFlowcontrolConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetFlowcontrolStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool rx_throttled;
+	bool tx_throttled;
+	uint32_t rx_throttled_time;
+	uint32_t tx_throttled_time;
+} __attribute__((__packed__)) GetFlowcontrolStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t timeout;
+} __attribute__((__packed__)) StartBaudrateDetection;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t baudrate;
+	uint32_t measured_baudrate;
+} __attribute__((__packed__)) BaudrateDetected_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetAchievedBaudrate;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t achieved_baudrate;
+	int32_t error_ppm;
+	uint8_t oversampling;
+	bool fractional_divider;
+} __attribute__((__packed__)) GetAchievedBaudrate_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) SaveConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool success;
+} __attribute__((__packed__)) SaveConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ClearSavedConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool success;
+} __attribute__((__packed__)) ClearSavedConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t baudrate;
+	uint8_t parity;
+	uint8_t stopbits;
+	uint8_t wordlength;
+	uint8_t flowcontrol;
+	uint16_t receive_buffer_size;
+	uint16_t send_buffer_size;
+	uint8_t tx_mode;
+} __attribute__((__packed__)) SetFullConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetReconfigurationStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool pending;
+	uint16_t send_buffer_used;
+} __attribute__((__packed__)) GetReconfigurationStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+	uint16_t receive_buffer_minimum;
+	uint16_t send_buffer_minimum;
+} __attribute__((__packed__)) SetBufferPoolConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetBufferPoolConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+	uint16_t receive_buffer_minimum;
+	uint16_t send_buffer_minimum;
+} __attribute__((__packed__)) GetBufferPoolConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t policy;
+} __attribute__((__packed__)) SetRXOverflowPolicy;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetRXOverflowPolicy;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t policy;
+	uint32_t dropped_newest;
+	uint32_t dropped_oldest;
+} __attribute__((__packed__)) GetRXOverflowPolicy_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t message_chunk_length;
+	char message_chunk_data[60];
+} __attribute__((__packed__)) WriteStreamLowLevel;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetWriteCredit;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t stream_received;
+	uint32_t stream_dropped;
+	uint16_t credit;
+} __attribute__((__packed__)) GetWriteCredit_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) SetWriteCreditCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetWriteCreditCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) GetWriteCreditCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t stream_received;
+	uint32_t stream_dropped;
+	uint16_t credit;
+} __attribute__((__packed__)) WriteCredit_Callback;
+
 // Function prototypes
 BootloaderHandleMessageResponse write_low_level(const WriteLowLevel *data, WriteLowLevel_Response *response);
 BootloaderHandleMessageResponse read_low_level(const ReadLowLevel *data, ReadLowLevel_Response *response);
@@ -233,18 +765,73 @@ BootloaderHandleMessageResponse get_buffer_status(const GetBufferStatus *data, G
 BootloaderHandleMessageResponse get_error_count(const GetErrorCount *data, GetErrorCount_Response *response);
 BootloaderHandleMessageResponse set_frame_readable_callback_configuration(const SetFrameReadableCallbackConfiguration *data);
 BootloaderHandleMessageResponse get_frame_readable_callback_configuration(const GetFrameReadableCallbackConfiguration *data, GetFrameReadableCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse set_frame_delimiter_configuration(const SetFrameDelimiterConfiguration *data);
+BootloaderHandleMessageResponse get_frame_delimiter_configuration(const GetFrameDelimiterConfiguration *data, GetFrameDelimiterConfiguration_Response *response);
+BootloaderHandleMessageResponse read_frame_low_level(const ReadFrameLowLevel *data, ReadFrameLowLevel_Response *response);
+BootloaderHandleMessageResponse set_frame_gap_configuration(const SetFrameGapConfiguration *data);
+BootloaderHandleMessageResponse get_frame_gap_configuration(const GetFrameGapConfiguration *data, GetFrameGapConfiguration_Response *response);
+BootloaderHandleMessageResponse set_frame_callback_configuration(const SetFrameCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_frame_callback_configuration(const GetFrameCallbackConfiguration *data, GetFrameCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse set_read_callback_coalescing_configuration(const SetReadCallbackCoalescingConfiguration *data);
+BootloaderHandleMessageResponse get_read_callback_coalescing_configuration(const GetReadCallbackCoalescingConfiguration *data, GetReadCallbackCoalescingConfiguration_Response *response);
+BootloaderHandleMessageResponse set_rx_timestamp_configuration(const SetRXTimestampConfiguration *data);
+BootloaderHandleMessageResponse get_rx_timestamp_configuration(const GetRXTimestampConfiguration *data, GetRXTimestampConfiguration_Response *response);
+BootloaderHandleMessageResponse read_frame_timestamp(const ReadFrameTimestamp *data, ReadFrameTimestamp_Response *response);
+BootloaderHandleMessageResponse set_crc_configuration(const SetCRCConfiguration *data);
+BootloaderHandleMessageResponse get_crc_configuration(const GetCRCConfiguration *data, GetCRCConfiguration_Response *response);
+BootloaderHandleMessageResponse get_crc_error_count(const GetCRCErrorCount *data, GetCRCErrorCount_Response *response);
+BootloaderHandleMessageResponse set_modbus_master_configuration(const SetModbusMasterConfiguration *data);
+BootloaderHandleMessageResponse get_modbus_master_configuration(const GetModbusMasterConfiguration *data, GetModbusMasterConfiguration_Response *response);
+BootloaderHandleMessageResponse modbus_master_request(const ModbusMasterRequest *data, ModbusMasterRequest_Response *response);
+BootloaderHandleMessageResponse set_poll_entry(const SetPollEntry *data);
+BootloaderHandleMessageResponse get_poll_entry(const GetPollEntry *data, GetPollEntry_Response *response);
+BootloaderHandleMessageResponse transaction_low_level(const TransactionLowLevel *data, TransactionLowLevel_Response *response);
+BootloaderHandleMessageResponse get_error_count_extended(const GetErrorCountExtended *data, GetErrorCountExtended_Response *response);
+BootloaderHandleMessageResponse get_statistics(const GetStatistics *data, GetStatistics_Response *response);
+BootloaderHandleMessageResponse reset_statistics(const ResetStatistics *data);
+BootloaderHandleMessageResponse set_flowcontrol_configuration(const SetFlowcontrolConfiguration *data);
+BootloaderHandleMessageResponse get_flowcontrol_configuration(const GetFlowcontrolConfiguration *data, GetFlowcontrolConfiguration_Response *response);
+BootloaderHandleMessageResponse get_flowcontrol_status(const GetFlowcontrolStatus *data, GetFlowcontrolStatus_Response *response);
+BootloaderHandleMessageResponse start_baudrate_detection(const StartBaudrateDetection *data);
+BootloaderHandleMessageResponse get_achieved_baudrate(const GetAchievedBaudrate *data, GetAchievedBaudrate_Response *response);
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data, SaveConfiguration_Response *response);
+BootloaderHandleMessageResponse clear_saved_configuration(const ClearSavedConfiguration *data, ClearSavedConfiguration_Response *response);
+BootloaderHandleMessageResponse set_full_configuration(const SetFullConfiguration *data);
+BootloaderHandleMessageResponse get_reconfiguration_status(const GetReconfigurationStatus *data, GetReconfigurationStatus_Response *response);
+BootloaderHandleMessageResponse set_buffer_pool_configuration(const SetBufferPoolConfiguration *data);
+BootloaderHandleMessageResponse get_buffer_pool_configuration(const GetBufferPoolConfiguration *data, GetBufferPoolConfiguration_Response *response);
+BootloaderHandleMessageResponse set_rx_overflow_policy(const SetRXOverflowPolicy *data);
+BootloaderHandleMessageResponse get_rx_overflow_policy(const GetRXOverflowPolicy *data, GetRXOverflowPolicy_Response *response);
+BootloaderHandleMessageResponse write_stream_low_level(const WriteStreamLowLevel *data);
+BootloaderHandleMessageResponse get_write_credit(const GetWriteCredit *data, GetWriteCredit_Response *response);
+BootloaderHandleMessageResponse set_write_credit_callback_configuration(const SetWriteCreditCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_write_credit_callback_configuration(const GetWriteCreditCallbackConfiguration *data, GetWriteCreditCallbackConfiguration_Response *response);
 
 // Callbacks
 bool handle_read_low_level_callback(void);
 bool handle_error_count_callback(void);
 bool handle_frame_readable_callback(void);
+bool handle_frame_available_callback(void);
+bool handle_frame_low_level_callback(void);
+bool handle_modbus_master_response_low_level_callback(void);
+bool handle_transaction_response_low_level_callback(void);
+bool handle_error_count_extended_callback(void);
+bool handle_baudrate_detected_callback(void);
+bool handle_write_credit_callback(void);
 
 #define COMMUNICATION_CALLBACK_TICK_WAIT_MS 1
-#define COMMUNICATION_CALLBACK_HANDLER_NUM 3
+#define COMMUNICATION_CALLBACK_HANDLER_NUM 10
 #define COMMUNICATION_CALLBACK_LIST_INIT \
 	handle_read_low_level_callback, \
 	handle_error_count_callback, \
 	handle_frame_readable_callback, \
+	handle_frame_available_callback, \
+	handle_frame_low_level_callback, \
+	handle_modbus_master_response_low_level_callback, \
+	handle_transaction_response_low_level_callback, \
+	handle_error_count_extended_callback, \
+	handle_baudrate_detected_callback, \
+	handle_write_credit_callback, \
 
 
 #endif
@@ -55,4 +55,38 @@
 #define RS232_IRQ_RXA_PRIORITY    0
 #define RS232_IRQCTRL_RXA         XMC_SCU_IRQCTRL_USIC1_SR4_IRQ13
 
+// CTS edge interrupt, P2.10 is ERU0.3B1.
+#define RS232_CTS_ERU             XMC_ERU0
+#define RS232_CTS_ERU_ETL_CHANNEL 3
+#define RS232_CTS_ERU_ETL_INPUT   XMC_ERU_ETL_INPUT_B1
+#define RS232_CTS_ERU_OGU_CHANNEL 2
+
+#define RS232_IRQ_CTS             5
+#define RS232_IRQ_CTS_PRIORITY    1
+#define RS232_IRQCTRL_CTS         XMC_SCU_IRQCTRL_ERU0_SR2_IRQ5
+
+// RX edge interrupt for the baudrate detection, P2.13 is ERU0.2A2.
+#define RS232_RX_ERU              XMC_ERU0
+#define RS232_RX_ERU_ETL_CHANNEL  2
+#define RS232_RX_ERU_ETL_INPUT    XMC_ERU_ETL_INPUT_A2
+#define RS232_RX_ERU_OGU_CHANNEL  3
+
+#define RS232_IRQ_RX_EDGE          6
+#define RS232_IRQ_RX_EDGE_PRIORITY 0
+#define RS232_IRQCTRL_RX_EDGE      XMC_SCU_IRQCTRL_ERU0_SR3_IRQ6
+
+// Frame gap timer.
+#define RS232_FRAME_GAP_CCU4              CCU40
+#define RS232_FRAME_GAP_CCU4_SLICE        CCU40_CC40
+#define RS232_FRAME_GAP_CCU4_SLICE_NUMBER 0
+#define RS232_FRAME_GAP_SHADOW_TRANSFER   (XMC_CCU4_SHADOW_TRANSFER_SLICE_0 | XMC_CCU4_SHADOW_TRANSFER_PRESCALER_SLICE_0)
+#define RS232_FRAME_GAP_SERVICE_REQUEST   XMC_CCU4_SLICE_SR_ID_0
+
+#define RS232_IRQ_FRAME_GAP               21
+#define RS232_IRQ_FRAME_GAP_PRIORITY      1
+#define RS232_IRQCTRL_FRAME_GAP           XMC_SCU_IRQCTRL_CCU40_SR0_IRQ21
+
+// RX/TX interrupt durations for GetStatistics, costs two SysTick reads per interrupt.
+#define RS232_STATISTICS_IRQ_DURATION
+
 #endif
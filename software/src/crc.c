@@ -0,0 +1,143 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * crc.c: CRC and checksum calculation for RX/TX frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "crc.h"
+
+#include "communication.h"
+
+/*
+ * The CRCs are calculated one nibble at a time with 16 entry tables, this
+ * needs 128 byte of flash for all three CRCs instead of 2.5kB for byte
+ * tables and is still about four times faster than bitwise calculation.
+ */
+
+// CRC-16/MODBUS: reflected polynomial 0x8005 (0xA001), init 0xFFFF.
+static const uint16_t crc_table_modbus[16] = {
+	0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+	0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+};
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, init 0xFFFF.
+static const uint16_t crc_table_ccitt[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+// CRC-32 (IEEE 802.3): reflected polynomial 0x04C11DB7 (0xEDB88320), init and xorout 0xFFFFFFFF.
+static const uint32_t crc_table_crc32[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint8_t crc_get_length(const uint8_t type) {
+	switch(type) {
+		case RS232_V2_CRC_TYPE_CRC16_MODBUS: return 2;
+		case RS232_V2_CRC_TYPE_CRC16_CCITT:  return 2;
+		case RS232_V2_CRC_TYPE_CRC32:        return 4;
+		case RS232_V2_CRC_TYPE_XOR8:         return 1;
+		case RS232_V2_CRC_TYPE_SUM8:         return 1;
+		default:                             return 0;
+	}
+}
+
+uint32_t crc_start(const uint8_t type) {
+	switch(type) {
+		case RS232_V2_CRC_TYPE_CRC16_MODBUS: return 0xFFFF;
+		case RS232_V2_CRC_TYPE_CRC16_CCITT:  return 0xFFFF;
+		case RS232_V2_CRC_TYPE_CRC32:        return 0xFFFFFFFF;
+		default:                             return 0;
+	}
+}
+
+uint32_t crc_update(const uint8_t type, uint32_t crc, const uint8_t *data, const uint16_t length) {
+	switch(type) {
+		case RS232_V2_CRC_TYPE_CRC16_MODBUS:
+			for(uint16_t i = 0; i < length; i++) {
+				crc = (crc >> 4) ^ crc_table_modbus[(crc ^ data[i]) & 0xF];
+				crc = (crc >> 4) ^ crc_table_modbus[(crc ^ (data[i] >> 4)) & 0xF];
+			}
+
+			break;
+
+		case RS232_V2_CRC_TYPE_CRC16_CCITT:
+			for(uint16_t i = 0; i < length; i++) {
+				crc = ((crc << 4) & 0xFFFF) ^ crc_table_ccitt[((crc >> 12) ^ (data[i] >> 4)) & 0xF];
+				crc = ((crc << 4) & 0xFFFF) ^ crc_table_ccitt[((crc >> 12) ^ data[i]) & 0xF];
+			}
+
+			break;
+
+		case RS232_V2_CRC_TYPE_CRC32:
+			for(uint16_t i = 0; i < length; i++) {
+				crc = (crc >> 4) ^ crc_table_crc32[(crc ^ data[i]) & 0xF];
+				crc = (crc >> 4) ^ crc_table_crc32[(crc ^ (data[i] >> 4)) & 0xF];
+			}
+
+			break;
+
+		case RS232_V2_CRC_TYPE_XOR8:
+			for(uint16_t i = 0; i < length; i++) {
+				crc ^= data[i];
+			}
+
+			break;
+
+		case RS232_V2_CRC_TYPE_SUM8:
+			for(uint16_t i = 0; i < length; i++) {
+				crc += data[i];
+			}
+
+			break;
+
+		default: break;
+	}
+
+	return crc;
+}
+
+// Writes the checksum in the byte order in which it is sent on the line.
+void crc_finish(const uint8_t type, const uint32_t crc, uint8_t *checksum) {
+	switch(type) {
+		case RS232_V2_CRC_TYPE_CRC16_MODBUS:
+			checksum[0] = crc & 0xFF;
+			checksum[1] = (crc >> 8) & 0xFF;
+			break;
+
+		case RS232_V2_CRC_TYPE_CRC16_CCITT:
+			checksum[0] = (crc >> 8) & 0xFF;
+			checksum[1] = crc & 0xFF;
+			break;
+
+		case RS232_V2_CRC_TYPE_CRC32:
+			checksum[0] = ~crc & 0xFF;
+			checksum[1] = (~crc >> 8) & 0xFF;
+			checksum[2] = (~crc >> 16) & 0xFF;
+			checksum[3] = (~crc >> 24) & 0xFF;
+			break;
+
+		case RS232_V2_CRC_TYPE_XOR8:
+		case RS232_V2_CRC_TYPE_SUM8:
+			checksum[0] = crc & 0xFF;
+			break;
+
+		default: break;
+	}
+}
@@ -0,0 +1,35 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * crc.h: CRC and checksum calculation for RX/TX frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+
+#define CRC_MAX_LENGTH 4
+
+// The type is one of the RS232_V2_CRC_TYPE_* constants.
+uint8_t crc_get_length(const uint8_t type);
+uint32_t crc_start(const uint8_t type);
+uint32_t crc_update(const uint8_t type, uint32_t crc, const uint8_t *data, const uint16_t length);
+void crc_finish(const uint8_t type, const uint32_t crc, uint8_t *checksum);
+
+#endif
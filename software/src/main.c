@@ -28,6 +28,7 @@
 
 #include "configs/config.h"
 #include "communication.h"
+#include "modbus.h"
 #include "rs232.h"
 
 int main(void) {
@@ -36,9 +37,11 @@ int main(void) {
 
 	communication_init();
 	rs232_init();
+	modbus_init();
 
 	while(true) {
 		rs232_tick();
+		modbus_tick();
 		bootloader_tick();
 		communication_tick();
 	}
@@ -0,0 +1,337 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * modbus.c: Modbus RTU master
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "modbus.h"
+
+#include <string.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/logging/logging.h"
+
+#include "xmc_usic.h"
+#include "xmc_uart.h"
+
+#include "communication.h"
+#include "crc.h"
+#include "rs232.h"
+
+/*
+ * One request is handled at a time:
+ *
+ * IDLE -> WAIT_GAP: Request was submitted, wait for t3.5 of line silence.
+ * WAIT_GAP -> WAIT_TX: Telegram is in the TX buffer.
+ * WAIT_TX -> WAIT_RESPONSE: Telegram is on the line, response timeout starts.
+ * WAIT_RESPONSE -> RESPONSE_READY: Response (or error) is decoded into telegram.
+ * RESPONSE_READY -> IDLE: Response callback was sent.
+ *
+ * The end of the response is detected by the gap frame detection of rs232.c.
+ */
+
+Modbus_t modbus;
+
+static uint16_t modbus_get_uint16(const uint8_t *data) {
+	return (data[0] << 8) | data[1];
+}
+
+static void modbus_put_uint16(uint8_t *data, const uint16_t value) {
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+static void modbus_finish(const int8_t exception_code, const uint16_t data_length) {
+	modbus.exception_code = exception_code;
+	modbus.data_length = data_length;
+	modbus.idle_since_us = rs232_get_time_us();
+	modbus.state = MODBUS_STATE_RESPONSE_READY;
+}
+
+static void modbus_send(void) {
+	// Throw away everything that was received since the last response.
+	ringbuffer_remove(&rs232.rb_rx, ringbuffer_get_used(&rs232.rb_rx));
+	rs232_frame_reset();
+
+	rs232_ringbuffer_add_n(&rs232.rb_tx, modbus.telegram, modbus.telegram_length);
+	XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+
+	modbus.state = MODBUS_STATE_WAIT_TX;
+}
+
+// Decodes the response in telegram[0, length) in place, registers are converted to little endian.
+static void modbus_decode(const uint16_t length) {
+	uint8_t *const telegram = modbus.telegram;
+	uint8_t checksum[CRC_MAX_LENGTH];
+
+	if(length < 4) {
+		rs232.error_count_crc++;
+		modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_CRC_ERROR, 0);
+		return;
+	}
+
+	crc_finish(RS232_V2_CRC_TYPE_CRC16_MODBUS,
+	           crc_update(RS232_V2_CRC_TYPE_CRC16_MODBUS, crc_start(RS232_V2_CRC_TYPE_CRC16_MODBUS), telegram, length - 2),
+	           checksum);
+
+	if((checksum[0] != telegram[length - 2]) || (checksum[1] != telegram[length - 1])) {
+		rs232.error_count_crc++;
+		modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_CRC_ERROR, 0);
+		return;
+	}
+
+	if(telegram[1] == (modbus.function_code | 0x80)) {
+		modbus_finish((length == 5) ? (int8_t)telegram[2] : RS232_V2_MODBUS_EXCEPTION_CODE_INVALID_RESPONSE, 0);
+		return;
+	}
+
+	if(telegram[1] != modbus.function_code) {
+		modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_INVALID_RESPONSE, 0);
+		return;
+	}
+
+	switch(modbus.function_code) {
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_COILS:
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_DISCRETE_INPUTS: {
+			const uint8_t byte_count = telegram[2];
+
+			if((byte_count != (modbus.count + 7) / 8) || (length != 5 + byte_count)) {
+				break;
+			}
+
+			memmove(telegram, &telegram[3], byte_count);
+			modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_SUCCESS, byte_count);
+			return;
+		}
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_HOLDING_REGISTERS:
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_INPUT_REGISTERS: {
+			const uint8_t byte_count = telegram[2];
+
+			if((byte_count != modbus.count * 2) || (length != 5 + byte_count)) {
+				break;
+			}
+
+			for(uint8_t i = 0; i < byte_count; i += 2) {
+				telegram[i]     = telegram[3 + i + 1];
+				telegram[i + 1] = telegram[3 + i];
+			}
+
+			modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_SUCCESS, byte_count);
+			return;
+		}
+
+		default: // Write requests are acknowledged with an echo of the address.
+			if((length != 8) || (modbus_get_uint16(&telegram[2]) != modbus.address)) {
+				break;
+			}
+
+			modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_SUCCESS, 0);
+			return;
+	}
+
+	modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_INVALID_RESPONSE, 0);
+}
+
+void modbus_tick(void) {
+	switch(modbus.state) {
+		case MODBUS_STATE_WAIT_GAP:
+			if((uint32_t)(rs232_get_time_us() - modbus.idle_since_us) >= modbus.gap_us) {
+				modbus_send();
+			}
+
+			break;
+
+		case MODBUS_STATE_WAIT_TX:
+			if((ringbuffer_get_used(&rs232.rb_tx) != 0) || (XMC_USIC_CH_TXFIFO_GetLevel(RS232_USIC) != 0)) {
+				break;
+			}
+
+			if(modbus.slave_address == 0) {
+				// Broadcasts are not answered.
+				modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_SUCCESS, 0);
+				break;
+			}
+
+			modbus.response_start = system_timer_get_ms();
+			modbus.state = MODBUS_STATE_WAIT_RESPONSE;
+			break;
+
+		case MODBUS_STATE_WAIT_RESPONSE: {
+			const uint16_t length = rs232_frame_pop();
+
+			if(length > 0) {
+				const uint16_t count = (length > MODBUS_TELEGRAM_MAX_LENGTH) ? MODBUS_TELEGRAM_MAX_LENGTH : length;
+
+				rs232_ringbuffer_get_n(&rs232.rb_rx, modbus.telegram, count);
+				ringbuffer_remove(&rs232.rb_rx, length - count);
+
+				// Responses of other slaves are ignored.
+				if((length < 2) || (modbus.telegram[0] == modbus.slave_address)) {
+					modbus_decode(length);
+				}
+			}
+			else if(system_timer_is_time_elapsed_ms(modbus.response_start, modbus.response_timeout)) {
+				modbus_finish(RS232_V2_MODBUS_EXCEPTION_CODE_TIMEOUT, 0);
+			}
+
+			break;
+		}
+
+		default: break;
+	}
+}
+
+void modbus_response_done(void) {
+	modbus.state = MODBUS_STATE_IDLE;
+}
+
+void modbus_set_enabled(const bool enabled) {
+	modbus.enabled = enabled;
+	rs232_rx_drop_oldest_update();
+	modbus.state = MODBUS_STATE_IDLE;
+
+	if(!enabled) {
+		rs232_frame_disable();
+		return;
+	}
+
+	// t3.5 in 1/10 character times for the gap frame detection.
+	const uint32_t character_bits = 1 + rs232.wordlength + rs232.stopbits +
+	                                ((rs232.parity == RS232_V2_PARITY_NONE) ? 0 : 1);
+	uint32_t gap_length = 35;
+
+	if(rs232.baudrate > MODBUS_GAP_FIXED_BAUDRATE) {
+		gap_length = (MODBUS_GAP_FIXED_US * rs232.baudrate / character_bits + 99999) / 100000;
+	}
+
+	modbus.gap_us = (gap_length * character_bits * 100000) / rs232.baudrate;
+	modbus.idle_since_us = rs232_get_time_us();
+
+	rs232_frame_set_gap(gap_length);
+}
+
+// Returns the request ID or 0 if the request is invalid or another request is in progress.
+uint8_t modbus_request(const uint8_t slave_address, const uint8_t function_code, const uint16_t address, const uint16_t count, const uint8_t *data, const uint8_t data_length) {
+	uint8_t *const telegram = modbus.telegram;
+	uint16_t length = 0;
+
+	if(!modbus.enabled || (modbus.state != MODBUS_STATE_IDLE)) {
+		return 0;
+	}
+
+	telegram[length++] = slave_address;
+	telegram[length++] = function_code;
+	modbus_put_uint16(&telegram[length], address);
+	length += 2;
+
+	switch(function_code) {
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_COILS:
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_DISCRETE_INPUTS:
+			if((count == 0) || (count > 2000) || (slave_address == 0)) {
+				return 0;
+			}
+
+			modbus_put_uint16(&telegram[length], count);
+			length += 2;
+			break;
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_HOLDING_REGISTERS:
+		case RS232_V2_MODBUS_FUNCTION_CODE_READ_INPUT_REGISTERS:
+			if((count == 0) || (count > 125) || (slave_address == 0)) {
+				return 0;
+			}
+
+			modbus_put_uint16(&telegram[length], count);
+			length += 2;
+			break;
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_WRITE_SINGLE_COIL:
+			modbus_put_uint16(&telegram[length], (count != 0) ? 0xFF00 : 0x0000);
+			length += 2;
+			break;
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_WRITE_SINGLE_REGISTER:
+			modbus_put_uint16(&telegram[length], count);
+			length += 2;
+			break;
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_WRITE_MULTIPLE_COILS:
+			if((count == 0) || (data_length != (count + 7) / 8)) {
+				return 0;
+			}
+
+			modbus_put_uint16(&telegram[length], count);
+			length += 2;
+			telegram[length++] = data_length;
+			memcpy(&telegram[length], data, data_length);
+			length += data_length;
+			break;
+
+		case RS232_V2_MODBUS_FUNCTION_CODE_WRITE_MULTIPLE_REGISTERS:
+			if((count == 0) || (data_length != count * 2)) {
+				return 0;
+			}
+
+			modbus_put_uint16(&telegram[length], count);
+			length += 2;
+			telegram[length++] = data_length;
+
+			// Registers are given in little endian.
+			for(uint8_t i = 0; i < data_length; i += 2) {
+				telegram[length++] = data[i + 1];
+				telegram[length++] = data[i];
+			}
+
+			break;
+
+		default: return 0;
+	}
+
+	uint8_t checksum[CRC_MAX_LENGTH];
+	crc_finish(RS232_V2_CRC_TYPE_CRC16_MODBUS,
+	           crc_update(RS232_V2_CRC_TYPE_CRC16_MODBUS, crc_start(RS232_V2_CRC_TYPE_CRC16_MODBUS), telegram, length),
+	           checksum);
+	telegram[length++] = checksum[0];
+	telegram[length++] = checksum[1];
+
+	modbus.telegram_length = length;
+	modbus.slave_address = slave_address;
+	modbus.function_code = function_code;
+	modbus.address = address;
+	modbus.count = count;
+
+	modbus.request_id++;
+	if(modbus.request_id == 0) {
+		modbus.request_id = 1;
+	}
+
+	modbus.state = MODBUS_STATE_WAIT_GAP;
+
+	return modbus.request_id;
+}
+
+void modbus_init(void) {
+	logd("[+] RS232-V2: modbus_init()\n\r");
+
+	modbus.enabled = false;
+	modbus.response_timeout = 1000;
+	modbus.state = MODBUS_STATE_IDLE;
+	modbus.request_id = 0;
+}
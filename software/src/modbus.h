@@ -0,0 +1,73 @@
+/* rs232-v2-bricklet
+ * Copyright (C) 2026 Tinkerforge GmbH <info@tinkerforge.com>
+ *
+ * modbus.h: Modbus RTU master
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MODBUS_TELEGRAM_MAX_LENGTH 256
+#define MODBUS_REQUEST_DATA_MAX_LENGTH 56
+
+// Above 19200 baud the Modbus RTU specification uses a fixed t3.5 of 1750us.
+#define MODBUS_GAP_FIXED_BAUDRATE 19200
+#define MODBUS_GAP_FIXED_US 1750
+
+typedef enum {
+	MODBUS_STATE_IDLE = 0,
+	MODBUS_STATE_WAIT_GAP,
+	MODBUS_STATE_WAIT_TX,
+	MODBUS_STATE_WAIT_RESPONSE,
+	MODBUS_STATE_RESPONSE_READY
+} ModbusState_t;
+
+typedef struct {
+	bool enabled;
+	uint32_t response_timeout;
+	uint32_t gap_us;
+
+	ModbusState_t state;
+	uint8_t request_id;
+	uint8_t slave_address;
+	uint8_t function_code;
+	uint16_t address;
+	uint16_t count;
+	uint32_t idle_since_us;
+	uint32_t response_start;
+
+	// Telegram to be sent, later the received response and then the decoded data.
+	uint8_t telegram[MODBUS_TELEGRAM_MAX_LENGTH];
+	uint16_t telegram_length;
+
+	int8_t exception_code;
+	uint16_t data_length;
+} Modbus_t;
+
+extern Modbus_t modbus;
+
+void modbus_init(void);
+void modbus_tick(void);
+void modbus_set_enabled(const bool enabled);
+uint8_t modbus_request(const uint8_t slave_address, const uint8_t function_code, const uint16_t address, const uint16_t count, const uint8_t *data, const uint8_t data_length);
+void modbus_response_done(void);
+
+#endif
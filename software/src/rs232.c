@@ -21,20 +21,44 @@
 
 #include "rs232.h"
 
+#include <string.h>
+
 #include "bricklib2/hal/system_timer/system_timer.h"
 #include "bricklib2/utility/ringbuffer.h"
 #include "bricklib2/logging/logging.h"
+#include "bricklib2/bootloader/bootloader.h"
 
 #include "xmc_scu.h"
+#include "xmc_ccu4.h"
+#include "xmc_eru.h"
 #include "xmc_usic.h"
 #include "xmc_uart.h"
 
 #include "communication.h"
+#include "crc.h"
+#include "modbus.h"
 #include "configs/config.h"
 
 #define rs232_rx_irq_handler  IRQ_Hdlr_11
 #define rs232_tx_irq_handler  IRQ_Hdlr_12
 #define rs232_rxa_irq_handler IRQ_Hdlr_13
+#define rs232_frame_gap_irq_handler IRQ_Hdlr_21
+#define rs232_cts_irq_handler IRQ_Hdlr_5
+#define rs232_rx_edge_irq_handler IRQ_Hdlr_6
+
+#define RS232_TX_FIFO_SIZE 32
+
+#define RS232_ERROR_STATUS_FLAGS (XMC_UART_CH_STATUS_FLAG_SYNCHRONIZATION_BREAK_DETECTED | \
+                                  XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0 | \
+                                  XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_1 | \
+                                  XMC_UART_CH_STATUS_FLAG_RECEIVER_NOISE_DETECTED | \
+                                  XMC_UART_CH_STATUS_FLAG_DATA_LOST_INDICATION | \
+                                  XMC_UART_CH_STATUS_FLAG_ALTERNATIVE_RECEIVE_INDICATION)
+
+#define RS232_ERROR_EVENTS (XMC_UART_CH_EVENT_SYNCHRONIZATION_BREAK | \
+                            XMC_UART_CH_EVENT_FORMAT_ERROR | \
+                            XMC_UART_CH_EVENT_RECEIVER_NOISE | \
+                            XMC_UART_CH_EVENT_DATA_LOST)
 
 /*
  * Set const pointers to RX ringbuffer variables.
@@ -49,345 +73,2886 @@ uint16_t *const rs232_rb_rx_size = &(rs232.rb_rx.size);
 
 RS232_t rs232;
 
-void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_irq_handler() {
+// Handles XON/XOFF from the peer, returns true if rx_byte was a control byte.
+static inline bool __attribute__((always_inline)) rs232_rx_handle_fc_sw_byte(const uint8_t rx_byte) {
+	if(rx_byte == FC_SW_XON) {
+		rs232.fc_sw_state_tx = FC_SW_STATE_TX_OK;
+
+		return true;
+	}
+	else if(rx_byte == FC_SW_XOFF) {
+		rs232.fc_sw_state_tx = FC_SW_STATE_TX_WAIT;
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * The RX FIFO word (OUTR) carries the receiver control information (RCI)
+ * next to the data. In ASC mode RCI[4] is the parity error flag of the word.
+ */
+#define RS232_RX_WORD_PARITY_ERROR_POS (USIC_CH_OUTR_RCI_Pos + 4)
+
+/*
+ * Copies count bytes from the RX FIFO to dst and returns the number of
+ * stored bytes. With software flow control we don't treat XON/XOFF control
+ * bytes as data, so less than count bytes may be stored.
+ *
+ * Parity errors are counted per received word from the RCI.
+ */
+static inline uint16_t __attribute__((always_inline)) rs232_rx_fifo_copy(uint8_t *dst, const uint16_t count, const bool fc_sw) {
+	uint32_t parity_errors = 0;
+
+	if(!fc_sw) {
+		for(uint16_t i = 0; i < count; i++) {
+			const uint32_t word = RS232_USIC->OUTR;
+
+			dst[i] = (uint8_t)word;
+			parity_errors += (word >> RS232_RX_WORD_PARITY_ERROR_POS) & 1;
+		}
+
+		rs232._error_count_parity += parity_errors;
+
+		return count;
+	}
+
+	uint16_t stored = 0;
+	for(uint16_t i = 0; i < count; i++) {
+		const uint32_t word = RS232_USIC->OUTR;
+		const uint8_t rx_byte = (uint8_t)word;
+
+		parity_errors += (word >> RS232_RX_WORD_PARITY_ERROR_POS) & 1;
+
+		if(!rs232_rx_handle_fc_sw_byte(rx_byte)) {
+			dst[stored++] = rx_byte;
+		}
+	}
+
+	rs232._error_count_parity += parity_errors;
+
+	return stored;
+}
+
+/*
+ * Time derived from the 1ms system timer and the SysTick counter, returns the
+ * ms and the CPU cycles elapsed in that ms. If the SysTick wrapped but its
+ * interrupt is still pending (we are called from a higher priority
+ * interrupt), the ms counter is one behind.
+ */
+static inline uint32_t __attribute__((always_inline)) rs232_get_time(uint32_t *cycles, const uint32_t load) {
+	uint32_t ms;
+	uint32_t val;
+	bool pending;
+
+	do {
+		ms = system_timer_get_ms();
+		val = SysTick->VAL;
+		pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+	} while(ms != system_timer_get_ms());
+
+	if(pending && (val > load / 2)) {
+		ms++;
+	}
+
+	*cycles = load - 1 - val;
+
+	return ms;
+}
+
+uint32_t rs232_get_time_us(void) {
+	const uint32_t load = SysTick->LOAD + 1;
+	uint32_t cycles;
+	const uint32_t ms = rs232_get_time(&cycles, load);
+
+	return ms * 1000 + (cycles * 1000) / load;
+}
+
+// CPU cycles, wraps around after 2^32 cycles (89s at 48MHz).
+uint32_t rs232_get_time_cycles(void) {
+	const uint32_t load = SysTick->LOAD + 1;
+	uint32_t cycles;
+	const uint32_t ms = rs232_get_time(&cycles, load);
+
+	return ms * load + cycles;
+}
+
+/*
+ * SysTick counts down from LOAD with the CPU clock and is reloaded every ms.
+ * Adds the CPU cycles since start (a SysTick value) to the IRQ statistics.
+ * Only used with RS232_STATISTICS_IRQ_DURATION (see config_rs232.h).
+ */
+static inline void __attribute__((always_inline)) rs232_statistics_irq(RS232IRQStatistics_t *const irq, const uint32_t start) {
+	const uint32_t end = SysTick->VAL;
+	const uint32_t cycles = (start >= end) ? (start - end) : (start + SysTick->LOAD + 1 - end);
+
+	irq->count++;
+	irq->cycles += cycles;
+	if(cycles > irq->cycles_max) {
+		irq->cycles_max = cycles;
+	}
+}
+
+/*
+ * Called from the RX interrupt for every burst of count bytes if RX
+ * timestamps are enabled. In frame readable mode the timestamps of the
+ * first and the last burst of every frame are queued. The times are taken
+ * in CPU cycles, rs232_rx_time_update() converts them to us.
+ */
+static void rs232_rx_timestamp(uint16_t count) {
+	const uint32_t now = rs232_get_time_cycles();
+	const uint16_t frame_size = rs232.frame_readable_cb_frame_size;
+
+	rs232.rx_newest_cycles = now;
+	rs232.rx_time_new |= RX_TIME_NEW_NEWEST;
+
+	if(frame_size == 0) {
+		return;
+	}
+
+	while(count > 0) {
+		if(rs232.rx_timestamp_frame_fill == 0) {
+			rs232.rx_timestamp_frame_first = now;
+		}
+
+		uint16_t fill = frame_size - rs232.rx_timestamp_frame_fill;
+		if(fill > count) {
+			fill = count;
+		}
+
+		rs232.rx_timestamp_frame_fill += fill;
+		count -= fill;
+
+		if(rs232.rx_timestamp_frame_fill == frame_size) {
+			rs232.rx_timestamp_frame_fill = 0;
+
+			// If the timestamps are not read the oldest ones are overwritten.
+			if(rs232.rx_timestamp_count == RX_TIMESTAMP_QUEUE_SIZE) {
+				rs232.rx_timestamp_first = (rs232.rx_timestamp_first + 1) % RX_TIMESTAMP_QUEUE_SIZE;
+				rs232.rx_timestamp_count--;
+				if(rs232.rx_timestamp_converted > 0) {
+					rs232.rx_timestamp_converted--;
+				}
+			}
+
+			RS232RXTimestamp_t *const timestamp = &rs232.rx_timestamp[(rs232.rx_timestamp_first + rs232.rx_timestamp_count) % RX_TIMESTAMP_QUEUE_SIZE];
+			timestamp->first_byte = rs232.rx_timestamp_frame_first;
+			timestamp->last_byte = now;
+			rs232.rx_timestamp_count++;
+		}
+	}
+}
+
+/*
+ * The interrupt handlers are specialized per flow control mode. The
+ * flowcontrol argument is always a constant, so every variant below is
+ * compiled without the flow control branches of the other modes.
+ */
+/*
+ * Starts the frame gap timer with the first byte after a frame and restarts
+ * the current gap with every further byte, so that the gap is measured from
+ * the last received byte. Called from the RX interrupt, the frame gap
+ * interrupt has a lower priority and can't preempt it.
+ */
+static inline void __attribute__((always_inline)) rs232_frame_gap_retrigger(const uint16_t position) {
+	if(rs232.frame_gap_timer_running && (position == rs232.frame_gap_position)) {
+		// Only moved from the RX FIFO to the ringbuffer, already seen by the frame gap interrupt.
+		return;
+	}
+
+	rs232.frame_gap_position = position;
+	rs232.frame_gap_idle = 0;
+	XMC_CCU4_SLICE_ClearTimer(RS232_FRAME_GAP_CCU4_SLICE);
+
+	if(!rs232.frame_gap_timer_running) {
+		rs232.frame_gap_timer_running = true;
+		XMC_CCU4_SLICE_StartTimer(RS232_FRAME_GAP_CCU4_SLICE);
+	}
+}
+
+static inline void __attribute__((always_inline)) rs232_rx_irq_handler_flowcontrol(const int flowcontrol) {
 	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
 	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
 
-	while(!XMC_USIC_CH_RXFIFO_IsEmpty(RS232_USIC)) {
-		uint8_t rx_byte = RS232_USIC->OUTR;
-		uint16_t rb_rx_used = (*rs232_rb_rx_end < *rs232_rb_rx_start) ? \
-		                      (*rs232_rb_rx_size + *rs232_rb_rx_end - *rs232_rb_rx_start) : \
-		                      (*rs232_rb_rx_end - *rs232_rb_rx_start);
-
-		if (rs232.flowcontrol != RS232_V2_FLOWCONTROL_OFF) {
-			// Flow control enabled.
-			if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE) {
-				// Software flow control.
-				if (rx_byte == FC_SW_XON) {
-					rs232.fc_sw_state_tx = FC_SW_STATE_TX_OK;
-
-					// We don't treat XON/XOFF control byte as data.
-					continue;
-				}
-				else if (rx_byte == FC_SW_XOFF) {
-					rs232.fc_sw_state_tx = FC_SW_STATE_TX_WAIT;
+	const bool fc_sw = flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE;
+	const uint16_t size = *rs232_rb_rx_size;
+	uint16_t end = *rs232_rb_rx_end;
+	const uint16_t end_before = end;
+	const bool rb_was_empty = end == *rs232_rb_rx_start;
+	uint16_t level;
 
-					// We don't treat XON/XOFF control byte as data.
-					continue;
-				}
+	/*
+	 * Instead of ringbuffer_add() we add the bytes to the buffer by hand.
+	 * The FIFO fill level and the free space of the ringbuffer are read once
+	 * per burst and the burst is copied in at most two contiguous segments
+	 * (up to and after the wrap point).
+	 */
+	while((level = XMC_USIC_CH_RXFIFO_GetLevel(RS232_USIC)) > 0) {
+		uint16_t start = *rs232_rb_rx_start;
+		uint16_t free = ((end < start) ? (start - end) : (size - end + start)) - 1;
 
-				if((rs232.buffer_size_rx - rb_rx_used) <= FC_RB_RX_LIMIT) {
-					// We can't RX more data.
+		if((free < level) && rs232.rx_drop_oldest_in_irq) {
+			const uint16_t drop = level - free;
 
-					// TX XOFF from rs232_tick().
-					rs232.fc_sw_tx_xoff = true;
-					rs232.fc_sw_state_rx = FC_SW_STATE_RX_WAIT;
-				}
+			start += drop;
+			if(start >= size) {
+				start -= size;
 			}
-			else if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_HARDWARE) {
-				// Hardware flow control.
-				if((rs232.buffer_size_rx - rb_rx_used) <= FC_RB_RX_LIMIT) {
-					// We can't RX more data.
-
-					/*
-					 * XMC_GPIO_SetOutputHigh(RS232_RTS_PIN);
-					 * |
-					 * | ---> RS232 logic 0.
-					 *
-					 * XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
-					 * |
-					 * | ---> RS232 logic 1.
-					 */
-
-					// De-assert RTS pin.
-					XMC_GPIO_SetOutputHigh(RS232_RTS_PIN);
-				}
+			*rs232_rb_rx_start = start;
+
+			free += drop;
+			rs232._error_count_overrun += drop;
+			rs232.rx_overflow_dropped_oldest += drop;
+		}
+
+		while((level > 0) && (free > 0)) {
+			uint16_t count = size - end;
+
+			if(count > level) {
+				count = level;
+			}
+
+			if(count > free) {
+				count = free;
 			}
+
+			const uint16_t stored = rs232_rx_fifo_copy(&rs232_rb_rx_buffer[end], count, fc_sw);
+
+			end += stored;
+			if(end >= size) {
+				end = 0;
+			}
+
+			free -= stored;
+			level -= count;
 		}
 
 		/*
-		 * Instead of ringbuffer_add() we add the byte to the buffer by hand.
-		 * We need to save the low watermark calculation overhead.
+		 * In the case of an overrun we read the rest of the burst and throw it away.
+		 * With the drop-oldest policy this only happens if the main loop holds a
+		 * position in the RX ringbuffer and rs232_rx_drop_oldest_tick() did not
+		 * keep up, these bytes are counted as dropped newest.
 		 */
-		uint16_t new_end = *rs232_rb_rx_end + 1;
+		if(level > 0) {
+			uint16_t dropped = 0;
 
-		if(new_end >= *rs232_rb_rx_size) {
-			new_end = 0;
+			for(; level > 0; level--) {
+				const uint8_t rx_byte = (uint8_t)RS232_USIC->OUTR;
+
+				if(!fc_sw || !rs232_rx_handle_fc_sw_byte(rx_byte)) {
+					dropped++;
+				}
+			}
+
+			rs232._error_count_overrun += dropped;
+			rs232.rx_overflow_dropped_newest += dropped;
+		}
+
+		*rs232_rb_rx_end = end;
+
+		const uint16_t used = size - 1 - free;
+		if(used > rs232.statistics.rx_buffer_high_watermark) {
+			rs232.statistics.rx_buffer_high_watermark = used;
+		}
+
+		// Flow control high watermark is evaluated once per burst.
+		if((flowcontrol != RS232_V2_FLOWCONTROL_OFF) && (free < rs232.fc_rx_stop_free)) {
+			// We can't RX more data.
+			if(fc_sw) {
+				// TX XOFF from the TX interrupt, ahead of the TX ringbuffer.
+				rs232.fc_sw_tx_control = FC_SW_XOFF;
+				rs232.fc_sw_state_rx = FC_SW_STATE_RX_WAIT;
+				XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+				XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+			}
+			else {
+				/*
+				 * XMC_GPIO_SetOutputHigh(RS232_RTS_PIN);
+				 * |
+				 * | ---> RS232 logic 0.
+				 *
+				 * XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
+				 * |
+				 * | ---> RS232 logic 1.
+				 */
+
+				// De-assert RTS pin.
+				XMC_GPIO_SetOutputHigh(RS232_RTS_PIN);
+				rs232.fc_hw_rx_wait = true;
+			}
 		}
+	}
+
+	/*
+	 * RTS is asserted again by the same handler once the buffer drained to
+	 * the low watermark. While RTS is de-asserted no RX interrupt comes in,
+	 * the call from rs232_tick covers that case.
+	 */
+	if((flowcontrol == RS232_V2_FLOWCONTROL_HARDWARE) && rs232.fc_hw_rx_wait) {
+		const uint16_t start = *rs232_rb_rx_start;
+		const uint16_t used = (end < start) ? (size + end - start) : (end - start);
+
+		if(used <= rs232.fc_rx_resume_used) {
+			// Assert RTS pin.
+			XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
+			rs232.fc_hw_rx_wait = false;
+		}
+	}
 
-		if(new_end == *rs232_rb_rx_start) {
-			rs232._error_count_overrun++;
+	if(end != end_before) {
+		const uint16_t received = (end > end_before) ? (end - end_before) : (size - end_before + end);
 
-			// In the case of an overrun we read the byte and throw it away.
-			volatile uint8_t __attribute__((unused)) _  = RS232_USIC->OUTR;
+		rs232.statistics.rx_bytes += received;
+		if(rs232.rx_timestamp_enabled) {
+			rs232_rx_timestamp(received);
 		}
-		else {
-			//rs232_rb_rx_buffer[*rs232_rb_rx_end] = RS232_USIC->OUTR;
-			rs232_rb_rx_buffer[*rs232_rb_rx_end] = rx_byte;
-			*rs232_rb_rx_end = new_end;
+
+		if(rs232.frame_gap_length > 0) {
+			rs232_frame_gap_retrigger(end);
 		}
 	}
 
+	// Remember when the oldest byte in the ringbuffer arrived.
+	if(rb_was_empty && (end != *rs232_rb_rx_start)) {
+		rs232.rx_oldest_cycles = rs232.rx_timestamp_enabled ? rs232.rx_newest_cycles : rs232_get_time_cycles();
+		rs232.rx_time_new |= RX_TIME_NEW_OLDEST;
+	}
+
 	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
 	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
 }
 
-void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_tx_irq_handler() {
-	while(!XMC_USIC_CH_TXFIFO_IsFull(RS232_USIC)) {
-		// TX FIFO is not full, more data can be loaded on the FIFO from the ringbuffer.
-		uint8_t data;
+/*
+ * With drain set, the TX FIFO is only refilled up to reconfigure_tx_end.
+ * Data written after that stays in the ringbuffer until the pending
+ * reconfiguration is applied.
+ */
+static inline void __attribute__((always_inline)) rs232_tx_irq_handler_flowcontrol(const int flowcontrol, const bool drain) {
+	if(flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE) {
+		/*
+		 * XON/XOFF bypass the TX ringbuffer. They are put into the TX FIFO
+		 * before it is refilled, so they go out behind at most the words
+		 * already in the TX FIFO and ahead of everything in the ringbuffer.
+		 * If the FIFO is full we keep the TX event enabled and try again.
+		 */
+		if(rs232.fc_sw_tx_control != 0) {
+			if(!XMC_USIC_CH_TXFIFO_IsFull(RS232_USIC)) {
+				XMC_USIC_CH_TXFIFO_PutData(RS232_USIC, rs232.fc_sw_tx_control);
+				rs232.fc_sw_tx_control = 0;
+			}
+		}
 
-		if(rs232.flowcontrol != RS232_V2_FLOWCONTROL_OFF) {
-			if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE) {
-				if(rs232.fc_sw_state_tx == FC_SW_STATE_TX_WAIT) {
-					XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
-					                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+		if(rs232.fc_sw_state_tx == FC_SW_STATE_TX_WAIT) {
+			if(rs232.fc_sw_tx_control == 0) {
+				XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
+				                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+			}
 
-					return;
-				}
+			return;
+		}
+	}
+	else if(flowcontrol == RS232_V2_FLOWCONTROL_HARDWARE) {
+		/*
+		 * XMC_GPIO_GetInput(RS232_CTS_PIN);
+		 * |
+		 * | ---> Return = 0 = RS232 logic 1.
+		 * | ---> Return = 1 = RS232 logic 0.
+		 */
+		if(XMC_GPIO_GetInput(RS232_CTS_PIN) == 1) {
+			XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
+			                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+
+			return;
+		}
+	}
+
+	/*
+	 * Instead of ringbuffer_get() we take the bytes from the buffer by hand.
+	 * The TX FIFO is refilled with as much data as fits, flow control is
+	 * checked once per refill (the FIFO content is sent out anyway).
+	 */
+	const uint16_t size = rs232.rb_tx.size;
+	const uint16_t end = drain ? rs232.reconfigure_tx_end : rs232.rb_tx.end;
+	uint16_t start = rs232.rb_tx.start;
+	const uint16_t used = (end < start) ? (size + end - start) : (end - start);
+	uint16_t count = RS232_TX_FIFO_SIZE - XMC_USIC_CH_TXFIFO_GetLevel(RS232_USIC);
+
+	if(count >= used) {
+		// No more data to TX from the ringbuffer after this, disable TX interrupt.
+		count = used;
+		XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
+		                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	}
+
+	rs232.statistics.tx_bytes += count;
+
+	for(; count > 0; count--) {
+		XMC_USIC_CH_TXFIFO_PutData(RS232_USIC, rs232.rb_tx.buffer[start]);
+
+		start++;
+		if(start >= size) {
+			start = 0;
+		}
+	}
+
+	rs232.rb_tx.start = start;
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_irq_handler_fc_off(void) {
+	rs232_rx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_OFF);
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_irq_handler_fc_software(void) {
+	rs232_rx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_SOFTWARE);
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_irq_handler_fc_hardware(void) {
+	rs232_rx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_HARDWARE);
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_tx_irq_handler_fc_off(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_OFF, false);
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_tx_irq_handler_fc_software(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_SOFTWARE, false);
+}
+
+static void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_tx_irq_handler_fc_hardware(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_HARDWARE, false);
+}
+
+static void __attribute__((optimize("-O3"))) rs232_tx_irq_handler_fc_off_drain(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_OFF, true);
+}
+
+static void __attribute__((optimize("-O3"))) rs232_tx_irq_handler_fc_software_drain(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_SOFTWARE, true);
+}
+
+static void __attribute__((optimize("-O3"))) rs232_tx_irq_handler_fc_hardware_drain(void) {
+	rs232_tx_irq_handler_flowcontrol(RS232_V2_FLOWCONTROL_HARDWARE, true);
+}
+
+// Selected in rs232_select_irq_handlers() for the configured flow control.
+static void (*rs232_rx_irq_handler_variant)(void) = rs232_rx_irq_handler_fc_off;
+static void (*rs232_tx_irq_handler_variant)(void) = rs232_tx_irq_handler_fc_off;
+
+static void rs232_select_irq_handlers(const bool drain) {
+	switch(rs232.flowcontrol) {
+		case RS232_V2_FLOWCONTROL_SOFTWARE:
+			rs232_rx_irq_handler_variant = rs232_rx_irq_handler_fc_software;
+			rs232_tx_irq_handler_variant = drain ? rs232_tx_irq_handler_fc_software_drain : rs232_tx_irq_handler_fc_software;
+			break;
+
+		case RS232_V2_FLOWCONTROL_HARDWARE:
+			rs232_rx_irq_handler_variant = rs232_rx_irq_handler_fc_hardware;
+			rs232_tx_irq_handler_variant = drain ? rs232_tx_irq_handler_fc_hardware_drain : rs232_tx_irq_handler_fc_hardware;
+			break;
+
+		default:
+			// The block RX overflow policy stops the peer with RTS if flow control is off.
+			if(rs232.rx_overflow_policy == RS232_V2_RX_OVERFLOW_POLICY_BLOCK) {
+				rs232_rx_irq_handler_variant = rs232_rx_irq_handler_fc_hardware;
 			}
-			else if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_HARDWARE) {
-				/*
-				 * XMC_GPIO_GetInput(RS232_CTS_PIN);
-				 * |
-				 * | ---> Return = 0 = RS232 logic 1.
-				 * | ---> Return = 1 = RS232 logic 0.
-				 */
-				if(XMC_GPIO_GetInput(RS232_CTS_PIN) == 1) {
-					XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
-					                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+			else {
+				rs232_rx_irq_handler_variant = rs232_rx_irq_handler_fc_off;
+			}
+			rs232_tx_irq_handler_variant = drain ? rs232_tx_irq_handler_fc_off_drain : rs232_tx_irq_handler_fc_off;
+			break;
+	}
+}
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_irq_handler() {
+#ifdef RS232_STATISTICS_IRQ_DURATION
+	const uint32_t start = SysTick->VAL;
+	rs232_rx_irq_handler_variant();
+	rs232_statistics_irq(&rs232.statistics.rx_irq, start);
+#else
+	rs232_rx_irq_handler_variant();
+#endif
+}
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_tx_irq_handler() {
+#ifdef RS232_STATISTICS_IRQ_DURATION
+	const uint32_t start = SysTick->VAL;
+	rs232_tx_irq_handler_variant();
+	rs232_statistics_irq(&rs232.statistics.tx_irq, start);
+#else
+	rs232_tx_irq_handler_variant();
+#endif
+}
+
+/*
+ * The alternate RX interrupt (parity error) and the UART protocol
+ * interrupt (framing error, break, receiver noise and data lost) share
+ * a service request. The received words are still given to the user,
+ * parity errors are counted per word while draining the RX FIFO.
+ *
+ * In ASC mode the RX FIFO word only carries the parity error in its RCI,
+ * framing error, break, noise and data lost are sticky flags in PSR. They
+ * are counted as events: once per interrupt in which the flag is set, no
+ * matter how many words were affected since the last interrupt.
+ */
+void __attribute__((optimize("-O3"))) rs232_rxa_irq_handler() {
+	rs232_rx_irq_handler();
+
+	const uint32_t status = XMC_UART_CH_GetStatusFlag(RS232_USIC);
+
+	// A break is also a format error in the stop bit, we only count it as break.
+	if(status & XMC_UART_CH_STATUS_FLAG_SYNCHRONIZATION_BREAK_DETECTED) {
+		rs232._error_count_break++;
+	}
+	else if(status & (XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_0 | XMC_UART_CH_STATUS_FLAG_FORMAT_ERROR_IN_STOP_BIT_1)) {
+		rs232._error_count_framing++;
+	}
+
+	if(status & XMC_UART_CH_STATUS_FLAG_RECEIVER_NOISE_DETECTED) {
+		rs232._error_count_noise++;
+	}
+
+	// The RX FIFO was full and a received word was overwritten.
+	if(status & XMC_UART_CH_STATUS_FLAG_DATA_LOST_INDICATION) {
+		rs232._error_count_fifo_overflow++;
+	}
+
+	XMC_UART_CH_ClearStatusFlag(RS232_USIC, RS232_ERROR_STATUS_FLAGS);
+}
+
+static void rs232_frame_push(const uint16_t frame_end) {
+	rs232.frame_end[(rs232.frame_end_first + rs232.frame_end_count) % FRAME_QUEUE_SIZE] = frame_end;
+	rs232.frame_end_count++;
+}
+
+/*
+ * Checks FRAME_GAP_CHECKS times per frame gap if new data arrived. The
+ * number of received bytes is tracked as ringbuffer end + RX FIFO level,
+ * so moving data from the FIFO to the ringbuffer is not seen as activity.
+ * The timer is started by the RX interrupt (see rs232_frame_gap_retrigger()).
+ */
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_frame_gap_irq_handler() {
+	const uint16_t size = *rs232_rb_rx_size;
+	const uint16_t end = *rs232_rb_rx_end;
+	const uint32_t level = XMC_USIC_CH_RXFIFO_GetLevel(RS232_USIC);
+	uint16_t position = end + level;
+
+	if(position >= size) {
+		position -= size;
+	}
+
+	if(position != rs232.frame_gap_position) {
+		rs232.frame_gap_position = position;
+		rs232.frame_gap_idle = 0;
+
+		return;
+	}
+
+	if(rs232.frame_gap_idle < FRAME_GAP_CHECKS) {
+		rs232.frame_gap_idle++;
+	}
+
+	if(rs232.frame_gap_idle < FRAME_GAP_CHECKS) {
+		return;
+	}
+
+	if(level > 0) {
+		// The end of the frame is still in the FIFO, let the RX interrupt move it first.
+		XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_RX);
+
+		return;
+	}
+
+	if(rs232.frame_end_count >= FRAME_QUEUE_SIZE) {
+		// Frame queue is full, try again with the next check.
+		return;
+	}
+
+	// Line was idle for the frame gap, the frame is complete.
+	if(end != rs232.frame_gap_last_end) {
+		rs232_frame_push(end);
+		rs232.frame_gap_last_end = end;
+	}
+
+	// The RX interrupt may have restarted the timer for the next frame in the meantime.
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	if(*rs232_rb_rx_end == end) {
+		XMC_CCU4_SLICE_StopTimer(RS232_FRAME_GAP_CCU4_SLICE);
+		XMC_CCU4_SLICE_ClearTimer(RS232_FRAME_GAP_CCU4_SLICE);
+		rs232.frame_gap_timer_running = false;
+	}
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+// Starts the frame gap timer if there is data after the last frame end. The RX interrupts have to be disabled.
+static void rs232_frame_gap_restart(void) {
+	if((rs232.frame_gap_length == 0) || (rs232.rb_rx.end == rs232.frame_gap_last_end)) {
+		return;
+	}
+
+	rs232_frame_gap_retrigger(rs232.rb_rx.end);
+}
+
+static void rs232_frame_gap_init(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+	XMC_CCU4_SLICE_StopTimer(RS232_FRAME_GAP_CCU4_SLICE);
+	XMC_CCU4_SLICE_ClearTimer(RS232_FRAME_GAP_CCU4_SLICE);
+	rs232.frame_gap_timer_running = false;
+
+	if(rs232.frame_gap_length == 0) {
+		return;
+	}
+
+	// Length of one character on the line in bits.
+	const uint32_t character_bits = 1 + rs232.wordlength + rs232.stopbits +
+	                                ((rs232.parity == RS232_V2_PARITY_NONE) ? 0 : 1);
+	const uint32_t clock_hz = XMC_SCU_CLOCK_GetPeripheralClockFrequency();
+
+	// frame_gap_length is in 1/10 character times.
+	uint64_t period = ((uint64_t)clock_hz * rs232.frame_gap_length * character_bits) /
+	                  (10ULL * rs232.baudrate * FRAME_GAP_CHECKS);
+	uint8_t prescaler = 0;
+
+	if(period < (clock_hz / FRAME_GAP_CHECK_MAX_HZ)) {
+		period = clock_hz / FRAME_GAP_CHECK_MAX_HZ;
+	}
+
+	while((period > 0xFFFF) && (prescaler < 15)) {
+		period >>= 1;
+		prescaler++;
+	}
+
+	if(period > 0xFFFF) {
+		period = 0xFFFF;
+	}
+
+	XMC_CCU4_SLICE_COMPARE_CONFIG_t timer_config = {
+		.timer_mode          = XMC_CCU4_SLICE_TIMER_COUNT_MODE_EA,
+		.monoshot            = XMC_CCU4_SLICE_TIMER_REPEAT_MODE_REPEAT,
+		.shadow_xfer_clear   = false,
+		.dither_timer_period = false,
+		.dither_duty_cycle   = false,
+		.prescaler_mode      = XMC_CCU4_SLICE_PRESCALER_MODE_NORMAL,
+		.mcm_enable          = false,
+		.prescaler_initval   = prescaler,
+		.float_limit         = 0,
+		.dither_limit        = 0,
+		.passive_level       = XMC_CCU4_SLICE_OUTPUT_PASSIVE_LEVEL_LOW,
+		.timer_concatenation = false
+	};
+
+	XMC_CCU4_Init(RS232_FRAME_GAP_CCU4, XMC_CCU4_SLICE_MCMS_ACTION_TRANSFER_PR_CR);
+	XMC_CCU4_StartPrescaler(RS232_FRAME_GAP_CCU4);
+	XMC_CCU4_SLICE_CompareInit(RS232_FRAME_GAP_CCU4_SLICE, &timer_config);
+	XMC_CCU4_SLICE_SetTimerPeriodMatch(RS232_FRAME_GAP_CCU4_SLICE, period - 1);
+	XMC_CCU4_EnableShadowTransfer(RS232_FRAME_GAP_CCU4, RS232_FRAME_GAP_SHADOW_TRANSFER);
+
+	XMC_CCU4_SLICE_EnableEvent(RS232_FRAME_GAP_CCU4_SLICE, XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH);
+	XMC_CCU4_SLICE_SetInterruptNodePointer(RS232_FRAME_GAP_CCU4_SLICE,
+	                                       XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH,
+	                                       RS232_FRAME_GAP_SERVICE_REQUEST);
+	XMC_CCU4_EnableClock(RS232_FRAME_GAP_CCU4, RS232_FRAME_GAP_CCU4_SLICE_NUMBER);
+
+	// Set priority and enable NVIC node for the frame gap timer interrupt.
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_FRAME_GAP, RS232_IRQ_FRAME_GAP_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_FRAME_GAP, RS232_IRQCTRL_FRAME_GAP);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+
+	// Data after the last frame end was kept, e.g. over a reconfiguration.
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	rs232_frame_gap_restart();
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+/*
+ * Frame detection. In delimiter mode the RX ringbuffer is scanned
+ * incrementally in rs232_tick(), in gap mode a timer interrupt closes a
+ * frame after the line was idle for the frame gap. Both queue the
+ * ringbuffer index after the end of every frame. The queue is only valid
+ * as long as the RX data is consumed frame by frame, other reads have to
+ * call rs232_frame_reset(), or rs232_frame_clear() if the RX interrupts are
+ * already disabled.
+ */
+static void rs232_frame_clear(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+
+	rs232.frame_delimiter_matched = 0;
+	rs232.frame_scan_position = rs232.rb_rx.start;
+	rs232.frame_gap_last_end = rs232.rb_rx.start;
+	rs232.frame_gap_idle = 0;
+	rs232.frame_end_first = 0;
+	rs232.frame_end_count = 0;
+	rs232.frame_available_cb_already_sent = false;
+	rs232.read_frame_stream_status.in_progress = false;
+	rs232.read_frame_stream_status.stream_sent = 0;
+	rs232.read_frame_stream_status.stream_chunk_offset = 0;
+	rs232.read_frame_stream_status.stream_total_length = 0;
+
+	if(rs232.frame_gap_length > 0) {
+		rs232_frame_gap_restart();
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+	}
+}
+
+void rs232_frame_reset(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	rs232_frame_clear();
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+/*
+ * CTS drives the transmit start of the USIC directly. On deassert the USIC
+ * finishes the character on the line and then holds the TX FIFO, so at most
+ * one character goes out after CTS drops. On assert the transmit start is
+ * enabled again and the TX FIFO is refilled right away, without waiting for
+ * rs232_tick.
+ *
+ * XMC_GPIO_GetInput(RS232_CTS_PIN);
+ * |
+ * | ---> Return = 0 = RS232 logic 1.
+ * | ---> Return = 1 = RS232 logic 0.
+ */
+static inline void __attribute__((always_inline)) rs232_cts_update(void) {
+	if(XMC_GPIO_GetInput(RS232_CTS_PIN) == 1) {
+		XMC_USIC_CH_SetStartTransmisionMode(RS232_USIC, XMC_USIC_CH_START_TRANSMISION_DISABLED);
+	} else {
+		XMC_USIC_CH_SetStartTransmisionMode(RS232_USIC, XMC_USIC_CH_START_TRANSMISION_ON_TDV);
+		XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+		XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+	}
+}
+
+// Same priority as the TX interrupt, so the two never preempt each other.
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_cts_irq_handler() {
+	XMC_ERU_ETL_ClearStatusFlag(RS232_CTS_ERU, RS232_CTS_ERU_ETL_CHANNEL);
+	rs232_cts_update();
+}
+
+static void rs232_cts_init(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_CTS);
+
+	if(rs232.flowcontrol != RS232_V2_FLOWCONTROL_HARDWARE) {
+		XMC_ERU_OGU_SetServiceRequestMode(RS232_CTS_ERU, RS232_CTS_ERU_OGU_CHANNEL, XMC_ERU_OGU_SERVICE_REQUEST_DISABLED);
+		XMC_USIC_CH_SetStartTransmisionMode(RS232_USIC, XMC_USIC_CH_START_TRANSMISION_ON_TDV);
+		return;
+	}
+
+	const XMC_ERU_ETL_CONFIG_t etl_config = {
+		.input_b = RS232_CTS_ERU_ETL_INPUT,
+		.source = XMC_ERU_ETL_SOURCE_B,
+		.edge_detection = XMC_ERU_ETL_EDGE_DETECTION_BOTH,
+		.status_flag_mode = XMC_ERU_ETL_STATUS_FLAG_MODE_SWCTRL,
+		.output_trigger_channel = RS232_CTS_ERU_OGU_CHANNEL,
+		.enable_output_trigger = true
+	};
+
+	XMC_ERU_ETL_Init(RS232_CTS_ERU, RS232_CTS_ERU_ETL_CHANNEL, &etl_config);
+	XMC_ERU_OGU_SetServiceRequestMode(RS232_CTS_ERU, RS232_CTS_ERU_OGU_CHANNEL, XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER);
+
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_CTS, RS232_IRQ_CTS_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_CTS, RS232_IRQCTRL_CTS);
+
+	// Take over the current CTS level, afterwards only edges are handled.
+	rs232_cts_update();
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_CTS);
+}
+
+/*
+ * Baudrate detection. Every edge on the RX pin is timestamped in CPU cycles
+ * by the highest priority interrupt. Within a character all edges are whole
+ * multiples of the bit time apart. The sync characters should mostly consist
+ * of single bits (e.g. 0x55 or "AT"), so that the lower quartile of the
+ * intervals is a first guess of the bit time. Unlike the shortest interval,
+ * the quartile is not thrown off by a single late timestamp.
+ */
+static const uint32_t rs232_baudrate_detection_standard[] = {
+	300, 600, 1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600,
+	76800, 115200, 230400, 250000, 460800, 500000, 921600, 1000000, 2000000
+};
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) rs232_rx_edge_irq_handler() {
+	const uint32_t now = rs232_get_time_cycles();
+	const uint8_t count = rs232.baudrate_detection_edge_count;
+
+	XMC_ERU_ETL_ClearStatusFlag(RS232_RX_ERU, RS232_RX_ERU_ETL_CHANNEL);
+
+	if(count < BAUDRATE_DETECTION_EDGES) {
+		rs232.baudrate_detection_edges[count] = now;
+		rs232.baudrate_detection_edge_count = count + 1;
+	}
+}
+
+static void rs232_baudrate_detection_stop(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX_EDGE);
+	XMC_ERU_OGU_SetServiceRequestMode(RS232_RX_ERU, RS232_RX_ERU_OGU_CHANNEL, XMC_ERU_OGU_SERVICE_REQUEST_DISABLED);
+	rs232.baudrate_detection_active = false;
+}
+
+/*
+ * The RX interrupts are turned off while the detection runs, they would
+ * delay the edge timestamps. rs232_tick still empties the RX FIFO, whatever
+ * arrives (sampled with the old baudrate) is kept in the RX buffer.
+ */
+void rs232_baudrate_detection_start(const uint16_t timeout) {
+	rs232_baudrate_detection_stop();
+
+	XMC_USIC_CH_RXFIFO_DisableEvent(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
+	);
+	XMC_USIC_CH_DisableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+	XMC_UART_CH_DisableEvent(RS232_USIC, RS232_ERROR_EVENTS);
+
+	rs232.baudrate_detection_edge_count = 0;
+	rs232.baudrate_detection_timeout = timeout;
+	rs232.baudrate_detection_start = system_timer_get_ms();
+	rs232.baudrate_detection_active = true;
+
+	const XMC_ERU_ETL_CONFIG_t etl_config = {
+		.input_a = RS232_RX_ERU_ETL_INPUT,
+		.source = XMC_ERU_ETL_SOURCE_A,
+		.edge_detection = XMC_ERU_ETL_EDGE_DETECTION_BOTH,
+		.status_flag_mode = XMC_ERU_ETL_STATUS_FLAG_MODE_SWCTRL,
+		.output_trigger_channel = RS232_RX_ERU_OGU_CHANNEL,
+		.enable_output_trigger = true
+	};
+
+	XMC_ERU_ETL_Init(RS232_RX_ERU, RS232_RX_ERU_ETL_CHANNEL, &etl_config);
+	XMC_ERU_OGU_SetServiceRequestMode(RS232_RX_ERU, RS232_RX_ERU_OGU_CHANNEL, XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER);
+
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_RX_EDGE, RS232_IRQ_RX_EDGE_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_RX_EDGE, RS232_IRQCTRL_RX_EDGE);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX_EDGE);
+}
+
+static inline uint32_t rs232_baudrate_detection_interval(const uint8_t i) {
+	return rs232.baudrate_detection_edges[i] - rs232.baudrate_detection_edges[i-1];
+}
+
+static uint32_t rs232_baudrate_detection_quartile(const uint8_t count) {
+	const uint8_t rank = (count - 1) / 4;
+
+	for(uint8_t i = 1; i < count; i++) {
+		const uint32_t interval = rs232_baudrate_detection_interval(i);
+		uint8_t smaller = 0;
+		uint8_t equal = 0;
+
+		for(uint8_t j = 1; j < count; j++) {
+			const uint32_t other = rs232_baudrate_detection_interval(j);
+			if(other < interval) {
+				smaller++;
+			} else if(other == interval) {
+				equal++;
+			}
+		}
+
+		if((smaller <= rank) && (rank < smaller + equal)) {
+			return interval;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Intervals that are within a quarter bit of a whole multiple (up to one
+ * character) of the bit time are averaged. The first pass starts from the
+ * quartile, the second one from the average of the first pass.
+ * Returns the measured baudrate, 0 if there is nothing to measure.
+ */
+static uint32_t rs232_baudrate_detection_evaluate(const uint8_t count) {
+	uint32_t bit = rs232_baudrate_detection_quartile(count);
+
+	for(uint8_t pass = 0; pass < 2; pass++) {
+		uint32_t sum = 0;
+		uint32_t bits = 0;
+
+		if(bit == 0) {
+			return 0;
+		}
+
+		for(uint8_t i = 1; i < count; i++) {
+			const uint32_t interval = rs232_baudrate_detection_interval(i);
+			const uint32_t n = (interval + bit/2) / bit;
+
+			if((n == 0) || (n > 10)) {
+				continue;
+			}
+
+			const uint32_t error = (interval > n*bit) ? (interval - n*bit) : (n*bit - interval);
+			if(error > bit/4) {
+				continue;
+			}
+
+			sum += interval;
+			bits += n;
+		}
+
+		if(bits == 0) {
+			return 0;
+		}
+
+		bit = (sum + bits/2) / bits;
+	}
+
+	const uint32_t cpu_hz = (SysTick->LOAD + 1) * 1000;
+
+	return (cpu_hz + bit/2) / bit;
+}
+
+// Closest standard rate if it is within the tolerance, otherwise the measured rate.
+static uint32_t rs232_baudrate_detection_select(const uint32_t measured) {
+	for(uint8_t i = 0; i < sizeof(rs232_baudrate_detection_standard)/sizeof(uint32_t); i++) {
+		const uint32_t standard = rs232_baudrate_detection_standard[i];
+		const uint32_t diff = (measured > standard) ? (measured - standard) : (standard - measured);
+
+		if((uint64_t)diff * 1000 <= (uint64_t)standard * BAUDRATE_DETECTION_TOLERANCE_PERMILLE) {
+			return standard;
+		}
+	}
+
+	if((measured < CONFIG_BAUDRATE_MIN) || (measured > CONFIG_BAUDRATE_MAX)) {
+		return 0;
+	}
+
+	return measured;
+}
+
+/*
+ * Turns the RX interrupts on again and applies the detected baudrate with
+ * rs232_reconfigure(), the RX and TX buffers are kept. The TX buffer is sent
+ * with the old baudrate first.
+ */
+static void rs232_baudrate_detection_finish(void) {
+	rs232_baudrate_detection_stop();
+
+	XMC_UART_CH_ClearStatusFlag(RS232_USIC, RS232_ERROR_STATUS_FLAGS);
+	XMC_USIC_CH_RXFIFO_EnableEvent(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
+	);
+	XMC_USIC_CH_EnableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+	XMC_UART_CH_EnableEvent(RS232_USIC, RS232_ERROR_EVENTS);
+
+	if(rs232.baudrate_detected != 0) {
+		RS232Configuration_t config = rs232.reconfigure;
+
+		config.baudrate = rs232.baudrate_detected;
+		rs232_reconfigure(&config, true);
+	}
+}
+
+static void rs232_baudrate_detection_tick(void) {
+	if(!rs232.baudrate_detection_active) {
+		return;
+	}
+
+	const uint8_t count = rs232.baudrate_detection_edge_count;
+	bool done = count >= BAUDRATE_DETECTION_EDGES;
+
+	if(!done && (count >= BAUDRATE_DETECTION_EDGES_MIN)) {
+		const uint32_t idle = rs232_get_time_cycles() - rs232.baudrate_detection_edges[count-1];
+		done = idle / BAUDRATE_DETECTION_IDLE_BITS > rs232_baudrate_detection_quartile(count);
+	}
+
+	if(!done) {
+		if((rs232.baudrate_detection_timeout != 0) &&
+		   system_timer_is_time_elapsed_ms(rs232.baudrate_detection_start, rs232.baudrate_detection_timeout)) {
+			rs232.baudrate_detected = 0;
+			rs232.baudrate_measured = 0;
+			rs232.do_baudrate_detected_callback = true;
+
+			// Back to the configured baudrate.
+			rs232_baudrate_detection_finish();
+		}
+
+		return;
+	}
+
+	rs232.baudrate_measured = rs232_baudrate_detection_evaluate(count);
+	rs232.baudrate_detected = rs232_baudrate_detection_select(rs232.baudrate_measured);
+	rs232.do_baudrate_detected_callback = true;
+
+	rs232_baudrate_detection_finish();
+}
+
+/*
+ * The USIC baudrate is
+ *   normal divider:     f_periph / (1024 - step) / (pdiv + 1) / oversampling
+ *   fractional divider: f_periph * step / 1024 / (pdiv + 1) / oversampling
+ * The fractional divider moves every sample clock by up to one f_periph
+ * period. For the comparison of candidates that jitter (relative to a bit)
+ * is added to the baudrate error.
+ */
+static uint32_t rs232_baudrate_divider_score(const RS232BaudrateDivider_t *divider, const uint32_t f_periph) {
+	const uint32_t error = (divider->error_ppm < 0) ? -divider->error_ppm : divider->error_ppm;
+
+	if(divider->fractional) {
+		return error + (uint64_t)divider->baudrate * 1000000 / f_periph;
+	}
+
+	return error;
+}
+
+static void rs232_baudrate_divider_check(const uint32_t baudrate, const uint32_t f_periph, RS232BaudrateDivider_t *candidate, RS232BaudrateDivider_t *best) {
+	uint64_t numerator = f_periph;
+	uint64_t denominator = (uint64_t)(candidate->pdiv + 1) * candidate->oversampling;
+
+	if(candidate->fractional) {
+		numerator *= candidate->step;
+		denominator *= 1024;
+	} else {
+		denominator *= 1024 - candidate->step;
+	}
+
+	const uint64_t achieved_e6 = numerator * 1000000 / denominator;
+
+	candidate->baudrate = (achieved_e6 + 500000) / 1000000;
+	candidate->error_ppm = ((int64_t)achieved_e6 - (int64_t)baudrate * 1000000) / (int64_t)baudrate;
+
+	if(best->oversampling == 0) {
+		*best = *candidate;
+		return;
+	}
+
+	const uint32_t candidate_score = rs232_baudrate_divider_score(candidate, f_periph);
+	const uint32_t best_score = rs232_baudrate_divider_score(best, f_periph);
+
+	if((best_score > RS232_BAUDRATE_ERROR_TARGET_PPM) && (candidate_score < best_score)) {
+		*best = *candidate;
+	}
+}
+
+/*
+ * Candidates are checked in order of preference: high oversampling first and
+ * the normal before the fractional divider. A later candidate only wins if
+ * the best one so far misses the error target and its score is lower.
+ */
+static void rs232_baudrate_divider_search(const uint32_t baudrate, const uint32_t f_periph, RS232BaudrateDivider_t *best) {
+	RS232BaudrateDivider_t candidate;
+
+	best->oversampling = 0;
+
+	for(uint8_t oversampling = RS232_OVERSAMPLING_MAX; oversampling >= RS232_OVERSAMPLING_MIN; oversampling--) {
+		const uint32_t sample_rate = baudrate * oversampling;
+		candidate.oversampling = oversampling;
+
+		// Normal divider: For every pdiv the closest (1024 - step) is taken. Of those the
+		// product P = (1024 - step) * (pdiv + 1) with the smallest |f_periph / P - sample_rate|
+		// is used, i.e. the smallest |f_periph - P * sample_rate| / P (compared cross-multiplied).
+		const uint32_t product = (f_periph + sample_rate/2) / sample_rate;
+		uint32_t normal_pdiv1 = 0;
+		uint32_t normal_divisor = 0;
+		uint32_t normal_diff = 0;
+		for(uint32_t pdiv1 = (product > 1024) ? (product + 1023) / 1024 : 1; (pdiv1 <= 1024) && (pdiv1 <= product); pdiv1++) {
+			const uint32_t pdiv_rate = sample_rate * pdiv1;
+			uint32_t divisor = (f_periph + pdiv_rate/2) / pdiv_rate;
+			if(divisor == 0) {
+				divisor = 1;
+			} else if(divisor > 1024) {
+				divisor = 1024;
+			}
+
+			const uint32_t achieved = pdiv_rate * divisor;
+			const uint32_t diff = (achieved > f_periph) ? achieved - f_periph : f_periph - achieved;
+			if((normal_pdiv1 == 0) ||
+			   ((uint64_t)diff * normal_pdiv1 * normal_divisor < (uint64_t)normal_diff * pdiv1 * divisor)) {
+				normal_pdiv1 = pdiv1;
+				normal_divisor = divisor;
+				normal_diff = diff;
+				if(diff == 0) {
+					break;
+				}
+			}
+		}
+
+		if(normal_pdiv1 != 0) {
+			candidate.fractional = false;
+			candidate.pdiv = normal_pdiv1 - 1;
+			candidate.step = 1024 - normal_divisor;
+			rs232_baudrate_divider_check(baudrate, f_periph, &candidate, best);
+		}
+
+		// Fractional divider: the resolution is best for the largest step, so only the largest pdiv values are tried.
+		uint32_t pdiv1_max = ((uint64_t)f_periph * 1023) / ((uint64_t)sample_rate * 1024);
+		if(pdiv1_max > 1024) {
+			pdiv1_max = 1024;
+		}
+
+		for(uint32_t pdiv1 = pdiv1_max; (pdiv1 >= 1) && (pdiv1 + 2 > pdiv1_max); pdiv1--) {
+			const uint32_t step = ((uint64_t)sample_rate * pdiv1 * 1024 + f_periph/2) / f_periph;
+			if((step == 0) || (step > 1023)) {
+				continue;
+			}
+
+			candidate.fractional = true;
+			candidate.pdiv = pdiv1 - 1;
+			candidate.step = step;
+			rs232_baudrate_divider_check(baudrate, f_periph, &candidate, best);
+		}
+
+		if(rs232_baudrate_divider_score(best, f_periph) <= RS232_BAUDRATE_ERROR_TARGET_PPM) {
+			break;
+		}
+	}
+}
+
+/*
+ * Overwrites the divider settings of XMC_UART_CH_Init. The sample point is
+ * in the middle of the bit, with majority decision the three samples are
+ * centered around it.
+ */
+static void rs232_baudrate_divider_apply(const RS232BaudrateDivider_t *divider) {
+	const uint8_t oversampling = divider->oversampling;
+	const bool majority = oversampling >= RS232_OVERSAMPLING_MAJORITY_MIN;
+	const uint32_t sample_point = majority ? (oversampling >> 1) + 1 : (oversampling >> 1);
+
+	XMC_USIC_CH_SetFractionalDivider(
+		RS232_USIC,
+		divider->fractional ? XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_FRACTIONAL : XMC_USIC_CH_BRG_CLOCK_DIVIDER_MODE_NORMAL,
+		divider->step
+	);
+
+	RS232_USIC->BRG = (RS232_USIC->BRG & ~(USIC_CH_BRG_PDIV_Msk | USIC_CH_BRG_DCTQ_Msk | USIC_CH_BRG_PCTQ_Msk)) |
+	                  ((uint32_t)divider->pdiv << USIC_CH_BRG_PDIV_Pos) |
+	                  ((uint32_t)(oversampling - 1) << USIC_CH_BRG_DCTQ_Pos);
+
+	RS232_USIC->PCR_ASCMode = (RS232_USIC->PCR_ASCMode & ~(USIC_CH_PCR_ASCMode_SMD_Msk | USIC_CH_PCR_ASCMode_SP_Msk)) |
+	                          ((majority ? 1 : 0) << USIC_CH_PCR_ASCMode_SMD_Pos) |
+	                          (sample_point << USIC_CH_PCR_ASCMode_SP_Pos);
+}
+
+static void rs232_init_hardware() {
+	logd("[+] RS232-V2: rs232_init_hardware()\n\r");
+
+	// RTS/CTS pin configuration.
+	XMC_GPIO_CONFIG_t rts_pin_config = {
+		.mode = XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
+		.output_level = XMC_GPIO_OUTPUT_LEVEL_LOW
+	};
+
+	XMC_GPIO_CONFIG_t cts_pin_config = {
+		.mode = XMC_GPIO_MODE_INPUT_PULL_DOWN,
+	};
+
+	// RX pin configuration.
+	const XMC_GPIO_CONFIG_t rx_pin_config = {
+		.mode = XMC_GPIO_MODE_INPUT_PULL_UP,
+		.input_hysteresis = XMC_GPIO_INPUT_HYSTERESIS_STANDARD
+	};
+
+	// Configure TX pin high during configuration,
+	// otherwise there can be glitches on TX line if
+	// configuration changes.
+	XMC_GPIO_CONFIG_t tx_pin_config_high = {
+		.mode = XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
+		.output_level = XMC_GPIO_OUTPUT_LEVEL_HIGH
+	};
+
+	// Configure  pins.
+	XMC_GPIO_Init(RS232_TX_PIN, &tx_pin_config_high);
+	XMC_GPIO_Init(RS232_RTS_PIN, &rts_pin_config);
+	XMC_GPIO_Init(RS232_CTS_PIN, &cts_pin_config);
+	XMC_GPIO_Init(RS232_RX_PIN, &rx_pin_config);
+
+	// Initialize USIC channel in UART mode.
+
+	// USIC channel configuration.
+	XMC_UART_CH_CONFIG_t cfg_uart_ch;
+
+	cfg_uart_ch.baudrate = rs232.baudrate;
+	cfg_uart_ch.stop_bits = rs232.stopbits;
+	cfg_uart_ch.data_bits = rs232.wordlength;
+	rs232_baudrate_divider_search(rs232.baudrate, XMC_SCU_CLOCK_GetPeripheralClockFrequency(), &rs232.divider);
+	cfg_uart_ch.oversampling = rs232.divider.oversampling;
+	cfg_uart_ch.frame_length = rs232.wordlength;
+
+	switch(rs232.parity) {
+		case RS232_V2_PARITY_NONE:
+			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_NONE;
+			break;
+
+		case RS232_V2_PARITY_ODD:
+			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_ODD;
+			break;
+
+		case RS232_V2_PARITY_EVEN:
+			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_EVEN;
+			break;
+	}
+
+	XMC_UART_CH_Init(RS232_USIC, &cfg_uart_ch);
+	rs232_baudrate_divider_apply(&rs232.divider);
+
+	// Set input source path.
+	XMC_UART_CH_SetInputSource(RS232_USIC, RS232_RX_INPUT, RS232_RX_SOURCE);
+
+	// Configure TX FIFO.
+	XMC_USIC_CH_TXFIFO_Configure(RS232_USIC, 32, XMC_USIC_CH_FIFO_SIZE_32WORDS, 16);
+
+	// Configure RX FIFO.
+	XMC_USIC_CH_RXFIFO_Configure(RS232_USIC, 0, XMC_USIC_CH_FIFO_SIZE_32WORDS, 16);
+
+	// UART protocol events.
+
+	// Set service request for RX FIFO receive interrupt.
+	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD,
+		RS232_SERVICE_REQUEST_RX
+	);
+
+	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE,
+		RS232_SERVICE_REQUEST_RX
+	);
+
+	// Set service request for TX FIFO transmit interrupt.
+	XMC_USIC_CH_TXFIFO_SetInterruptNodePointer(
+		RS232_USIC,
+		XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_STANDARD,
+		RS232_SERVICE_REQUEST_TX
+	);
+
+	XMC_USIC_CH_SetInterruptNodePointer(
+		RS232_USIC,
+		XMC_USIC_CH_INTERRUPT_NODE_POINTER_ALTERNATE_RECEIVE,
+		RS232_SERVICE_REQUEST_RXA
+	);
+
+	// UART protocol errors and RX FIFO data lost share the alternate RX interrupt.
+	XMC_USIC_CH_SetInterruptNodePointer(
+		RS232_USIC,
+		XMC_USIC_CH_INTERRUPT_NODE_POINTER_PROTOCOL,
+		RS232_SERVICE_REQUEST_RXA
+	);
+
+	// Set priority and enable NVIC node for TX interrupt.
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_TX, RS232_IRQ_TX_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_TX, RS232_IRQCTRL_TX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	// Set priority and enable NVIC node for RX interrupt.
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_RX, RS232_IRQ_RX_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_RX, RS232_IRQCTRL_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+
+	// Set priority and enable NVIC node for RXA interrupt.
+	NVIC_SetPriority((IRQn_Type)RS232_IRQ_RXA, RS232_IRQ_RXA_PRIORITY);
+	XMC_SCU_SetInterruptControl(RS232_IRQ_RXA, RS232_IRQCTRL_RXA);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	// Restart UART: Stop.
+	while(XMC_UART_CH_Stop(RS232_USIC) != XMC_UART_CH_STATUS_OK) {
+		;
+	}
+
+	// Restart UART: Start.
+	XMC_UART_CH_Start(RS232_USIC);
+
+
+	// TX pin configuration.
+	const XMC_GPIO_CONFIG_t tx_pin_config = {
+		.mode = RS232_TX_PIN_AF,
+		.output_level = XMC_GPIO_OUTPUT_LEVEL_HIGH
+	};
+	XMC_GPIO_Init(RS232_TX_PIN, &tx_pin_config);
+
+	XMC_USIC_CH_RXFIFO_EnableEvent(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
+	);
+
+	XMC_USIC_CH_EnableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+
+	XMC_UART_CH_ClearStatusFlag(RS232_USIC, RS232_ERROR_STATUS_FLAGS);
+	XMC_UART_CH_EnableEvent(RS232_USIC, RS232_ERROR_EVENTS);
+
+	rs232_cts_init();
+}
+
+static void rs232_init_buffer(void) {
+	logd("[+] RS232-V2: rs232_init_buffer()\n\r");
+
+	// Initialize RS232 buffer.
+	memset(rs232.buffer, 0, RS232_BUFFER_SIZE);
+
+	// Ringbuffer initialization.
+	ringbuffer_init(&rs232.rb_rx, rs232.buffer_size_rx, &rs232.buffer[0]);
+	ringbuffer_init(&rs232.rb_tx,
+	                rs232.buffer_size_tx,
+	                &rs232.buffer[rs232.buffer_size_rx]);
+}
+
+// The requested configuration is set back to the active one.
+static void rs232_reconfigure_reset(void) {
+	rs232.reconfigure.baudrate = rs232.baudrate;
+	rs232.reconfigure.parity = rs232.parity;
+	rs232.reconfigure.stopbits = rs232.stopbits;
+	rs232.reconfigure.wordlength = rs232.wordlength;
+	rs232.reconfigure.flowcontrol = rs232.flowcontrol;
+	rs232.reconfigure.buffer_size_rx = rs232.buffer_size_rx;
+	rs232.reconfigure.buffer_size_tx = rs232.buffer_size_tx;
+	rs232.reconfigure_pending = false;
+}
+
+void rs232_apply_configuration() {
+	logd("[+] RS232-V2: rs232_apply_configuration()\n\r");
+
+	// Turning off all events.
+	XMC_USIC_CH_RXFIFO_DisableEvent(
+		RS232_USIC,
+		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
+	);
+	XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	XMC_USIC_CH_DisableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+	XMC_UART_CH_DisableEvent(RS232_USIC, RS232_ERROR_EVENTS);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_CTS);
+	rs232_baudrate_detection_stop();
+	rs232_select_irq_handlers(false);
+
+	// Now we can configure the buffer and the hardware.
+	rs232_init_buffer();
+	rs232_fc_set_watermarks(rs232.fc_rx_high_watermark, rs232.fc_rx_low_watermark);
+	rs232.fc_hw_rx_wait = false;
+	rs232_init_hardware();
+	rs232_rx_timestamp_reset();
+	rs232_frame_reset();
+	rs232.poll_active = POLL_NONE;
+	rs232.transaction_state = TRANSACTION_STATE_IDLE;
+	rs232_rx_drop_oldest_update();
+	rs232_frame_gap_init();
+
+	rs232_reconfigure_reset();
+}
+
+bool rs232_configuration_is_valid(const RS232Configuration_t *config) {
+	return (config->baudrate >= CONFIG_BAUDRATE_MIN) && (config->baudrate <= CONFIG_BAUDRATE_MAX) &&
+	       (config->parity >= 0) && (config->parity <= CONFIG_PARITY_MAX) &&
+	       (config->stopbits >= CONFIG_STOPBITS_MIN) && (config->stopbits <= CONFIG_STOPBITS_MAX) &&
+	       (config->wordlength >= CONFIG_WORDLENGTH_MIN) && (config->wordlength <= CONFIG_WORDLENGTH_MAX) &&
+	       (config->flowcontrol >= 0) && (config->flowcontrol <= CONFIG_FLOWCONTROL_MAX) &&
+	       (config->buffer_size_rx >= 1024) && (config->buffer_size_tx >= 1024) &&
+	       ((config->buffer_size_rx + config->buffer_size_tx) == RS232_BUFFER_SIZE) &&
+	       (!rs232.buffer_pool_enabled || ((config->buffer_size_rx >= rs232.buffer_pool_minimum_rx) &&
+	                                       (config->buffer_size_tx >= rs232.buffer_pool_minimum_tx)));
+}
+
+/*
+ * The RX/TX split is moved without copying buffered data: only the ringbuffer
+ * bounds change, so RX and TX are masked for a few instructions only. This
+ * is possible while the RX data lies below the new border and neither
+ * ringbuffer wraps (the border moves into one of them), otherwise
+ * rs232_reconfigure_tick() tries again once the host has read the RX data
+ * or the TX data was sent past the wrap point. An empty ringbuffer always
+ * fits.
+ */
+static bool rs232_buffer_split_fits(const uint16_t buffer_size_rx) {
+	const Ringbuffer *const rx = &rs232.rb_rx;
+	const Ringbuffer *const tx = &rs232.rb_tx;
+
+	if(buffer_size_rx < rx->size) {
+		// The TX part grows at its front.
+		return ((rx->start == rx->end) || ((rx->start < rx->end) && (rx->end < buffer_size_rx))) &&
+		       (tx->start <= tx->end);
+	}
+
+	// The TX part gives its front to the RX part.
+	return (rx->start <= rx->end) &&
+	       ((tx->start == tx->end) || ((tx->start < tx->end) && (tx->start >= buffer_size_rx - rx->size)));
+}
+
+// The RX/TX interrupts have to be disabled and rs232_buffer_split_fits() has to be true.
+static void rs232_buffer_split_move(const uint16_t buffer_size_rx) {
+	Ringbuffer *const rx = &rs232.rb_rx;
+	Ringbuffer *const tx = &rs232.rb_tx;
+
+	if(buffer_size_rx < rx->size) {
+		const uint16_t count = rx->size - buffer_size_rx;
+
+		if(rx->end >= buffer_size_rx) {
+			// Empty, but behind the new border.
+			rx->start = 0;
+			rx->end = 0;
+			rs232.poll_rx_position = 0;
+			rs232.transaction_rx_position = 0;
+			rs232_frame_clear();
+		}
+
+		tx->buffer -= count;
+		tx->start += count;
+		tx->end += count;
+	} else {
+		const uint16_t count = buffer_size_rx - rx->size;
+
+		if(tx->start == tx->end) {
+			tx->start = count;
+			tx->end = count;
+		}
+
+		tx->buffer += count;
+		tx->start -= count;
+		tx->end -= count;
+	}
+
+	rs232.buffer_size_rx = buffer_size_rx;
+	rs232.buffer_size_tx = RS232_BUFFER_SIZE - buffer_size_rx;
+	rx->size = rs232.buffer_size_rx;
+	tx->size = rs232.buffer_size_tx;
+}
+
+/*
+ * Applies rs232.reconfigure without throwing away buffered data. The USIC
+ * is only set up again if a line parameter changed, in that case the TX FIFO
+ * and shift register are empty (see rs232_reconfigure_tick()). The RX FIFO
+ * is emptied into the ringbuffer first, only bytes that arrive while the
+ * USIC is set up again are lost. A buffer split that can't be moved yet
+ * (see rs232_buffer_split_fits()) stays pending, everything else is applied.
+ */
+static void rs232_reconfigure_apply(void) {
+	const RS232Configuration_t *const config = &rs232.reconfigure;
+	const bool line_changed = (config->baudrate != rs232.baudrate) ||
+	                          (config->parity != rs232.parity) ||
+	                          (config->stopbits != rs232.stopbits) ||
+	                          (config->wordlength != rs232.wordlength);
+	const bool flowcontrol_changed = config->flowcontrol != rs232.flowcontrol;
+	const bool was_pending = rs232.reconfigure_pending;
+
+	// Take over what is still in the RX FIFO.
+	rs232_rx_irq_handler_variant();
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	if((config->buffer_size_rx != rs232.buffer_size_rx) && rs232_buffer_split_fits(config->buffer_size_rx)) {
+		rs232_buffer_split_move(config->buffer_size_rx);
+	}
+
+	rs232.baudrate = config->baudrate;
+	rs232.parity = config->parity;
+	rs232.stopbits = config->stopbits;
+	rs232.wordlength = config->wordlength;
+	rs232.flowcontrol = config->flowcontrol;
+	rs232.reconfigure_pending = config->buffer_size_rx != rs232.buffer_size_rx;
+
+	if(rs232.reconfigure_pending) {
+		// Only the buffer split waits, everything in the TX buffer is sent.
+		rs232.reconfigure_tx_end = rs232.rb_tx.end;
+
+		if(!was_pending || line_changed) {
+			rs232.reconfigure_start = system_timer_get_ms();
+		}
+	}
+
+	rs232_select_irq_handlers(rs232.reconfigure_pending);
+	rs232_fc_set_watermarks(rs232.fc_rx_high_watermark, rs232.fc_rx_low_watermark);
+
+	if(line_changed || flowcontrol_changed) {
+		rs232.fc_sw_tx_control = 0;
+		rs232.fc_sw_state_rx = FC_SW_STATE_RX_OK;
+		rs232.fc_sw_state_tx = FC_SW_STATE_TX_OK;
+		rs232.fc_hw_rx_wait = false;
+		XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
+	}
+
+	if(line_changed) {
+		XMC_USIC_CH_RXFIFO_DisableEvent(
+			RS232_USIC,
+			XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
+		);
+		XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+		XMC_USIC_CH_DisableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+		XMC_UART_CH_DisableEvent(RS232_USIC, RS232_ERROR_EVENTS);
+		rs232_baudrate_detection_stop();
+
+		// Enables the RX/TX interrupts again.
+		rs232_init_hardware();
+		rs232_frame_gap_init();
+
+		if(modbus.enabled) {
+			// Update t3.5 for the new line parameters.
+			modbus_set_enabled(true);
+		}
+	} else {
+		if(flowcontrol_changed) {
+			rs232_cts_init();
+		}
+
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+	}
+
+	// Send what was kept in the TX buffer.
+	XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+}
+
+static bool rs232_reconfigure_line_changed(void) {
+	return (rs232.reconfigure.baudrate != rs232.baudrate) ||
+	       (rs232.reconfigure.parity != rs232.parity) ||
+	       (rs232.reconfigure.stopbits != rs232.stopbits) ||
+	       (rs232.reconfigure.wordlength != rs232.wordlength);
+}
+
+static bool rs232_reconfigure_is_active(void) {
+	return !rs232_reconfigure_line_changed() &&
+	       (rs232.reconfigure.flowcontrol == rs232.flowcontrol) &&
+	       (rs232.reconfigure.buffer_size_rx == rs232.buffer_size_rx);
+}
+
+// Gives up the pending change, TX continues with the active configuration.
+static void rs232_reconfigure_cancel(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+	rs232_reconfigure_reset();
+	rs232_select_irq_handlers(false);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+}
+
+/*
+ * Non-destructive alternative to rs232_apply_configuration(). Flow control
+ * changes are applied right away, buffer split changes as soon as the
+ * buffered data allows it (see rs232_buffer_split_fits()): a smaller
+ * receive buffer waits until the host has read the RX data behind the new
+ * border, a smaller send buffer until the TX data in front of it is sent.
+ * Nothing buffered is dropped. A change of the line parameters waits until
+ * the transmitter is idle:
+ * with drain_tx the TX buffer content at the time of the call is sent with
+ * the old parameters first, otherwise only the TX FIFO is finished and the
+ * rest of the TX buffer is sent with the new parameters. The RX buffer is
+ * kept in both cases.
+ *
+ * Calls while a change is pending only update the configuration, a call
+ * with the active configuration cancels the pending change. A change that
+ * is still pending after RS232_RECONFIGURE_TIMEOUT ms (e.g. because the peer
+ * holds CTS or sent XOFF) is given up as well.
+ */
+void rs232_reconfigure(const RS232Configuration_t *config, const bool drain_tx) {
+	rs232.reconfigure = *config;
+
+	if(rs232.reconfigure_pending) {
+		if(rs232_reconfigure_is_active()) {
+			rs232_reconfigure_cancel();
+		}
+
+		return;
+	}
+
+	const bool line_changed = rs232_reconfigure_line_changed();
+
+	if(!line_changed) {
+		rs232_reconfigure_apply();
+		return;
+	}
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+	rs232.reconfigure_tx_end = (drain_tx || !line_changed) ? rs232.rb_tx.end : rs232.rb_tx.start;
+	rs232.reconfigure_start = system_timer_get_ms();
+	rs232.reconfigure_pending = true;
+	rs232_select_irq_handlers(true);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+}
+
+static void rs232_reconfigure_tick(void) {
+	if(!rs232.reconfigure_pending) {
+		return;
+	}
+
+	if(system_timer_is_time_elapsed_ms(rs232.reconfigure_start, RS232_RECONFIGURE_TIMEOUT)) {
+		rs232_reconfigure_cancel();
+		return;
+	}
+
+	if(!rs232_reconfigure_line_changed()) {
+		// Only the buffer split waits, everything in the TX buffer is sent.
+		if(rs232.reconfigure_tx_end != rs232.rb_tx.end) {
+			rs232.reconfigure_tx_end = rs232.rb_tx.end;
+			XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+			XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
+		}
+
+		if(rs232_buffer_split_fits(rs232.reconfigure.buffer_size_rx)) {
+			rs232_reconfigure_apply();
+		}
+
+		return;
+	}
+
+	if((rs232.rb_tx.start != rs232.reconfigure_tx_end) ||
+	   !XMC_USIC_CH_TXFIFO_IsEmpty(RS232_USIC) ||
+	   !(XMC_UART_CH_GetStatusFlag(RS232_USIC) & XMC_UART_CH_STATUS_FLAG_TRANSMISSION_IDLE)) {
+		return;
+	}
+
+	rs232_reconfigure_apply();
+}
+
+/*
+ * Elastic buffer pool. The RX part [0, rb_rx.size) and the TX part behind it
+ * share rs232.buffer, the border between them moves at runtime. A direction
+ * that is more than RS232_BUFFER_POOL_BORROW_PERCENT full takes everything
+ * the other direction can give without going below its minimum. The border
+ * is only moved where no buffered data has to be touched. A wrapped RX or TX
+ * part can't grow, the next tick tries again once the data is read past
+ * the wrap point.
+ */
+// Gives up to max bytes from the front of the TX part, returns how many.
+static uint16_t rs232_buffer_pool_shrink_tx(uint16_t max) {
+	Ringbuffer *const rb = &rs232.rb_tx;
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	if(rb->start == rb->end) {
+		rb->start = 0;
+		rb->end = 0;
+	} else if(rb->end < rb->start) {
+		max = 0;
+	} else {
+		if(max > rb->start) {
+			max = rb->start;
+		}
+
+		rb->start -= max;
+		rb->end -= max;
+	}
+
+	rb->buffer += max;
+	rb->size -= max;
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+
+	return max;
+}
+
+static void rs232_buffer_pool_grow_tx(const uint16_t count) {
+	Ringbuffer *const rb = &rs232.rb_tx;
+
+	// The TX part is never wrapped here, rs232_buffer_pool_tick() checked it.
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
+	rb->buffer -= count;
+	rb->size += count;
+	rb->start += count;
+	rb->end += count;
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+}
+
+// Gives up to max bytes from the end of the RX part, returns how many.
+static uint16_t rs232_buffer_pool_shrink_rx(uint16_t max) {
+	Ringbuffer *const rb = &rs232.rb_rx;
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	if(rb->start == rb->end) {
+		if(rb->end >= rb->size - max) {
+			rb->start = 0;
+			rb->end = 0;
+			rs232.poll_rx_position = 0;
+			rs232.transaction_rx_position = 0;
+			rs232_frame_clear();
+		}
+	} else if(rb->end < rb->start) {
+		max = 0;
+	} else if(rb->end >= rb->size - max) {
+		max = rb->size - 1 - rb->end;
+	}
+
+	rb->size -= max;
+	rs232_fc_set_watermarks(rs232.fc_rx_high_watermark, rs232.fc_rx_low_watermark);
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	return max;
+}
+
+// Returns false if the RX data wrapped in the meantime, the RX part is not changed then.
+static bool rs232_buffer_pool_grow_rx(const uint16_t count) {
+	Ringbuffer *const rb = &rs232.rb_rx;
+	bool grown = false;
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	if(rb->start <= rb->end) {
+		rb->size += count;
+		rs232_fc_set_watermarks(rs232.fc_rx_high_watermark, rs232.fc_rx_low_watermark);
+		grown = true;
+	}
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	return grown;
+}
+
+static void rs232_buffer_pool_tick(void) {
+	if(!rs232.buffer_pool_enabled || rs232.reconfigure_pending) {
+		return;
+	}
+
+	const uint16_t rx_size = rs232.rb_rx.size;
+	const uint16_t tx_size = rs232.rb_tx.size;
+	const bool rx_borrow = (uint32_t)ringbuffer_get_used(&rs232.rb_rx) * 100 > (uint32_t)rx_size * RS232_BUFFER_POOL_BORROW_PERCENT;
+	const bool tx_borrow = (uint32_t)ringbuffer_get_used(&rs232.rb_tx) * 100 > (uint32_t)tx_size * RS232_BUFFER_POOL_BORROW_PERCENT;
+
+	if(rx_borrow && !tx_borrow && (tx_size > rs232.buffer_pool_minimum_tx) &&
+	   (rs232.rb_rx.start <= rs232.rb_rx.end)) {
+		const uint16_t count = rs232_buffer_pool_shrink_tx(tx_size - rs232.buffer_pool_minimum_tx);
+
+		if((count > 0) && !rs232_buffer_pool_grow_rx(count)) {
+			// RX wrapped since the check above, the TX part takes the bytes back.
+			rs232_buffer_pool_grow_tx(count);
+		}
+	} else if(tx_borrow && !rx_borrow && (rx_size > rs232.buffer_pool_minimum_rx) &&
+	          (rs232.rb_tx.start <= rs232.rb_tx.end)) {
+		const uint16_t count = rs232_buffer_pool_shrink_rx(rx_size - rs232.buffer_pool_minimum_rx);
+
+		if(count > 0) {
+			rs232_buffer_pool_grow_tx(count);
+		}
+	} else {
+		return;
+	}
+
+	rs232.buffer_size_rx = rs232.rb_rx.size;
+	rs232.buffer_size_tx = rs232.rb_tx.size;
+	rs232.reconfigure.buffer_size_rx = rs232.rb_rx.size;
+	rs232.reconfigure.buffer_size_tx = rs232.rb_tx.size;
+}
+
+/*
+ * The current split is moved into the new minimums first if necessary,
+ * the buffered data is kept.
+ */
+void rs232_buffer_pool_set(const bool enabled, const uint16_t minimum_rx, const uint16_t minimum_tx) {
+	RS232Configuration_t config = rs232.reconfigure;
+
+	rs232.buffer_pool_enabled = false;
+	rs232.buffer_pool_minimum_rx = minimum_rx;
+	rs232.buffer_pool_minimum_tx = minimum_tx;
+
+	if(enabled) {
+		if(config.buffer_size_rx < minimum_rx) {
+			config.buffer_size_rx = minimum_rx;
+		} else if(config.buffer_size_tx < minimum_tx) {
+			config.buffer_size_rx = RS232_BUFFER_SIZE - minimum_tx;
+		}
+		config.buffer_size_tx = RS232_BUFFER_SIZE - config.buffer_size_rx;
+
+		rs232_reconfigure(&config, true);
+	}
+
+	rs232.buffer_pool_enabled = enabled;
+}
+
+/*
+ * RX overflow policy. Drop-newest and block are handled by the RX interrupt:
+ * bytes that don't fit are thrown away, with block the peer is stopped by
+ * flow control before (RTS if flow control is off).
+ *
+ * Drop-oldest moves the ringbuffer start in the RX interrupt as long as
+ * nothing in the main loop holds a position in the RX ringbuffer (see
+ * rs232_rx_drop_oldest_update()). Otherwise the oldest bytes are dropped here,
+ * in the same context as the readers, so that RS232_RX_DROP_OLDEST_FREE bytes
+ * stay free for the RX interrupt. The bytes that a read stream in progress
+ * (read_low_level, read callback or frame) already announced with its total
+ * length are kept, they are moved up over the dropped bytes. With frame
+ * detection whole frames are dropped if possible, in frame readable mode
+ * whole frames of the configured size.
+ */
+static uint16_t rs232_rx_reserved(void) {
+	uint16_t reserved = 0;
+
+	if(rs232.read_stream_status.in_progress) {
+		reserved = rs232.read_stream_status.stream_total_length - rs232.read_stream_status.stream_sent;
+	}
+
+	if(rs232.read_frame_stream_status.in_progress) {
+		const uint16_t frame_reserved = rs232.read_frame_stream_status.stream_total_length - rs232.read_frame_stream_status.stream_sent;
+
+		if(frame_reserved > reserved) {
+			reserved = frame_reserved;
+		}
+	}
+
+	return reserved;
+}
+
+static uint16_t rs232_rx_offset(const uint16_t position) {
+	return (position + rs232.rb_rx.size - rs232.rb_rx.start) % rs232.rb_rx.size;
+}
+
+// Position in the RX ringbuffer after dropping drop bytes behind the first reserved bytes.
+static uint16_t rs232_rx_position_drop(const uint16_t position, const uint16_t reserved, const uint16_t drop) {
+	const uint16_t offset = rs232_rx_offset(position);
+
+	if(offset < reserved) {
+		return (position + drop) % rs232.rb_rx.size;
+	}
+
+	if(offset < reserved + drop) {
+		return (rs232.rb_rx.start + reserved + drop) % rs232.rb_rx.size;
+	}
+
+	return position;
+}
+
+/*
+ * Removes length bytes at offset from the RX ringbuffer. The first offset
+ * bytes are moved up over the removed bytes, the RX interrupt only writes in
+ * the free part. Frame ends in the removed part are taken out of the whole
+ * frame queue, all other positions are moved with the data. Only called
+ * while the RX interrupt does not drop the oldest bytes by itself (see
+ * rs232_rx_drop_oldest_update()), so start is not moved during the copy.
+ */
+static void rs232_rx_cut(const uint16_t offset, const uint16_t length) {
+	Ringbuffer *const rb = &rs232.rb_rx;
+	const uint16_t size = rb->size;
+	const uint16_t start = rb->start;
+
+	if(length == 0) {
+		return;
+	}
+
+	for(uint16_t i = offset; i > 0; i--) {
+		uint16_t from = start + i - 1;
+		if(from >= size) {
+			from -= size;
+		}
+
+		uint16_t to = from + length;
+		if(to >= size) {
+			to -= size;
+		}
+
+		rb->buffer[to] = rb->buffer[from];
+	}
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+
+	// Frames that ended in the removed part are gone, the others are kept in order.
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < rs232.frame_end_count; i++) {
+		const uint16_t end = rs232.frame_end[(rs232.frame_end_first + i) % FRAME_QUEUE_SIZE];
+		const uint16_t end_offset = rs232_rx_offset(end);
+
+		if((end_offset > offset) && (end_offset <= offset + length)) {
+			continue;
+		}
+
+		rs232.frame_end[(rs232.frame_end_first + count) % FRAME_QUEUE_SIZE] = rs232_rx_position_drop(end, offset, length);
+		count++;
+	}
+	rs232.frame_end_count = count;
+
+	if(rs232_rx_offset(rs232.frame_scan_position) < offset + length) {
+		rs232.frame_scan_position = rs232_rx_position_drop(rs232.frame_scan_position, offset, length);
+		rs232.frame_delimiter_matched = 0;
+	}
+	rs232.frame_gap_last_end = rs232_rx_position_drop(rs232.frame_gap_last_end, offset, length);
+	rs232.poll_rx_position = rs232_rx_position_drop(rs232.poll_rx_position, offset, length);
+	rs232.transaction_rx_position = rs232_rx_position_drop(rs232.transaction_rx_position, offset, length);
+
+	rb->start = (rb->start + length) % size;
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	if(rs232.frame_gap_length > 0) {
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+	}
+}
+
+static void rs232_rx_drop_oldest_tick(void) {
+	// During a transaction the bytes in front of the response are kept.
+	// Without positions held by the main loop the RX interrupt drops by itself.
+	if((rs232.rx_overflow_policy != RS232_V2_RX_OVERFLOW_POLICY_DROP_OLDEST) ||
+	   (rs232.transaction_state > TRANSACTION_STATE_WRITE) ||
+	   rs232.rx_drop_oldest_in_irq) {
+		return;
+	}
+
+	Ringbuffer *const rb = &rs232.rb_rx;
+	const uint16_t free = ringbuffer_get_free(rb);
+
+	if(free >= RS232_RX_DROP_OLDEST_FREE) {
+		return;
+	}
+
+	const uint16_t size = rb->size;
+	const uint16_t used = size - 1 - free;
+	const uint16_t reserved = rs232_rx_reserved();
+	const uint16_t frame_size = rs232.frame_readable_cb_frame_size;
+
+	if(reserved >= used) {
+		return;
+	}
+
+	uint16_t drop = RS232_RX_DROP_OLDEST_FREE - free;
+
+	if(rs232_frame_is_enabled()) {
+		// Drop up to the first frame end behind the bytes we need.
+		for(uint8_t i = 0; i < rs232.frame_end_count; i++) {
+			const uint16_t offset = rs232_rx_offset(rs232.frame_end[(rs232.frame_end_first + i) % FRAME_QUEUE_SIZE]);
+
+			if(offset >= reserved + drop) {
+				drop = offset - reserved;
+				break;
+			}
+		}
+	}
+	else if(frame_size > 0) {
+		drop = ((drop + frame_size - 1) / frame_size) * frame_size;
+		if(drop > used - reserved) {
+			drop = ((used - reserved) / frame_size) * frame_size;
+		}
+	}
+
+	if(drop > used - reserved) {
+		drop = used - reserved;
+	}
+
+	if(drop == 0) {
+		return;
+	}
+
+	rs232_rx_cut(reserved, drop);
+
+	if(rs232.rx_timestamp_enabled && (frame_size > 0)) {
+		for(uint16_t i = drop / frame_size; (i > 0) && (rs232.rx_timestamp_count > 0); i--) {
+			rs232.rx_timestamp_first = (rs232.rx_timestamp_first + 1) % RX_TIMESTAMP_QUEUE_SIZE;
+			rs232.rx_timestamp_count--;
+		}
+	}
+
+	rs232._error_count_overrun += drop;
+	rs232.rx_overflow_dropped_oldest += drop;
+}
+
+/*
+ * The RX interrupt can only drop the oldest bytes by itself if nothing in the
+ * main loop holds a position in the RX ringbuffer. Otherwise the drop is done
+ * by rs232_rx_drop_oldest_tick() and the interrupt falls back to dropping the
+ * newest bytes. The RX interrupt only reads the result, this has to be called
+ * whenever one of the conditions changes, before a position is taken.
+ */
+void rs232_rx_drop_oldest_update(void) {
+	rs232.rx_drop_oldest_in_irq = (rs232.rx_overflow_policy == RS232_V2_RX_OVERFLOW_POLICY_DROP_OLDEST) &&
+	                              (rs232.frame_delimiter_length == 0) &&
+	                              (rs232.frame_gap_length == 0) &&
+	                              (rs232.frame_readable_cb_frame_size == 0) &&
+	                              (rs232.poll_active == POLL_NONE) &&
+	                              (rs232.transaction_state == TRANSACTION_STATE_IDLE) &&
+	                              !modbus.enabled &&
+	                              !rs232.read_stream_status.in_progress;
+}
+
+void rs232_rx_overflow_set_policy(const uint8_t policy) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	rs232.rx_overflow_policy = policy;
+	rs232_rx_drop_oldest_update();
+
+	if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_OFF) {
+		// Assert RTS pin, it is only used by the block policy.
+		XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
+		rs232.fc_hw_rx_wait = false;
+	}
+
+	rs232_select_irq_handlers(rs232.reconfigure_pending);
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+/*
+ * Free space in the TX ringbuffer that the write stream may fill. With the
+ * buffer pool enabled the free space above the TX minimum can be given to
+ * RX at any time, so only the part below it is given as credit.
+ */
+uint16_t rs232_write_credit(void) {
+	const uint16_t free = ringbuffer_get_free(&rs232.rb_tx);
+
+	if(rs232.buffer_pool_enabled) {
+		const uint16_t used = ringbuffer_get_used(&rs232.rb_tx);
+
+		if(used >= rs232.buffer_pool_minimum_tx - 1) {
+			return 0;
+		}
+
+		if(free > rs232.buffer_pool_minimum_tx - 1 - used) {
+			return rs232.buffer_pool_minimum_tx - 1 - used;
+		}
+	}
+
+	return free;
+}
+
+static void rs232_write_credit_tick(void) {
+	if((rs232.write_credit_period == 0) || rs232.do_write_credit_callback ||
+	   !system_timer_is_time_elapsed_ms(rs232.write_credit_last_time, rs232.write_credit_period)) {
+		return;
+	}
+
+	const uint16_t credit = rs232_write_credit();
+
+	rs232.write_credit_last_time = system_timer_get_ms();
+
+	if(rs232.write_credit_value_has_to_change &&
+	   (rs232.write_credit_last_received == rs232.write_stream_received) &&
+	   (rs232.write_credit_last_credit == credit)) {
+		return;
+	}
+
+	rs232.write_credit_last_received = rs232.write_stream_received;
+	rs232.write_credit_last_credit = credit;
+	rs232.do_write_credit_callback = true;
+}
+
+/*
+ * Converts the times the RX interrupt took in CPU cycles since the last call
+ * to us. Called in every rs232_tick(), well within the 89s after which the
+ * cycle time wraps around, and before the us times are read.
+ */
+void rs232_rx_time_update(void) {
+	if((rs232.rx_time_new == 0) && (rs232.rx_timestamp_converted == rs232.rx_timestamp_count)) {
+		return;
+	}
+
+	const uint32_t load = SysTick->LOAD + 1;
+	const uint32_t cycles_per_us = load / 1000;
+	uint32_t cycles;
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	const uint32_t ms = rs232_get_time(&cycles, load);
+	const uint32_t now_us = ms * 1000 + (cycles * 1000) / load;
+	const uint32_t now_cycles = ms * load + cycles;
+
+	if(rs232.rx_time_new & RX_TIME_NEW_OLDEST) {
+		rs232.rx_oldest_us = now_us - (now_cycles - rs232.rx_oldest_cycles) / cycles_per_us;
+	}
+
+	if(rs232.rx_time_new & RX_TIME_NEW_NEWEST) {
+		rs232.rx_newest_us = now_us - (now_cycles - rs232.rx_newest_cycles) / cycles_per_us;
+	}
+
+	rs232.rx_time_new = 0;
+
+	for(; rs232.rx_timestamp_converted < rs232.rx_timestamp_count; rs232.rx_timestamp_converted++) {
+		RS232RXTimestamp_t *const timestamp = &rs232.rx_timestamp[(rs232.rx_timestamp_first + rs232.rx_timestamp_converted) % RX_TIMESTAMP_QUEUE_SIZE];
+
+		timestamp->first_byte = now_us - (now_cycles - timestamp->first_byte) / cycles_per_us;
+		timestamp->last_byte = now_us - (now_cycles - timestamp->last_byte) / cycles_per_us;
+	}
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+void rs232_rx_timestamp_reset(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	rs232.rx_timestamp_frame_fill = 0;
+	rs232.rx_timestamp_first = 0;
+	rs232.rx_timestamp_count = 0;
+	rs232.rx_timestamp_converted = 0;
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+}
+
+// Returns the number of queued timestamps including the popped one.
+uint8_t rs232_rx_timestamp_pop(RS232RXTimestamp_t *timestamp) {
+	rs232_rx_time_update();
+
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	const uint8_t count = rs232.rx_timestamp_count;
+
+	if(count > 0) {
+		*timestamp = rs232.rx_timestamp[rs232.rx_timestamp_first];
+		rs232.rx_timestamp_first = (rs232.rx_timestamp_first + 1) % RX_TIMESTAMP_QUEUE_SIZE;
+		rs232.rx_timestamp_count--;
+		if(rs232.rx_timestamp_converted > 0) {
+			rs232.rx_timestamp_converted--;
+		}
+	}
+
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+
+	return count;
+}
+
+void reset_read_stream_status() {
+	rs232.read_stream_status.in_progress = false;
+	rs232.read_stream_status.stream_sent = 0;
+	rs232.read_stream_status.stream_chunk_offset = 0;
+	rs232.read_stream_status.stream_total_length = 0;
+	rs232.frame_readable_cb_already_sent = false;
+	rs232_rx_drop_oldest_update();
+}
+
+bool rs232_frame_is_enabled(void) {
+	return (rs232.frame_delimiter_length > 0) || (rs232.frame_gap_length > 0);
+}
+
+void rs232_frame_disable(void) {
+	rs232.frame_delimiter_length = 0;
+	rs232.frame_gap_length = 0;
+	rs232_rx_drop_oldest_update();
+	rs232_frame_gap_init();
+}
+
+void rs232_frame_set_gap(const uint16_t gap_length) {
+	rs232.frame_delimiter_length = 0;
+	rs232.frame_gap_length = gap_length;
+	rs232_rx_drop_oldest_update();
+	rs232_frame_gap_init();
+	rs232_frame_reset();
+}
+
+void rs232_frame_set_delimiter(const uint8_t *delimiter, const uint8_t length) {
+	if(rs232.frame_gap_length > 0) {
+		rs232.frame_gap_length = 0;
+		rs232_frame_gap_init();
+	}
+
+	rs232.frame_delimiter_length = length;
+	rs232_rx_drop_oldest_update();
+
+	/*
+	 * Prefix function of the delimiter (KMP). On a mismatch after matched
+	 * bytes the scan continues with frame_delimiter_fallback[matched] bytes
+	 * matched, so delimiters like "aab" are found in "aaab".
+	 */
+	for(uint8_t i = 0; i < length; i++) {
+		uint8_t k = (i == 0) ? 0 : rs232.frame_delimiter_fallback[i - 1];
+
+		rs232.frame_delimiter[i] = delimiter[i];
+
+		while((k > 0) && (delimiter[i] != delimiter[k])) {
+			k = rs232.frame_delimiter_fallback[k - 1];
+		}
+
+		if((i > 0) && (delimiter[i] == delimiter[k])) {
+			k++;
+		}
+
+		rs232.frame_delimiter_fallback[i] = k;
+	}
+
+	rs232_frame_reset();
+}
+
+static void rs232_frame_scan(void) {
+	if(rs232.frame_delimiter_length == 0) {
+		return;
+	}
+
+	const uint16_t size = rs232.rb_rx.size;
+	const uint16_t end = rs232.rb_rx.end;
+	uint16_t position = rs232.frame_scan_position;
+	uint8_t matched = rs232.frame_delimiter_matched;
+
+	while((position != end) && (rs232.frame_end_count < FRAME_QUEUE_SIZE)) {
+		const uint8_t data = rs232.rb_rx.buffer[position];
+
+		position++;
+		if(position >= size) {
+			position = 0;
+		}
+
+		while((matched > 0) && (data != rs232.frame_delimiter[matched])) {
+			matched = rs232.frame_delimiter_fallback[matched - 1];
+		}
+
+		if(data == rs232.frame_delimiter[matched]) {
+			matched++;
+		}
+
+		if(matched == rs232.frame_delimiter_length) {
+			rs232_frame_push(position);
+			matched = 0;
+		}
+	}
+
+	rs232.frame_scan_position = position;
+	rs232.frame_delimiter_matched = matched;
+}
+
+// Checks the checksum in front of the delimiter (or at the end in gap mode) of the next frame.
+static bool rs232_frame_check_crc(const uint16_t length) {
+	const uint8_t crc_length = crc_get_length(rs232.crc_type);
+	const uint16_t trailer_length = crc_length + rs232.frame_delimiter_length;
+
+	if(length < trailer_length) {
+		return false;
+	}
+
+	const uint16_t data_length = length - trailer_length;
+	const uint16_t start = rs232.rb_rx.start;
+	const uint16_t count_to_wrap = rs232.rb_rx.size - start;
+	uint32_t crc = crc_start(rs232.crc_type);
+	uint8_t checksum[CRC_MAX_LENGTH];
+
+	if(data_length <= count_to_wrap) {
+		crc = crc_update(rs232.crc_type, crc, &rs232.rb_rx.buffer[start], data_length);
+	}
+	else {
+		crc = crc_update(rs232.crc_type, crc, &rs232.rb_rx.buffer[start], count_to_wrap);
+		crc = crc_update(rs232.crc_type, crc, &rs232.rb_rx.buffer[0], data_length - count_to_wrap);
+	}
+
+	crc_finish(rs232.crc_type, crc, checksum);
+
+	uint16_t index = (start + data_length) % rs232.rb_rx.size;
+	for(uint8_t i = 0; i < crc_length; i++) {
+		if(rs232.rb_rx.buffer[index] != checksum[i]) {
+			return false;
+		}
+
+		index = (index + 1) % rs232.rb_rx.size;
+	}
+
+	return true;
+}
+
+// Returns the length of the oldest complete frame (including delimiter) and removes it from the queue.
+uint16_t rs232_frame_pop(void) {
+	while(rs232.frame_end_count > 0) {
+		const uint16_t frame_end = rs232.frame_end[rs232.frame_end_first];
+		const uint16_t start = rs232.rb_rx.start;
+		const uint16_t length = (frame_end > start) ? (frame_end - start) : (rs232.rb_rx.size - start + frame_end);
+
+		// In gap mode frames are queued from the timer interrupt.
+		NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+		rs232.frame_end_first = (rs232.frame_end_first + 1) % FRAME_QUEUE_SIZE;
+		rs232.frame_end_count--;
+		if(rs232.frame_gap_length > 0) {
+			NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_FRAME_GAP);
+		}
+
+		if(!rs232.crc_verify_rx || rs232_frame_check_crc(length)) {
+			return length;
+		}
+
+		rs232.error_count_crc++;
+
+		if(!rs232.crc_drop_invalid_rx) {
+			return length;
+		}
+
+		ringbuffer_remove(&rs232.rb_rx, length);
+	}
+
+	return 0;
+}
+
+/*
+ * Bulk ringbuffer access for the TFP handlers. The data is copied with at
+ * most two memcpy around the wrap point and the start/end index is written
+ * only once at the end, so it is safe against the RX/TX interrupts that
+ * work on the other end of the ringbuffer.
+ */
+uint16_t rs232_ringbuffer_add_n(Ringbuffer *rb, const uint8_t *data, const uint16_t length) {
+	const uint16_t free = ringbuffer_get_free(rb);
+	uint16_t end = rb->end;
+	uint16_t count = length;
+
+	if(count > free) {
+		count = free;
+		rb->overflows++;
+	}
+
+	const uint16_t count_to_wrap = rb->size - end;
+
+	if(count < count_to_wrap) {
+		memcpy(&rb->buffer[end], data, count);
+		end += count;
+	}
+	else {
+		memcpy(&rb->buffer[end], data, count_to_wrap);
+		memcpy(&rb->buffer[0], &data[count_to_wrap], count - count_to_wrap);
+		end = count - count_to_wrap;
+	}
+
+	rb->end = end;
+
+	if((free - count) < rb->low_watermark) {
+		rb->low_watermark = free - count;
+	}
+
+	return count;
+}
+
+uint16_t rs232_ringbuffer_get_n(Ringbuffer *rb, uint8_t *data, const uint16_t length) {
+	// With the drop-oldest policy the RX interrupt moves the start of the RX ringbuffer.
+	const bool rx = rb == &rs232.rb_rx;
+	if(rx) {
+		NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+		NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	}
+
+	const uint16_t used = ringbuffer_get_used(rb);
+	uint16_t start = rb->start;
+	uint16_t count = length;
+
+	if(count > used) {
+		count = used;
+	}
+
+	const uint16_t count_to_wrap = rb->size - start;
+
+	if(count < count_to_wrap) {
+		memcpy(data, &rb->buffer[start], count);
+		start += count;
+	}
+	else {
+		memcpy(data, &rb->buffer[start], count_to_wrap);
+		memcpy(&data[count_to_wrap], &rb->buffer[0], count - count_to_wrap);
+		start = count - count_to_wrap;
+	}
+
+	rb->start = start;
+
+	if(rx) {
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+		NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	}
+
+	return count;
+}
+
+/*
+ * The saved configuration is checked with the same limits as the setters,
+ * a page that does not pass is ignored as a whole. This includes the
+ * combinations the setters don't allow: only one of delimiter and frame gap,
+ * and the read callback, frame readable callback and the frame modes
+ * exclude each other.
+ */
+static bool rs232_configuration_load(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+	bootloader_read_eeprom_page(RS232_CONFIG_PAGE, page);
+
+	if(page[RS232_CONFIG_MAGIC_POS] != RS232_CONFIG_MAGIC) {
+		return false;
+	}
+
+	const RS232Configuration_t config = {
+		.baudrate = page[RS232_CONFIG_BAUDRATE_POS],
+		.parity = page[RS232_CONFIG_FRAMING_POS] & 0xFF,
+		.stopbits = (page[RS232_CONFIG_FRAMING_POS] >> 8) & 0xFF,
+		.wordlength = (page[RS232_CONFIG_FRAMING_POS] >> 16) & 0xFF,
+		.flowcontrol = (page[RS232_CONFIG_FRAMING_POS] >> 24) & 0xFF,
+		.buffer_size_rx = page[RS232_CONFIG_BUFFER_POS] & 0xFFFF,
+		.buffer_size_tx = page[RS232_CONFIG_BUFFER_POS] >> 16
+	};
+	const uint8_t fc_high = page[RS232_CONFIG_WATERMARK_POS] & 0xFF;
+	const uint8_t fc_low = (page[RS232_CONFIG_WATERMARK_POS] >> 8) & 0xFF;
+	const uint8_t delimiter_length = page[RS232_CONFIG_FRAME_POS] & 0xFF;
+	const uint16_t gap_length = page[RS232_CONFIG_FRAME_POS] >> 16;
+	const bool read_callback = page[RS232_CONFIG_CALLBACK_POS] & (1 << 0);
+	const bool frame_mode = (page[RS232_CONFIG_CALLBACK_POS] & (1 << 1)) || (delimiter_length > 0) || (gap_length > 0);
+	const uint16_t frame_size = page[RS232_CONFIG_CALLBACK_POS] >> 16;
+	const uint8_t crc_type = page[RS232_CONFIG_CRC_POS] & 0xFF;
+	const uint16_t pool_minimum_rx = page[RS232_CONFIG_BUFFER_POOL_POS] & 0xFFFF;
+	const uint16_t pool_minimum_tx = page[RS232_CONFIG_BUFFER_POOL_POS] >> 16;
+	const bool pool_enabled = page[RS232_CONFIG_BUFFER_POOL_POS] != 0;
+
+	if(!rs232_configuration_is_valid(&config) ||
+	   (pool_enabled && ((pool_minimum_rx < 1024) || (pool_minimum_tx < 1024) ||
+	                     (config.buffer_size_rx < pool_minimum_rx) || (config.buffer_size_tx < pool_minimum_tx))) ||
+	   (fc_high == 0) || (fc_high > 100) || (fc_low >= fc_high) ||
+	   (page[RS232_CONFIG_COALESCING_MINIMUM_BYTES_POS] == 0) ||
+	   (page[RS232_CONFIG_COALESCING_MINIMUM_BYTES_POS] > 0xFFFF) ||
+	   (delimiter_length > FRAME_DELIMITER_MAX_LENGTH) ||
+	   ((delimiter_length > 0) && (gap_length > 0)) ||
+	   (read_callback && (frame_mode || (frame_size > 0))) ||
+	   (frame_mode && (frame_size > 0)) ||
+	   (crc_type > RS232_V2_CRC_TYPE_SUM8) ||
+	   (page[RS232_CONFIG_RX_OVERFLOW_POS] > RS232_V2_RX_OVERFLOW_POLICY_BLOCK)) {
+		return false;
+	}
+
+	rs232.baudrate = config.baudrate;
+	rs232.parity = config.parity;
+	rs232.stopbits = config.stopbits;
+	rs232.wordlength = config.wordlength;
+	rs232.flowcontrol = config.flowcontrol;
+	rs232.buffer_size_rx = config.buffer_size_rx;
+	rs232.buffer_size_tx = config.buffer_size_tx;
+	rs232.fc_rx_high_watermark = fc_high;
+	rs232.fc_rx_low_watermark = fc_low;
+	if(pool_enabled) {
+		rs232.buffer_pool_enabled = true;
+		rs232.buffer_pool_minimum_rx = pool_minimum_rx;
+		rs232.buffer_pool_minimum_tx = pool_minimum_tx;
+	}
+	rs232.rx_overflow_policy = page[RS232_CONFIG_RX_OVERFLOW_POS];
+
+	rs232.read_callback_enabled = read_callback;
+	rs232.frame_callback_enabled = page[RS232_CONFIG_CALLBACK_POS] & (1 << 1);
+	rs232.rx_timestamp_enabled = page[RS232_CONFIG_CALLBACK_POS] & (1 << 2);
+	rs232.write_credit_value_has_to_change = page[RS232_CONFIG_CALLBACK_POS] & (1 << 3);
+	rs232.write_credit_period = page[RS232_CONFIG_WRITE_CREDIT_PERIOD_POS];
+	rs232.frame_readable_cb_frame_size = frame_size;
+	rs232.read_callback_minimum_bytes = page[RS232_CONFIG_COALESCING_MINIMUM_BYTES_POS];
+	rs232.read_callback_maximum_latency = page[RS232_CONFIG_COALESCING_MAXIMUM_LATENCY_POS];
+
+	// The delimiter is set up with rs232_frame_set_delimiter() once the ringbuffer is initialized.
+	memcpy(rs232.frame_delimiter, &page[RS232_CONFIG_DELIMITER_POS], FRAME_DELIMITER_MAX_LENGTH);
+	rs232.frame_delimiter_length = delimiter_length;
+	rs232.frame_gap_length = gap_length;
+
+	rs232.crc_type = crc_type;
+	rs232.crc_append_tx = (page[RS232_CONFIG_CRC_POS] >> 8) & 0xFF;
+	rs232.crc_verify_rx = (page[RS232_CONFIG_CRC_POS] >> 16) & 0xFF;
+	rs232.crc_drop_invalid_rx = (page[RS232_CONFIG_CRC_POS] >> 24) & 0xFF;
+
+	return true;
+}
+
+/*
+ * Saves the current UART, buffer, flow control, RX overflow, frame, CRC and
+ * callback configuration. It is restored by rs232_init() on the next start.
+ * The page is only written if it changed, to spare the flash.
+ */
+bool rs232_configuration_save(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+	uint32_t page_saved[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+
+	memset(page, 0, EEPROM_PAGE_SIZE);
+	page[RS232_CONFIG_MAGIC_POS] = RS232_CONFIG_MAGIC;
+	page[RS232_CONFIG_BAUDRATE_POS] = rs232.reconfigure.baudrate;
+	page[RS232_CONFIG_FRAMING_POS] = ((uint32_t)rs232.reconfigure.parity & 0xFF) |
+	                                 (rs232.reconfigure.stopbits << 8) |
+	                                 (rs232.reconfigure.wordlength << 16) |
+	                                 ((uint32_t)rs232.reconfigure.flowcontrol << 24);
+	page[RS232_CONFIG_BUFFER_POS] = rs232.reconfigure.buffer_size_rx | (rs232.reconfigure.buffer_size_tx << 16);
+	page[RS232_CONFIG_WATERMARK_POS] = rs232.fc_rx_high_watermark | (rs232.fc_rx_low_watermark << 8);
+	page[RS232_CONFIG_CALLBACK_POS] = (rs232.read_callback_enabled << 0) |
+	                                  (rs232.frame_callback_enabled << 1) |
+	                                  (rs232.rx_timestamp_enabled << 2) |
+	                                  (rs232.write_credit_value_has_to_change << 3) |
+	                                  ((uint32_t)rs232.frame_readable_cb_frame_size << 16);
+	page[RS232_CONFIG_COALESCING_MINIMUM_BYTES_POS] = rs232.read_callback_minimum_bytes;
+	page[RS232_CONFIG_COALESCING_MAXIMUM_LATENCY_POS] = rs232.read_callback_maximum_latency;
+	memcpy(&page[RS232_CONFIG_DELIMITER_POS], rs232.frame_delimiter, FRAME_DELIMITER_MAX_LENGTH);
+	page[RS232_CONFIG_FRAME_POS] = rs232.frame_delimiter_length | ((uint32_t)rs232.frame_gap_length << 16);
+	page[RS232_CONFIG_CRC_POS] = rs232.crc_type |
+	                             (rs232.crc_append_tx << 8) |
+	                             (rs232.crc_verify_rx << 16) |
+	                             ((uint32_t)rs232.crc_drop_invalid_rx << 24);
+	page[RS232_CONFIG_RX_OVERFLOW_POS] = rs232.rx_overflow_policy;
+	page[RS232_CONFIG_WRITE_CREDIT_PERIOD_POS] = rs232.write_credit_period;
+	if(rs232.buffer_pool_enabled) {
+		page[RS232_CONFIG_BUFFER_POOL_POS] = rs232.buffer_pool_minimum_rx | ((uint32_t)rs232.buffer_pool_minimum_tx << 16);
+	}
+
+	bootloader_read_eeprom_page(RS232_CONFIG_PAGE, page_saved);
+	if(memcmp(page, page_saved, EEPROM_PAGE_SIZE) == 0) {
+		return true;
+	}
+
+	return bootloader_write_eeprom_page(RS232_CONFIG_PAGE, page);
+}
+
+// The defaults are used again from the next start on.
+bool rs232_configuration_clear(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+
+	bootloader_read_eeprom_page(RS232_CONFIG_PAGE, page);
+	if(page[RS232_CONFIG_MAGIC_POS] != RS232_CONFIG_MAGIC) {
+		return true;
+	}
+
+	memset(page, 0, EEPROM_PAGE_SIZE);
+	return bootloader_write_eeprom_page(RS232_CONFIG_PAGE, page);
+}
+
+void rs232_init() {
+	logd("[+] RS232-V2: rs232_init()\n\r");
+
+	// Initialize RS232 default configuration.
+	rs232.baudrate = 115200;
+	rs232.parity = RS232_V2_PARITY_NONE;
+	rs232.stopbits = (uint8_t)RS232_V2_STOPBITS_1;
+	rs232.wordlength = (uint8_t)RS232_V2_WORDLENGTH_8;
+	rs232.flowcontrol = RS232_V2_FLOWCONTROL_OFF;
+
+	rs232._error_count_parity = 0;
+	rs232._error_count_overrun = 0;
+	rs232.error_count_parity = 0;
+	rs232.error_count_overrun = 0;
+	rs232.do_error_count_callback = false;
+	rs232._error_count_framing = 0;
+	rs232._error_count_break = 0;
+	rs232._error_count_noise = 0;
+	rs232._error_count_fifo_overflow = 0;
+	rs232.error_count_framing = 0;
+	rs232.error_count_break = 0;
+	rs232.error_count_noise = 0;
+	rs232.error_count_fifo_overflow = 0;
+	rs232.do_error_count_extended_callback = false;
+	rs232.error_count_crc = 0;
+
+	memset(rs232.poll, 0, sizeof(rs232.poll));
+	for(uint8_t i = 0; i < POLL_TABLE_SIZE; i++) {
+		rs232.poll[i].terminator = -1;
+	}
+	rs232.poll_active = POLL_NONE;
 
-					return;
-				}
-			}
-		}
+	rs232.transaction_state = TRANSACTION_STATE_IDLE;
 
-		if(!ringbuffer_get(&rs232.rb_tx, &data)) {
-			// No more data to TX from the ringbuffer, disable TX interrupt.
-			XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC,
-			                                XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	rs232.crc_type = RS232_V2_CRC_TYPE_NONE;
+	rs232.crc_append_tx = false;
+	rs232.crc_verify_rx = false;
+	rs232.crc_drop_invalid_rx = false;
 
-			return;
-		}
+	rs232.read_callback_enabled = false;
+	rs232.read_callback_minimum_bytes = 1;
+	rs232.read_callback_maximum_latency = 0;
+	rs232.rx_timestamp_enabled = false;
+	rs232.frame_readable_cb_frame_size = 0;
+	rs232.frame_delimiter_length = 0;
+	rs232.frame_gap_length = 0;
+	rs232.frame_callback_enabled = false;
+
+	rs232.buffer_size_rx = RS232_BUFFER_SIZE / 2;
+	rs232.buffer_size_tx = RS232_BUFFER_SIZE / 2;
+	rs232.buffer_pool_enabled = false;
+	rs232.buffer_pool_minimum_rx = 1024;
+	rs232.buffer_pool_minimum_tx = 1024;
+
+	rs232.rx_overflow_policy = RS232_V2_RX_OVERFLOW_POLICY_DROP_NEWEST;
+	rs232.rx_overflow_dropped_newest = 0;
+	rs232.rx_overflow_dropped_oldest = 0;
+
+	rs232.write_stream_received = 0;
+	rs232.write_stream_dropped = 0;
+	rs232.write_credit_period = 0;
+	rs232.write_credit_value_has_to_change = false;
+	rs232.write_credit_last_time = 0;
+	rs232.write_credit_last_received = 0;
+	rs232.write_credit_last_credit = 0;
+	rs232.do_write_credit_callback = false;
+
+	rs232.fc_sw_tx_control = 0;
+	rs232.fc_sw_state_rx = FC_SW_STATE_RX_OK;
+	rs232.fc_sw_state_tx = FC_SW_STATE_TX_OK;
+	rs232.fc_hw_rx_wait = false;
+	rs232.fc_rx_high_watermark = FC_RX_HIGH_WATERMARK_DEFAULT;
+	rs232.fc_rx_low_watermark = FC_RX_LOW_WATERMARK_DEFAULT;
+	rs232.fc_throttle_last_us = rs232_get_time_us();
+	rs232.fc_rx_throttled_us = 0;
+	rs232.fc_tx_throttled_us = 0;
+
+	rs232.baudrate_detection_active = false;
+	rs232.baudrate_detected = 0;
+	rs232.baudrate_measured = 0;
+	rs232.do_baudrate_detected_callback = false;
+
+	rs232_configuration_load();
 
-		RS232_USIC->IN[0] = data;
+	reset_read_stream_status();
+	rs232_apply_configuration();
+	if(rs232.frame_delimiter_length > 0) {
+		rs232_frame_set_delimiter(rs232.frame_delimiter, rs232.frame_delimiter_length);
 	}
+	rs232_statistics_reset();
 }
 
-void __attribute__((optimize("-O3"))) rs232_rxa_irq_handler() {
-	/*
-	 * We get alternate RX interrupt if there is a parity error.
-	 * In this case we still read the byte and give it to the user.
-	 */
-	rs232_rx_irq_handler();
+/*
+ * The peer is stopped (XOFF or RTS de-asserted) if the RX buffer is filled
+ * above the high watermark, but always if less than FC_RB_RX_LIMIT bytes
+ * are free. It is resumed (XON or RTS asserted) once the buffer is drained
+ * to the low watermark. Both are given in percent of the RX buffer.
+ */
+void rs232_fc_set_watermarks(const uint8_t high, const uint8_t low) {
+	const uint16_t size = rs232.rb_rx.size;
+	uint16_t stop_free = size - (uint32_t)size * high / 100;
 
-	rs232._error_count_parity++;
+	if(stop_free < FC_RB_RX_LIMIT) {
+		stop_free = FC_RB_RX_LIMIT;
+	}
+
+	rs232.fc_rx_high_watermark = high;
+	rs232.fc_rx_low_watermark = low;
+	rs232.fc_rx_stop_free = stop_free;
+	rs232.fc_rx_resume_used = (uint32_t)size * low / 100;
 }
 
+// We told the peer to stop sending.
+bool rs232_fc_is_rx_throttled(void) {
+	switch(rs232.flowcontrol) {
+		case RS232_V2_FLOWCONTROL_SOFTWARE: return rs232.fc_sw_state_rx == FC_SW_STATE_RX_WAIT;
+		case RS232_V2_FLOWCONTROL_HARDWARE: return rs232.fc_hw_rx_wait;
+		default: return rs232.fc_hw_rx_wait; // RTS of the block RX overflow policy.
+	}
+}
 
+// The peer told us to stop sending.
+bool rs232_fc_is_tx_throttled(void) {
+	switch(rs232.flowcontrol) {
+		case RS232_V2_FLOWCONTROL_SOFTWARE: return rs232.fc_sw_state_tx == FC_SW_STATE_TX_WAIT;
+		case RS232_V2_FLOWCONTROL_HARDWARE: return XMC_GPIO_GetInput(RS232_CTS_PIN) == 1;
+		default: return false;
+	}
+}
 
-static void rs232_init_hardware() {
-	logd("[+] RS232-V2: rs232_init_hardware()\n\r");
+// Sums up the time spent throttled per direction, with the main loop period as resolution.
+static void rs232_fc_throttle_tick(const uint32_t now) {
+	const uint32_t elapsed = now - rs232.fc_throttle_last_us;
 
-	// RTS/CTS pin configuration.
-	XMC_GPIO_CONFIG_t rts_pin_config = {
-		.mode = XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
-		.output_level = XMC_GPIO_OUTPUT_LEVEL_LOW
-	};
+	rs232.fc_throttle_last_us = now;
 
-	XMC_GPIO_CONFIG_t cts_pin_config = {
-		.mode = XMC_GPIO_MODE_INPUT_PULL_DOWN,
-	};
+	if(rs232_fc_is_rx_throttled()) {
+		rs232.fc_rx_throttled_us += elapsed;
+	}
 
-	// RX pin configuration.
-	const XMC_GPIO_CONFIG_t rx_pin_config = {
-		.mode = XMC_GPIO_MODE_INPUT_PULL_UP,
-		.input_hysteresis = XMC_GPIO_INPUT_HYSTERESIS_STANDARD
-	};
+	if(rs232_fc_is_tx_throttled()) {
+		rs232.fc_tx_throttled_us += elapsed;
+	}
+}
 
-	// Configure TX pin high during configuration,
-	// otherwise there can be glitches on TX line if
-	// configuration changes.
-	XMC_GPIO_CONFIG_t tx_pin_config_high = {
-		.mode = XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
-		.output_level = XMC_GPIO_OUTPUT_LEVEL_HIGH
-	};
+void rs232_statistics_reset(void) {
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_TX);
 
-	// Configure  pins.
-	XMC_GPIO_Init(RS232_TX_PIN, &tx_pin_config_high);
-	XMC_GPIO_Init(RS232_RTS_PIN, &rts_pin_config);
-	XMC_GPIO_Init(RS232_CTS_PIN, &cts_pin_config);
-	XMC_GPIO_Init(RS232_RX_PIN, &rx_pin_config);
+	memset(&rs232.statistics, 0, sizeof(RS232Statistics_t));
+	rs232.statistics.window_start = rs232_get_time_us();
+	rs232.statistics.loop_last = rs232.statistics.window_start;
 
-	// Initialize USIC channel in UART mode.
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+}
 
-	// USIC channel configuration.
-	XMC_UART_CH_CONFIG_t cfg_uart_ch;
+/*
+ * Called once per main loop iteration. The loop period is the time between
+ * two calls, so it includes everything else that runs in the main loop.
+ * Rates are taken over windows of one second.
+ */
+static void rs232_statistics_tick(const uint32_t now) {
+	RS232Statistics_t *const statistics = &rs232.statistics;
+	const uint32_t period = now - statistics->loop_last;
+
+	statistics->loop_last = now;
+	statistics->loop_count++;
+	if(period > statistics->loop_period_max) {
+		statistics->loop_period_max = period;
+	}
 
-	cfg_uart_ch.baudrate = rs232.baudrate;
-	cfg_uart_ch.stop_bits = rs232.stopbits;
-	cfg_uart_ch.data_bits = rs232.wordlength;
-	cfg_uart_ch.oversampling = rs232.oversampling;
-	cfg_uart_ch.frame_length = rs232.wordlength;
+	// The TX buffer is only filled from the main loop, so sampling it here sees the peaks.
+	const uint16_t tx_used = ringbuffer_get_used(&rs232.rb_tx);
+	if(tx_used > statistics->tx_buffer_high_watermark) {
+		statistics->tx_buffer_high_watermark = tx_used;
+	}
 
-	switch(rs232.parity) {
-		case RS232_V2_PARITY_NONE:
-			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_NONE;
-			break;
+	const uint32_t window = now - statistics->window_start;
+	if(window >= 1000000) {
+		const uint32_t rx_bytes = statistics->rx_bytes;
+		const uint32_t tx_bytes = statistics->tx_bytes;
 
-		case RS232_V2_PARITY_ODD:
-			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_ODD;
-			break;
+		statistics->loop_per_second = (uint64_t)statistics->loop_count * 1000000 / window;
+		statistics->rx_bytes_per_second = (uint64_t)(rx_bytes - statistics->rx_bytes_window_start) * 1000000 / window;
+		statistics->tx_bytes_per_second = (uint64_t)(tx_bytes - statistics->tx_bytes_window_start) * 1000000 / window;
 
-		case RS232_V2_PARITY_EVEN:
-			cfg_uart_ch.parity_mode = XMC_USIC_CH_PARITY_MODE_EVEN;
-			break;
+		statistics->window_start = now;
+		statistics->loop_count = 0;
+		statistics->rx_bytes_window_start = rx_bytes;
+		statistics->tx_bytes_window_start = tx_bytes;
 	}
+}
 
-	XMC_UART_CH_Init(RS232_USIC, &cfg_uart_ch);
+/*
+ * Periodic polling table. Due messages are put into the TX buffer from
+ * rs232_tick. If an entry expects a response (response_length bytes or the
+ * terminator byte), no other entry is sent until the response arrived or
+ * the period of the entry elapsed. Responses are delivered by the normal
+ * read path.
+ */
+static void rs232_poll_tick(void) {
+	const uint32_t now = system_timer_get_ms();
 
-	// Set input source path.
-	XMC_UART_CH_SetInputSource(RS232_USIC, RS232_RX_INPUT, RS232_RX_SOURCE);
+	if(rs232.poll_active != POLL_NONE) {
+		const RS232PollEntry_t *const entry = &rs232.poll[rs232.poll_active];
+		const uint16_t end = rs232.rb_rx.end;
+		bool done = system_timer_is_time_elapsed_ms(rs232.poll_sent, entry->period);
 
-	// Configure TX FIFO.
-	XMC_USIC_CH_TXFIFO_Configure(RS232_USIC, 32, XMC_USIC_CH_FIFO_SIZE_32WORDS, 16);
+		for(; !done && (rs232.poll_rx_position != end); rs232.poll_rx_position = (rs232.poll_rx_position + 1) % rs232.rb_rx.size) {
+			rs232.poll_rx_received++;
 
-	// Configure RX FIFO.
-	XMC_USIC_CH_RXFIFO_Configure(RS232_USIC, 0, XMC_USIC_CH_FIFO_SIZE_32WORDS, 16);
+			if(((entry->response_length > 0) && (rs232.poll_rx_received >= entry->response_length)) ||
+			   (rs232.rb_rx.buffer[rs232.poll_rx_position] == entry->terminator)) {
+				done = true;
+			}
+		}
 
-	// UART protocol events.
+		if(!done) {
+			return;
+		}
 
-	// Set service request for RX FIFO receive interrupt.
-	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(
-		RS232_USIC,
-		XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD,
-		RS232_SERVICE_REQUEST_RX
-	);
+		rs232.poll_active = POLL_NONE;
+		rs232_rx_drop_oldest_update();
+	}
 
-	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(
-		RS232_USIC,
-		XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE,
-		RS232_SERVICE_REQUEST_RX
-	);
+	// Send the entry that is overdue the longest.
+	uint8_t due = POLL_NONE;
+	uint32_t due_late = 0;
 
-	// Set service request for TX FIFO transmit interrupt.
-	XMC_USIC_CH_TXFIFO_SetInterruptNodePointer(
-		RS232_USIC,
-		XMC_USIC_CH_TXFIFO_INTERRUPT_NODE_POINTER_STANDARD,
-		RS232_SERVICE_REQUEST_TX
-	);
+	for(uint8_t i = 0; i < POLL_TABLE_SIZE; i++) {
+		const uint32_t late = now - rs232.poll[i].next_send;
 
-	XMC_USIC_CH_SetInterruptNodePointer(
-		RS232_USIC,
-		XMC_USIC_CH_INTERRUPT_NODE_POINTER_ALTERNATE_RECEIVE,
-		RS232_SERVICE_REQUEST_RXA
-	);
+		if((rs232.poll[i].period > 0) && (late < 0x80000000) && ((due == POLL_NONE) || (late > due_late))) {
+			due = i;
+			due_late = late;
+		}
+	}
 
-	// Set priority and enable NVIC node for TX interrupt.
-	NVIC_SetPriority((IRQn_Type)RS232_IRQ_TX, RS232_IRQ_TX_PRIORITY);
-	XMC_SCU_SetInterruptControl(RS232_IRQ_TX, RS232_IRQCTRL_TX);
-	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_TX);
+	if((due == POLL_NONE) || (ringbuffer_get_free(&rs232.rb_tx) < rs232.poll[due].message_length)) {
+		return;
+	}
 
-	// Set priority and enable NVIC node for RX interrupt.
-	NVIC_SetPriority((IRQn_Type)RS232_IRQ_RX, RS232_IRQ_RX_PRIORITY);
-	XMC_SCU_SetInterruptControl(RS232_IRQ_RX, RS232_IRQCTRL_RX);
-	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+	RS232PollEntry_t *const entry = &rs232.poll[due];
 
-	// Set priority and enable NVIC node for RXA interrupt.
-	NVIC_SetPriority((IRQn_Type)RS232_IRQ_RXA, RS232_IRQ_RXA_PRIORITY);
-	XMC_SCU_SetInterruptControl(RS232_IRQ_RXA, RS232_IRQCTRL_RXA);
-	NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
+	rs232_ringbuffer_add_n(&rs232.rb_tx, entry->message, entry->message_length);
+	XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
+	XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
 
-	// Restart UART: Stop.
-	while(XMC_UART_CH_Stop(RS232_USIC) != XMC_UART_CH_STATUS_OK) {
-		;
+	// Schedule on the period grid, so that late sends do not add up.
+	entry->next_send += entry->period;
+	if((uint32_t)(now - entry->next_send) < 0x80000000) {
+		entry->next_send = now + entry->period;
 	}
 
-	// Restart UART: Start.
-	XMC_UART_CH_Start(RS232_USIC);
+	if((entry->response_length > 0) || (entry->terminator >= 0)) {
+		rs232.poll_active = due;
+		rs232_rx_drop_oldest_update();
+		rs232.poll_sent = now;
+		rs232.poll_rx_position = rs232.rb_rx.end;
+		rs232.poll_rx_received = 0;
+	}
+}
 
+void rs232_poll_set_entry(const uint8_t index, const uint32_t period, const uint16_t response_length, const int16_t terminator, const uint8_t *message, const uint8_t message_length) {
+	RS232PollEntry_t *const entry = &rs232.poll[index];
 
-	// TX pin configuration.
-	const XMC_GPIO_CONFIG_t tx_pin_config = {
-		.mode = RS232_TX_PIN_AF,
-		.output_level = XMC_GPIO_OUTPUT_LEVEL_HIGH
-	};
-	XMC_GPIO_Init(RS232_TX_PIN, &tx_pin_config);
+	if(rs232.poll_active == index) {
+		rs232.poll_active = POLL_NONE;
+		rs232_rx_drop_oldest_update();
+	}
 
-	XMC_USIC_CH_RXFIFO_EnableEvent(
-		RS232_USIC,
-		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
-	);
+	entry->period = period;
+	entry->next_send = system_timer_get_ms();
+	entry->response_length = response_length;
+	entry->terminator = terminator;
+	entry->message_length = message_length;
+	memcpy(entry->message, message, message_length);
+}
 
-	XMC_USIC_CH_EnableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+/*
+ * Write-then-read transaction. The response starts with the first byte
+ * that arrives after the request is complete in the TX buffer, bytes that
+ * were received before stay in the RX buffer in front of it. The response
+ * collects until response_length bytes or the terminator byte arrived or
+ * the timeout (in ms) elapsed.
+ */
+void rs232_transaction_start(const uint16_t response_length, const int16_t terminator, const uint16_t timeout) {
+	reset_read_stream_status();
+
+	rs232.transaction_response_length = response_length;
+	rs232.transaction_terminator = terminator;
+	rs232.transaction_timeout = timeout;
+	rs232.transaction_start = system_timer_get_ms();
+	rs232.transaction_rx_position = rs232.rb_rx.end;
+	rs232.transaction_rx_offset = ringbuffer_get_used(&rs232.rb_rx);
+	rs232.transaction_rx_received = 0;
+	rs232.transaction_state = TRANSACTION_STATE_WAIT_RESPONSE;
 }
 
-static void rs232_init_buffer(void) {
-	logd("[+] RS232-V2: rs232_init_buffer()\n\r");
+// Copies up to length bytes of the response, starting offset bytes into it.
+uint16_t rs232_transaction_response_get(uint8_t *data, const uint16_t offset, const uint16_t length) {
+	const Ringbuffer *const rb = &rs232.rb_rx;
+	uint16_t count = length;
 
-	// Initialize RS232 buffer.
-	memset(rs232.buffer, 0, RS232_BUFFER_SIZE);
+	if(offset >= rs232.transaction_rx_received) {
+		return 0;
+	}
 
-	// Ringbuffer initialization.
-	ringbuffer_init(&rs232.rb_rx, rs232.buffer_size_rx, &rs232.buffer[0]);
-	ringbuffer_init(&rs232.rb_tx,
-	                rs232.buffer_size_tx,
-	                &rs232.buffer[rs232.buffer_size_rx]);
-}
+	if(count > rs232.transaction_rx_received - offset) {
+		count = rs232.transaction_rx_received - offset;
+	}
 
-void rs232_apply_configuration() {
-	logd("[+] RS232-V2: rs232_apply_configuration()\n\r");
+	uint16_t position = (rb->start + rs232.transaction_rx_offset + offset) % rb->size;
+	for(uint16_t i = 0; i < count; i++) {
+		data[i] = rb->buffer[position];
 
-	// Turning off all events.
-	XMC_USIC_CH_RXFIFO_DisableEvent(
-		RS232_USIC,
-		XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE
-	);
-	XMC_USIC_CH_TXFIFO_DisableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
-	XMC_USIC_CH_DisableEvent(RS232_USIC, XMC_USIC_CH_EVENT_ALTERNATIVE_RECEIVE);
+		position++;
+		if(position >= rb->size) {
+			position = 0;
+		}
+	}
 
-	// Now we can configure the buffer and the hardware.
-	rs232_init_buffer();
-	rs232_init_hardware();
+	return count;
 }
 
-void reset_read_stream_status() {
-	rs232.read_stream_status.in_progress = false;
-	rs232.read_stream_status.stream_sent = 0;
-	rs232.read_stream_status.stream_chunk_offset = 0;
-	rs232.read_stream_status.stream_total_length = 0;
-	rs232.frame_readable_cb_already_sent = false;
+// Removes the response from the RX buffer, the bytes around it are kept for the read path.
+void rs232_transaction_done(void) {
+	rs232_rx_cut(rs232.transaction_rx_offset, rs232.transaction_rx_received);
+
+	rs232.transaction_rx_offset = 0;
+	rs232.transaction_rx_received = 0;
+	rs232.transaction_state = TRANSACTION_STATE_IDLE;
+	rs232_rx_drop_oldest_update();
 }
 
-void rs232_init() {
-	logd("[+] RS232-V2: rs232_init()\n\r");
+static void rs232_transaction_tick(void) {
+	if(rs232.transaction_state != TRANSACTION_STATE_WAIT_RESPONSE) {
+		return;
+	}
 
-	// Initialize RS232 default configuration.
-	rs232.baudrate = 115200;
-	rs232.parity = RS232_V2_PARITY_NONE;
-	rs232.stopbits = (uint8_t)RS232_V2_STOPBITS_1;
-	rs232.wordlength = (uint8_t)RS232_V2_WORDLENGTH_8;
-	rs232.flowcontrol = RS232_V2_FLOWCONTROL_OFF;
-	rs232.oversampling = 16;
+	const uint16_t end = rs232.rb_rx.end;
 
-	rs232._error_count_parity = 0;
-	rs232._error_count_overrun = 0;
-	rs232.error_count_parity = 0;
-	rs232.error_count_overrun = 0;
-	rs232.do_error_count_callback = false;
+	while(rs232.transaction_rx_position != end) {
+		const uint8_t data = rs232.rb_rx.buffer[rs232.transaction_rx_position];
 
-	rs232.read_callback_enabled = false;
-	rs232.frame_readable_cb_frame_size = 0;
+		rs232.transaction_rx_position = (rs232.transaction_rx_position + 1) % rs232.rb_rx.size;
+		rs232.transaction_rx_received++;
 
-	rs232.buffer_size_rx = RS232_BUFFER_SIZE / 2;
-	rs232.buffer_size_tx = RS232_BUFFER_SIZE / 2;
+		if((rs232.transaction_rx_received == rs232.transaction_response_length) ||
+		   (data == rs232.transaction_terminator)) {
+			rs232.transaction_status = RS232_V2_TRANSACTION_STATUS_COMPLETE;
+			rs232.transaction_state = TRANSACTION_STATE_RESPONSE_READY;
 
-	rs232.fc_sw_tx_xoff = false;
-	rs232.fc_sw_state_rx = FC_SW_STATE_RX_OK;
-	rs232.fc_sw_state_tx = FC_SW_STATE_TX_OK;
+			return;
+		}
+	}
 
-	reset_read_stream_status();
-	rs232_apply_configuration();
+	if(system_timer_is_time_elapsed_ms(rs232.transaction_start, rs232.transaction_timeout)) {
+		rs232.transaction_status = (rs232.transaction_rx_received == 0) ? RS232_V2_TRANSACTION_STATUS_TIMEOUT : RS232_V2_TRANSACTION_STATUS_PARTIAL;
+		rs232.transaction_state = TRANSACTION_STATE_RESPONSE_READY;
+	}
 }
 
 void rs232_tick() {
@@ -400,21 +2965,28 @@ void rs232_tick() {
 	 * 2. The interrupt is only triggered if more then 16 bytes
 	 *    are in the RX buffer, so we always read the end of
 	 *    a big message or messages <16 bytes here.
+	 *
+	 * This is not an interrupt, so we bypass the IRQ statistics.
 	 */
-	rs232_rx_irq_handler();
+	rs232_rx_irq_handler_variant();
+	rs232_rx_time_update();
+
+	// One timestamp for everything in this tick that measures time in us.
+	const uint32_t now = rs232_get_time_us();
+
+	rs232_statistics_tick(now);
+	rs232_baudrate_detection_tick();
+	rs232_reconfigure_tick();
+	rs232_buffer_pool_tick();
+	rs232_rx_drop_oldest_tick();
+	rs232_write_credit_tick();
+	rs232_frame_scan();
+	rs232_poll_tick();
+	rs232_transaction_tick();
 
 	// Manage flow control.
 	if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_SOFTWARE) {
-		if(rs232.fc_sw_tx_xoff) {
-			rs232.fc_sw_tx_xoff = false;
-
-			// TX XOFF.
-			ringbuffer_add(&rs232.rb_tx, FC_SW_XOFF);
-			XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
-			XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
-		}
-
-		if(rs232.fc_sw_state_tx == FC_SW_STATE_TX_OK) {
+		if((rs232.fc_sw_state_tx == FC_SW_STATE_TX_OK) || (rs232.fc_sw_tx_control != 0)) {
 			/*
 			 * Initiate TX.
 			 * There can be data in the TX buffer waiting to be TXed.
@@ -424,50 +2996,43 @@ void rs232_tick() {
 		}
 
 		if((rs232.fc_sw_state_rx == FC_SW_STATE_RX_WAIT) &&
-		   ((rs232.buffer_size_rx - ringbuffer_get_used(&rs232.rb_rx)) > FC_RB_RX_LIMIT)) {
-		      // We can RX data.
-		      rs232.fc_sw_state_rx = FC_SW_STATE_RX_OK;
-		}
-	}
-	else if(rs232.flowcontrol == RS232_V2_FLOWCONTROL_HARDWARE) {
-		if((rs232.buffer_size_rx - ringbuffer_get_used(&rs232.rb_rx)) > FC_RB_RX_LIMIT) {
-			// We can RX data.
-
-			/*
-			 * XMC_GPIO_SetOutputHigh(RS232_RTS_PIN);
-			 * |
-			 * | ---> RS232 logic 0.
-			 *
-			 * XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
-			 * |
-			 * | ---> RS232 logic 1.
-			 */
-
-			// Assert RTS pin.
-			XMC_GPIO_SetOutputLow(RS232_RTS_PIN);
-		}
-
-		/*
-		 * XMC_GPIO_GetInput(RS232_CTS_PIN);
-		 * |
-		 * | ---> Return = 0 = RS232 logic 1.
-		 * | ---> Return = 1 = RS232 logic 0.
-		 */
-		if(XMC_GPIO_GetInput(RS232_CTS_PIN) == 0) {
-			/*
-			 * Initiate TX.
-			 * There can be data in the TX buffer waiting to be TXed.
-			 */
+		   (ringbuffer_get_used(&rs232.rb_rx) <= rs232.fc_rx_resume_used)) {
+			// We can RX data again, TX XON from the TX interrupt.
+			NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RX);
+			NVIC_DisableIRQ((IRQn_Type)RS232_IRQ_RXA);
+			rs232.fc_sw_state_rx = FC_SW_STATE_RX_OK;
+			rs232.fc_sw_tx_control = FC_SW_XON;
+			NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RX);
+			NVIC_EnableIRQ((IRQn_Type)RS232_IRQ_RXA);
 			XMC_USIC_CH_TXFIFO_EnableEvent(RS232_USIC, XMC_USIC_CH_TXFIFO_EVENT_CONF_STANDARD);
 			XMC_USIC_CH_TriggerServiceRequest(RS232_USIC, RS232_SERVICE_REQUEST_TX);
 		}
 	}
 
+	/*
+	 * With hardware flow control RTS is handled in the RX interrupt handler
+	 * (called above) and TX on CTS assert is started by the CTS interrupt.
+	 */
+
+	rs232_fc_throttle_tick(now);
+
 	// Manage error count.
 	if((rs232.error_count_parity != rs232._error_count_parity) ||
 		 (rs232.error_count_overrun != rs232._error_count_overrun)) {
 				rs232.error_count_parity = rs232._error_count_parity;
 				rs232.error_count_overrun = rs232._error_count_overrun;
 				rs232.do_error_count_callback = true;
+				rs232.do_error_count_extended_callback = true;
+	}
+
+	if((rs232.error_count_framing != rs232._error_count_framing) ||
+		 (rs232.error_count_break != rs232._error_count_break) ||
+		 (rs232.error_count_noise != rs232._error_count_noise) ||
+		 (rs232.error_count_fifo_overflow != rs232._error_count_fifo_overflow)) {
+				rs232.error_count_framing = rs232._error_count_framing;
+				rs232.error_count_break = rs232._error_count_break;
+				rs232.error_count_noise = rs232._error_count_noise;
+				rs232.error_count_fifo_overflow = rs232._error_count_fifo_overflow;
+				rs232.do_error_count_extended_callback = true;
 	}
 }
@@ -39,11 +39,80 @@
 #define CONFIG_WORDLENGTH_MAX 8
 #define CONFIG_FLOWCONTROL_MAX 2
 
+// Oversampling range of the baudrate divider search. The majority decision
+// of three samples is used from RS232_OVERSAMPLING_MAJORITY_MIN on. Lower
+// oversampling is only used if the error with a higher one is above
+// RS232_BAUDRATE_ERROR_TARGET_PPM.
+#define RS232_OVERSAMPLING_MIN 4
+#define RS232_OVERSAMPLING_MAX 16
+#define RS232_OVERSAMPLING_MAJORITY_MIN 6
+#define RS232_BAUDRATE_ERROR_TARGET_PPM 2000
+
 #define FC_SW_XON 17
 #define FC_SW_XOFF 19
 
+// Minimum free RX buffer space before we stop the peer, regardless of the watermarks.
 #define FC_RB_RX_LIMIT 64
 
+// Flow control watermarks in percent of the RX buffer.
+#define FC_RX_HIGH_WATERMARK_DEFAULT 75
+#define FC_RX_LOW_WATERMARK_DEFAULT 50
+
+// Elastic buffer pool: a direction that is filled above this borrows from the other one.
+#define RS232_BUFFER_POOL_BORROW_PERCENT 50
+
+// With the drop-oldest RX overflow policy, the oldest bytes are dropped to keep this many bytes free for the RX interrupt.
+#define RS232_RX_DROP_OLDEST_FREE 128
+
+// A reconfiguration that could not be applied within this time (ms) is given up.
+#define RS232_RECONFIGURE_TIMEOUT 5000
+
+#define FRAME_DELIMITER_MAX_LENGTH 4
+#define FRAME_QUEUE_SIZE 32
+
+#define RX_TIMESTAMP_QUEUE_SIZE 32
+
+// rs232.rx_time_new, RX times taken by the RX interrupt that are not converted to us yet.
+#define RX_TIME_NEW_OLDEST (1 << 0)
+#define RX_TIME_NEW_NEWEST (1 << 1)
+
+#define POLL_TABLE_SIZE 8
+#define POLL_MESSAGE_MAX_LENGTH 48
+#define POLL_NONE 0xFF
+
+// The line is checked FRAME_GAP_CHECKS times per frame gap, but at most every 20us.
+#define FRAME_GAP_CHECKS 8
+#define FRAME_GAP_CHECK_MAX_HZ 50000
+
+// Baudrate detection: edge timestamps taken per run. The run ends early if at
+// least BAUDRATE_DETECTION_EDGES_MIN edges came in and the line is idle for
+// BAUDRATE_DETECTION_IDLE_BITS bit times.
+#define BAUDRATE_DETECTION_EDGES 32
+#define BAUDRATE_DETECTION_EDGES_MIN 8
+#define BAUDRATE_DETECTION_IDLE_BITS 30
+// A standard rate is used if it is within this tolerance of the measured rate.
+#define BAUDRATE_DETECTION_TOLERANCE_PERMILLE 20
+
+// Saved configuration in the emulated EEPROM of the bootloader, one 32 bit
+// word per position. The magic includes the layout version, a page with
+// another magic is ignored and the defaults are used.
+#define RS232_CONFIG_PAGE 1
+#define RS232_CONFIG_MAGIC 0x32335201
+#define RS232_CONFIG_MAGIC_POS 0
+#define RS232_CONFIG_BAUDRATE_POS 1
+#define RS232_CONFIG_FRAMING_POS 2     // parity, stopbits, wordlength, flowcontrol
+#define RS232_CONFIG_BUFFER_POS 3      // rx size, tx size
+#define RS232_CONFIG_WATERMARK_POS 4   // fc high, fc low
+#define RS232_CONFIG_CALLBACK_POS 5    // read cb, frame cb, rx timestamps, write credit value has to change, frame readable size
+#define RS232_CONFIG_COALESCING_MINIMUM_BYTES_POS 6
+#define RS232_CONFIG_COALESCING_MAXIMUM_LATENCY_POS 7
+#define RS232_CONFIG_DELIMITER_POS 8
+#define RS232_CONFIG_FRAME_POS 9       // delimiter length, gap length
+#define RS232_CONFIG_CRC_POS 10        // type, append tx, verify rx, drop invalid rx
+#define RS232_CONFIG_BUFFER_POOL_POS 11 // rx minimum, tx minimum, 0 = pool disabled
+#define RS232_CONFIG_RX_OVERFLOW_POS 12 // rx overflow policy
+#define RS232_CONFIG_WRITE_CREDIT_PERIOD_POS 13
+
 typedef enum {
 	FC_SW_STATE_RX_OK = 0,
 	FC_SW_STATE_RX_WAIT,
@@ -58,13 +127,88 @@ typedef struct {
 	uint16_t stream_total_length;
 } RS232ReadStreamStatus_t;
 
+typedef struct {
+	uint32_t first_byte;
+	uint32_t last_byte;
+} RS232RXTimestamp_t;
+
+typedef enum {
+	TRANSACTION_STATE_IDLE = 0,
+	TRANSACTION_STATE_WRITE,
+	TRANSACTION_STATE_WAIT_RESPONSE,
+	TRANSACTION_STATE_RESPONSE_READY
+} RS232TransactionState_t;
+
+typedef struct {
+	uint32_t period;
+	uint32_t next_send;
+	uint16_t response_length;
+	int16_t terminator;
+	uint8_t message_length;
+	uint8_t message[POLL_MESSAGE_MAX_LENGTH];
+} RS232PollEntry_t;
+
+typedef struct {
+	uint32_t count;
+	uint64_t cycles;
+	uint32_t cycles_max;
+} RS232IRQStatistics_t;
+
+typedef struct {
+	uint32_t window_start;
+	uint32_t loop_count;
+	uint32_t loop_per_second;
+	uint32_t loop_last;
+	uint32_t loop_period_max;
+
+	RS232IRQStatistics_t rx_irq;
+	RS232IRQStatistics_t tx_irq;
+
+	uint16_t rx_buffer_high_watermark;
+	uint16_t tx_buffer_high_watermark;
+
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint32_t rx_bytes_window_start;
+	uint32_t tx_bytes_window_start;
+	uint32_t rx_bytes_per_second;
+	uint32_t tx_bytes_per_second;
+
+	uint32_t callback_send_blocked;
+} RS232Statistics_t;
+
+typedef struct {
+	uint16_t step;
+	uint16_t pdiv;
+	uint8_t oversampling;
+	bool fractional;
+	uint32_t baudrate;  // Achieved baudrate.
+	int32_t error_ppm;
+} RS232BaudrateDivider_t;
+
 typedef struct {
 	uint32_t baudrate;
 	int parity;
 	uint8_t stopbits;
 	uint8_t wordlength;
 	int flowcontrol;
-	uint8_t oversampling;
+	uint16_t buffer_size_rx;
+	uint16_t buffer_size_tx;
+} RS232Configuration_t;
+
+typedef struct {
+	uint32_t baudrate;
+	int parity;
+	uint8_t stopbits;
+	uint8_t wordlength;
+	int flowcontrol;
+	RS232BaudrateDivider_t divider;
+
+	// Requested configuration, equal to the one above unless reconfigure_pending.
+	RS232Configuration_t reconfigure;
+	bool reconfigure_pending;
+	uint16_t reconfigure_tx_end; // TX is sent up to here with the old configuration.
+	uint32_t reconfigure_start;
 
 	uint32_t _error_count_parity;
 	uint32_t _error_count_overrun;
@@ -72,21 +216,125 @@ typedef struct {
 	uint32_t error_count_overrun;
 	bool do_error_count_callback;
 
+	uint32_t _error_count_framing;
+	uint32_t _error_count_break;
+	uint32_t _error_count_noise;
+	uint32_t _error_count_fifo_overflow;
+	uint32_t error_count_framing;
+	uint32_t error_count_break;
+	uint32_t error_count_noise;
+	uint32_t error_count_fifo_overflow;
+	bool do_error_count_extended_callback;
+
 	bool read_callback_enabled;
+	uint16_t read_callback_minimum_bytes;
+	uint32_t read_callback_maximum_latency;
+	uint32_t rx_oldest_us;
+
+	bool rx_timestamp_enabled;
+	uint32_t rx_newest_us;
+	uint32_t rx_oldest_cycles;
+	uint32_t rx_newest_cycles;
+	uint8_t rx_time_new;
+	uint16_t rx_timestamp_frame_fill;
+	uint32_t rx_timestamp_frame_first;
+	RS232RXTimestamp_t rx_timestamp[RX_TIMESTAMP_QUEUE_SIZE]; // In CPU cycles behind rx_timestamp_converted.
+	uint8_t rx_timestamp_first;
+	uint8_t rx_timestamp_count;
+	uint8_t rx_timestamp_converted;
 	uint16_t frame_readable_cb_frame_size;
 	bool frame_readable_cb_already_sent;
 
+	uint8_t frame_delimiter[FRAME_DELIMITER_MAX_LENGTH];
+	uint8_t frame_delimiter_fallback[FRAME_DELIMITER_MAX_LENGTH];
+	uint8_t frame_delimiter_length;
+	uint8_t frame_delimiter_matched;
+	uint16_t frame_scan_position;
+	uint16_t frame_end[FRAME_QUEUE_SIZE];
+	uint8_t frame_end_first;
+	uint8_t frame_end_count;
+	bool frame_available_cb_already_sent;
+	bool frame_callback_enabled;
+	RS232ReadStreamStatus_t read_frame_stream_status;
+
+	uint16_t frame_gap_length;
+	bool frame_gap_timer_running;
+	uint16_t frame_gap_position;
+	uint16_t frame_gap_last_end;
+	uint8_t frame_gap_idle;
+
 	Ringbuffer rb_rx;
 	Ringbuffer rb_tx;
 	uint8_t buffer[RS232_BUFFER_SIZE];
 	uint16_t buffer_size_rx;
 	uint16_t buffer_size_tx;
+	bool buffer_pool_enabled;
+	uint16_t buffer_pool_minimum_rx;
+	uint16_t buffer_pool_minimum_tx;
 
 	RS232ReadStreamStatus_t read_stream_status;
 
-	bool fc_sw_tx_xoff;
+	uint8_t rx_overflow_policy;
+	bool rx_drop_oldest_in_irq; // See rs232_rx_drop_oldest_update().
+	uint32_t rx_overflow_dropped_newest;
+	uint32_t rx_overflow_dropped_oldest;
+
+	uint32_t write_stream_received;
+	uint32_t write_stream_dropped;
+	uint32_t write_credit_period;
+	bool write_credit_value_has_to_change;
+	uint32_t write_credit_last_time;
+	uint32_t write_credit_last_received;
+	uint16_t write_credit_last_credit;
+	bool do_write_credit_callback;
+
+	RS232PollEntry_t poll[POLL_TABLE_SIZE];
+	uint8_t poll_active;
+	uint32_t poll_sent;
+	uint16_t poll_rx_position;
+	uint16_t poll_rx_received;
+
+	RS232TransactionState_t transaction_state;
+	uint16_t transaction_response_length;
+	int16_t transaction_terminator;
+	uint16_t transaction_timeout;
+	uint32_t transaction_start;
+	uint16_t transaction_rx_position;
+	uint16_t transaction_rx_offset;
+	uint16_t transaction_rx_received;
+	uint8_t transaction_status;
+
+	uint8_t crc_type;
+	bool crc_append_tx;
+	bool crc_verify_rx;
+	bool crc_drop_invalid_rx;
+	uint32_t crc_tx;
+	uint32_t error_count_crc;
+
+	uint8_t fc_sw_tx_control; // XON/XOFF to send ahead of the TX ringbuffer, 0 = none.
 	RS232SoftwareFlowControlState_t fc_sw_state_rx;
 	RS232SoftwareFlowControlState_t fc_sw_state_tx;
+	bool fc_hw_rx_wait;
+
+	uint8_t fc_rx_high_watermark;
+	uint8_t fc_rx_low_watermark;
+	uint16_t fc_rx_stop_free;
+	uint16_t fc_rx_resume_used;
+
+	uint32_t fc_throttle_last_us;
+	uint64_t fc_rx_throttled_us;
+	uint64_t fc_tx_throttled_us;
+
+	RS232Statistics_t statistics;
+
+	bool baudrate_detection_active;
+	uint16_t baudrate_detection_timeout;
+	uint32_t baudrate_detection_start;
+	volatile uint8_t baudrate_detection_edge_count;
+	uint32_t baudrate_detection_edges[BAUDRATE_DETECTION_EDGES];
+	uint32_t baudrate_detected;
+	uint32_t baudrate_measured;
+	bool do_baudrate_detected_callback;
 } RS232_t;
 
 extern RS232_t rs232;
@@ -95,5 +343,35 @@ void rs232_init(void);
 void rs232_tick(void);
 void rs232_apply_configuration(void);
 void reset_read_stream_status(void);
+uint32_t rs232_get_time_us(void);
+uint32_t rs232_get_time_cycles(void);
+void rs232_fc_set_watermarks(const uint8_t high, const uint8_t low);
+bool rs232_fc_is_rx_throttled(void);
+bool rs232_fc_is_tx_throttled(void);
+void rs232_statistics_reset(void);
+void rs232_baudrate_detection_start(const uint16_t timeout);
+bool rs232_configuration_is_valid(const RS232Configuration_t *config);
+void rs232_reconfigure(const RS232Configuration_t *config, const bool drain_tx);
+void rs232_buffer_pool_set(const bool enabled, const uint16_t minimum_rx, const uint16_t minimum_tx);
+void rs232_rx_overflow_set_policy(const uint8_t policy);
+void rs232_rx_drop_oldest_update(void);
+uint16_t rs232_write_credit(void);
+bool rs232_configuration_save(void);
+bool rs232_configuration_clear(void);
+void rs232_transaction_start(const uint16_t response_length, const int16_t terminator, const uint16_t timeout);
+uint16_t rs232_transaction_response_get(uint8_t *data, const uint16_t offset, const uint16_t length);
+void rs232_transaction_done(void);
+void rs232_poll_set_entry(const uint8_t index, const uint32_t period, const uint16_t response_length, const int16_t terminator, const uint8_t *message, const uint8_t message_length);
+void rs232_rx_time_update(void);
+void rs232_rx_timestamp_reset(void);
+uint8_t rs232_rx_timestamp_pop(RS232RXTimestamp_t *timestamp);
+void rs232_frame_reset(void);
+void rs232_frame_disable(void);
+bool rs232_frame_is_enabled(void);
+void rs232_frame_set_delimiter(const uint8_t *delimiter, const uint8_t length);
+void rs232_frame_set_gap(const uint16_t gap_length);
+uint16_t rs232_frame_pop(void);
+uint16_t rs232_ringbuffer_add_n(Ringbuffer *rb, const uint8_t *data, const uint16_t length);
+uint16_t rs232_ringbuffer_get_n(Ringbuffer *rb, uint8_t *data, const uint16_t length);
 
 #endif